@@ -0,0 +1,161 @@
+#include "common.hpp"
+
+#include <colite/sync/buffer_channel.hpp>
+#include <colite/sync/channel.hpp>
+
+#include <type_traits>
+
+namespace
+{
+    constexpr std::size_t lock_free_capacity = 1024;
+
+    template<class Backend>
+    auto make_channel() {
+        if constexpr (std::is_same_v<Backend, colite::mpmc::LockFree>) {
+            return colite::mpmc::channel<std::int64_t, Backend>(lock_free_capacity);
+        } else {
+            return colite::mpmc::channel<std::int64_t, Backend>();
+        }
+    }
+
+    template<class Backend>
+    void BM_channel_try_send_receive(benchmark::State &state) {
+        auto [sender, receiver] = make_channel<Backend>();
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            (void)sender.try_send(1);
+            benchmark::DoNotOptimize(receiver.try_receive());
+        }
+        state.SetItemsProcessed(state.iterations());
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_channel_try_send_receive, colite::mpmc::Unbounded);
+    BENCHMARK_TEMPLATE(BM_channel_try_send_receive, colite::mpmc::LockFree);
+
+    // A 64KB record per message, either in a freshly allocated `std::vector<char>` or in a pooled buffer.
+    constexpr std::size_t record_size = 64 * 1024;
+
+    void BM_channel_vector_records(benchmark::State &state) {
+        auto [sender, receiver] = colite::mpmc::channel<std::vector<char>>();
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            std::vector<char> record(record_size);
+            (void)sender.try_send(std::move(record));
+            benchmark::DoNotOptimize(receiver.try_receive());
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * record_size);
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK(BM_channel_vector_records);
+
+    void BM_channel_buffer_records(benchmark::State &state) {
+        auto [pool, sender, receiver] = colite::mpmc::buffer_channel(record_size);
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            (void)sender.try_send(pool.acquire());
+            benchmark::DoNotOptimize(receiver.try_receive());
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * record_size);
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK(BM_channel_buffer_records);
+
+    // Producers and consumers each run on their own thread and executor. Every message carries
+    // its send timestamp so the consumers can record the time spent in the channel.
+    //
+    // With `pinned` set producers are pinned to the lower half of the CPUs and consumers to the upper half, which on
+    // a two socket machine puts them on different sockets. This is where false sharing in the channel state shows.
+    //
+    // The `LockFree` variant uses a channel with room for `lock_free_capacity` values, so producers also wait for
+    // consumers once it fills up.
+    //
+    // With `for_each` set consumers use `colite::mpmc::for_each` instead of a `receive` loop.
+    template<class Backend>
+    void BM_channel_transfer(benchmark::State &state) {
+        constexpr std::int64_t messages_per_producer = 2000;
+        const auto producers = static_cast<int>(state.range(0));
+        const auto consumers = static_cast<int>(state.range(1));
+        const bool pinned = state.range(2) != 0;
+        const bool use_for_each = state.range(3) != 0;
+        const auto half = std::max(1u, std::thread::hardware_concurrency() / 2);
+        bench::latency_recorder latencies;
+
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            auto channel = make_channel<Backend>();
+            std::vector<std::thread> pool;
+
+            for (int p = 0; p < producers; p++) {
+                pool.emplace_back([sender = channel.sender, pinned, cpu = p % half]() mutable {
+                    if (pinned) {
+                        bench::pin_current_thread(cpu);
+                    }
+                    bench::loop_executor exec;
+                    auto run = [&]() -> bench::task {
+                        auto local = std::move(sender);
+                        for (std::int64_t i = 0; i < messages_per_producer; i++) {
+                            co_await local.send(exec, bench::now_ns());
+                        }
+                    };
+                    auto task = run();
+                    exec.run_until([&] { return task.is_done(); });
+                });
+            }
+            for (int c = 0; c < consumers; c++) {
+                pool.emplace_back([receiver = channel.receiver, &latencies, pinned, use_for_each, cpu = half + c % half]() mutable {
+                    if (pinned) {
+                        bench::pin_current_thread(cpu);
+                    }
+                    bench::loop_executor exec;
+                    std::vector<std::int64_t> samples;
+                    auto run = [&]() -> bench::task {
+                        if (use_for_each) {
+                            co_await colite::mpmc::for_each(exec, std::move(receiver), [&](std::int64_t sent) {
+                                samples.push_back(bench::now_ns() - sent);
+                            });
+                            co_return;
+                        }
+                        while (auto sent = co_await receiver.receive(exec)) {
+                            samples.push_back(bench::now_ns() - *sent);
+                        }
+                    };
+                    auto task = run();
+                    exec.run_until([&] { return task.is_done(); });
+                    latencies.add(samples);
+                });
+            }
+            {
+                // Drop the original ends so the channel closes once the producers are done.
+                auto drop = std::move(channel);
+            }
+            for (auto &thread : pool) {
+                thread.join();
+            }
+        }
+        auto items = state.iterations() * producers * messages_per_producer;
+        state.SetItemsProcessed(items);
+        latencies.report(state);
+        bench::report_allocations(state, allocations_before, items);
+    }
+
+    void transfer_args(benchmark::internal::Benchmark *b) {
+        // 1:1
+        b->Args({1, 1, 0, 0});
+        b->Args({1, 1, 1, 0});
+        b->Args({1, 1, 0, 1});
+        // N:1
+        for (int n = 2; n <= 64; n *= 2) {
+            b->Args({n, 1, 0, 0});
+            b->Args({n, 1, 0, 1});
+        }
+        // N:M
+        for (int n = 2; n <= 32; n *= 2) {
+            b->Args({n, n, 0, 0});
+            b->Args({n, n, 1, 0});
+        }
+    }
+    BENCHMARK_TEMPLATE(BM_channel_transfer, colite::mpmc::Unbounded)->Apply(transfer_args)->ArgNames({"producers", "consumers", "pinned", "for_each"})->UseRealTime()->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_channel_transfer, colite::mpmc::LockFree)->Apply(transfer_args)->ArgNames({"producers", "consumers", "pinned", "for_each"})->UseRealTime()->Unit(benchmark::kMillisecond);
+}// namespace
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <colite/executor/executor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace bench
+{
+    /**
+     * Number of heap allocations made by the process so far. Counted by the replacement
+     * `operator new` overloads in main.cpp, aligned ones included.
+     */
+    std::uint64_t allocations() noexcept;
+
+    /**
+     * A run-loop executor owned by a single thread. Any thread can post to it, only the owner runs it.
+     */
+    class loop_executor
+    {
+        struct state {
+            std::mutex mutex_;
+            std::condition_variable wakeup_;
+            std::deque<std::function<void()>> queue_;
+        };
+        std::shared_ptr<state> state_ = std::make_shared<state>();
+
+    public:
+        void execute(std::invocable auto fn) const {
+            {
+                std::scoped_lock lock{state_->mutex_};
+                state_->queue_.emplace_back(std::move(fn));
+            }
+            state_->wakeup_.notify_one();
+        }
+
+        // Run posted functions until `done` returns true.
+        template<class Pred>
+        void run_until(Pred &&done) const {
+            std::unique_lock lock{state_->mutex_};
+            while (!done()) {
+                if (state_->queue_.empty()) {
+                    state_->wakeup_.wait_for(lock, std::chrono::milliseconds(1));
+                    continue;
+                }
+                auto fn = std::move(state_->queue_.front());
+                state_->queue_.pop_front();
+                lock.unlock();
+                fn();
+                lock.lock();
+            }
+        }
+
+        friend bool operator==(const loop_executor &lhs, const loop_executor &rhs) noexcept {
+            return lhs.state_ == rhs.state_;
+        }
+    };
+
+    static_assert(colite::executor::Executor<loop_executor>);
+
+    /**
+     * Eagerly started coroutine that flags completion, enough to drive the primitives from a benchmark.
+     */
+    class task
+    {
+    public:
+        struct promise_type {
+            std::shared_ptr<std::atomic<bool>> done_ = std::make_shared<std::atomic<bool>>(false);
+
+            task get_return_object() {
+                return task{done_};
+            }
+            std::suspend_never initial_suspend() noexcept {
+                return {};
+            }
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+            void return_void() {
+                done_->store(true, std::memory_order_release);
+            }
+            void unhandled_exception() {
+                std::terminate();
+            }
+        };
+
+        [[nodiscard]] bool is_done() const noexcept {
+            return done_->load(std::memory_order_acquire);
+        }
+
+    private:
+        explicit task(std::shared_ptr<std::atomic<bool>> done) : done_(std::move(done)) {}
+        std::shared_ptr<std::atomic<bool>> done_;
+    };
+
+    /**
+     * Collects latency samples and reports them as p50/p99 counters in nanoseconds.
+     */
+    class latency_recorder
+    {
+        std::mutex mutex_;
+        std::vector<std::int64_t> samples_;
+
+    public:
+        void add(const std::vector<std::int64_t> &samples) {
+            std::scoped_lock lock{mutex_};
+            samples_.insert(samples_.end(), samples.begin(), samples.end());
+        }
+
+        void report(benchmark::State &state) {
+            std::scoped_lock lock{mutex_};
+            if (samples_.empty()) {
+                return;
+            }
+            auto percentile = [&](double p) {
+                auto index = static_cast<std::size_t>(p * static_cast<double>(samples_.size() - 1));
+                std::nth_element(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(index), samples_.end());
+                return static_cast<double>(samples_[index]);
+            };
+            state.counters["p50_ns"] = percentile(0.50);
+            state.counters["p99_ns"] = percentile(0.99);
+        }
+    };
+
+    /**
+     * Pin the calling thread to `cpu`, modulo the number of CPUs. Does nothing on platforms without thread affinity.
+     */
+    inline void pin_current_thread(unsigned cpu) noexcept {
+#if defined(__linux__)
+        auto cpus = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % cpus, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)cpu;
+#endif
+    }
+
+    inline std::int64_t now_ns() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Reports allocations per processed item, call once after the benchmark loop.
+     */
+    inline void report_allocations(benchmark::State &state, std::uint64_t allocations_before, std::int64_t items) {
+        if (items > 0) {
+            state.counters["allocs_per_op"] = static_cast<double>(allocations() - allocations_before) / static_cast<double>(items);
+        }
+    }
+}// namespace bench
@@ -0,0 +1,37 @@
+#include "common.hpp"
+
+#include <colite/executor/executor.hpp>
+#include <colite/task/yield.hpp>
+
+namespace
+{
+    template<class Exec>
+    void BM_execute(benchmark::State &state, Exec exec) {
+        std::int64_t counter = 0;
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            colite::executor::execute(exec, [&counter] { counter++; });
+            benchmark::DoNotOptimize(counter);
+        }
+        state.SetItemsProcessed(state.iterations());
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK_CAPTURE(BM_execute, direct, colite::executor::ImmediateExecutor{});
+    BENCHMARK_CAPTURE(BM_execute, any_executor, colite::executor::AnyExecutor(colite::executor::ImmediateExecutor{}));
+    BENCHMARK_CAPTURE(BM_execute, adapted, colite::executor::adapt([](std::function<void()> fn) { fn(); }));
+
+    void BM_yield_round_trip(benchmark::State &state) {
+        bench::loop_executor exec;
+        auto allocations_before = bench::allocations();
+        auto run = [&]() -> bench::task {
+            for (auto _ : state) {
+                co_await colite::task::yield(exec);
+            }
+        };
+        auto task = run();
+        exec.run_until([&] { return task.is_done(); });
+        state.SetItemsProcessed(state.iterations());
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK(BM_yield_round_trip);
+}// namespace
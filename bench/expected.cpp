@@ -0,0 +1,57 @@
+#include "common.hpp"
+
+#include <colite/expected.hpp>
+#include <colite/sync/channel.hpp>
+
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
+#include <cstdint>
+
+namespace
+{
+    struct colite_flavour {
+        using result = colite::Expected<std::int64_t, colite::mpmc::ReceiveError>;
+        static result error(colite::mpmc::ReceiveError error) {
+            return colite::Unexpected(error);
+        }
+    };
+
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+    struct std_flavour {
+        using result = std::expected<std::int64_t, colite::mpmc::ReceiveError>;
+        static result error(colite::mpmc::ReceiveError error) {
+            return std::unexpected(error);
+        }
+    };
+#endif
+
+    // Returned from a function the optimizer can't see through, like a receive result crossing a translation unit.
+    // Every 64th call fails, so both paths are exercised.
+    template<class Flavour>
+    [[gnu::noinline]] typename Flavour::result produce(std::int64_t i) {
+        if ((i & 63) == 63) {
+            return Flavour::error(colite::mpmc::ReceiveError::Closed);
+        }
+        return i;
+    }
+
+    template<class Flavour>
+    void BM_expected_return(benchmark::State &state) {
+        std::int64_t i = 0;
+        std::int64_t sum = 0;
+        for (auto _ : state) {
+            auto result = produce<Flavour>(i++);
+            if (result.has_value()) {
+                sum += *result;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_expected_return, colite_flavour);
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+    BENCHMARK_TEMPLATE(BM_expected_return, std_flavour);
+#endif
+}// namespace
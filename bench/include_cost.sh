@@ -0,0 +1,47 @@
+#!/bin/sh
+# Measures the compile time cost of including each colite header on its own.
+#
+# Usage: [STD=c++23] bench/include_cost.sh [compiler] [runs]
+#
+# Every header is compiled with -fsyntax-only in a translation unit that includes nothing else, `runs` times, and the
+# fastest run is reported in milliseconds. An empty translation unit is the baseline. `<expected>` is measured too when
+# the compiler has it in C++23 mode. `STD` selects the language standard for the colite headers (default c++20); with
+# c++23 and a standard library that has `std::expected`, `colite/expected.hpp` is just an alias of it.
+
+set -eu
+
+CXX=${1:-${CXX:-c++}}
+RUNS=${2:-5}
+STD=${STD:-c++20}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now_ms() {
+    date +%s%N | cut -b1-13
+}
+
+# measure <label> <std> <source line>
+measure() {
+    printf '%s\n' "$3" > "$WORK/tu.cpp"
+    best=
+    i=0
+    while [ "$i" -lt "$RUNS" ]; do
+        start=$(now_ms)
+        "$CXX" -std="$2" -fsyntax-only -I"$ROOT/include" "$WORK/tu.cpp" || return 0
+        elapsed=$(($(now_ms) - start))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+        i=$((i + 1))
+    done
+    printf '%-40s %6s ms\n' "$1" "$best"
+}
+
+measure "(empty)" "$STD" ""
+for header in $(cd "$ROOT/include" && find colite -name '*.hpp' | sort); do
+    measure "$header" "$STD" "#include <$header>"
+done
+if printf '#include <expected>\n' | "$CXX" -std=c++23 -fsyntax-only -x c++ - 2>/dev/null; then
+    measure "<expected> (c++23)" c++23 "#include <expected>"
+fi
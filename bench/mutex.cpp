@@ -0,0 +1,81 @@
+#include "common.hpp"
+
+#include <colite/sync/mutex.hpp>
+
+namespace
+{
+    void BM_mutex_try_lock(benchmark::State &state) {
+        colite::sync::Mutex<int> mutex(0);
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            auto guard = mutex.try_lock();
+            benchmark::DoNotOptimize(guard);
+        }
+        state.SetItemsProcessed(state.iterations());
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK(BM_mutex_try_lock);
+
+    void BM_mutex_lock_uncontended(benchmark::State &state) {
+        colite::sync::Mutex<int> mutex(0);
+        auto allocations_before = bench::allocations();
+        auto run = [&]() -> bench::task {
+            for (auto _ : state) {
+                auto guard = co_await mutex.lock(colite::executor::ImmediateExecutor{});
+                ++*guard;
+            }
+        };
+        auto task = run();
+        benchmark::DoNotOptimize(task.is_done());
+        state.SetItemsProcessed(state.iterations());
+        bench::report_allocations(state, allocations_before, state.iterations());
+    }
+    BENCHMARK(BM_mutex_lock_uncontended);
+
+    // Every thread runs its own executor and takes the lock `locks_per_thread` times.
+    template<class Policy, std::int64_t MaxSpinUs = 0>
+    void BM_mutex_lock_contended(benchmark::State &state) {
+        constexpr int locks_per_thread = 1000;
+        const auto threads = static_cast<int>(state.range(0));
+        colite::sync::Mutex<std::int64_t, Policy> mutex(0, std::chrono::microseconds(MaxSpinUs));
+        bench::latency_recorder latencies;
+
+        auto worker = [&]() {
+            bench::loop_executor exec;
+            std::vector<std::int64_t> samples;
+            samples.reserve(locks_per_thread);
+            auto run = [&]() -> bench::task {
+                for (int i = 0; i < locks_per_thread; i++) {
+                    auto start = bench::now_ns();
+                    auto guard = co_await mutex.lock(exec);
+                    samples.push_back(bench::now_ns() - start);
+                    ++*guard;
+                }
+            };
+            auto task = run();
+            exec.run_until([&] { return task.is_done(); });
+            latencies.add(samples);
+        };
+
+        auto allocations_before = bench::allocations();
+        for (auto _ : state) {
+            std::vector<std::thread> pool;
+            for (int t = 0; t < threads; t++) {
+                pool.emplace_back(worker);
+            }
+            for (auto &thread : pool) {
+                thread.join();
+            }
+        }
+        auto items = state.iterations() * threads * locks_per_thread;
+        state.SetItemsProcessed(items);
+        latencies.report(state);
+        bench::report_allocations(state, allocations_before, items);
+    }
+    BENCHMARK_TEMPLATE(BM_mutex_lock_contended, colite::sync::Fair)->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_mutex_lock_contended, colite::sync::Barging)->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_mutex_lock_contended, colite::sync::Adaptive<>)->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+    // Spinning for up to 50us before parking.
+    BENCHMARK_TEMPLATE(BM_mutex_lock_contended, colite::sync::Fair, 50)->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_mutex_lock_contended, colite::sync::Barging, 50)->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+}// namespace
@@ -3,14 +3,16 @@ from conans import ConanFile, CMake
 class colite(ConanFile):
     name = "colite"
     version = "0.0.1"
-    exports_sources = "include/*", "CMakeLists.txt", "tests/*"
+    exports_sources = "include/*", "CMakeLists.txt", "tests/*", "bench/*"
     no_copy_source = True
 
     options = {
-        "enable_testing": [True, False]
+        "enable_testing": [True, False],
+        "enable_benchmarks": [True, False]
     }
     default_options = {
-        "enable_testing": False
+        "enable_testing": False,
+        "enable_benchmarks": False
     }
     generators = "cmake"
 
@@ -19,6 +21,8 @@ class colite(ConanFile):
         if self.options.enable_testing == True:
             self.requires("gtest/cci.20210126")
             self.requires("folly/2021.05.31.00")
+        if self.options.enable_benchmarks == True:
+            self.requires("benchmark/1.5.3")
 
     def build(self):
         if self.options.enable_testing:
@@ -0,0 +1,176 @@
+#pragma once
+
+/**
+ * @file
+ * @brief A lock-free bounded multi-producer multi-consumer queue.
+ *
+ * This is Dmitry Vyukov's bounded MPMC queue. Every cell carries a sequence number that tells producers and consumers
+ * whether the cell is free to write or ready to read for the current lap around the ring, so a push or pop is one CAS
+ * on the shared position plus a release store on the cell. Pushing to a full queue and popping from an empty queue
+ * fail right away instead of waiting.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+#include <colite/detail/cache_line.hpp>
+#include <colite/instrument.hpp>
+
+namespace colite::detail {
+    template<class T>
+    class bounded_queue {
+        static_assert(std::is_nothrow_move_constructible_v<T>, "values are moved into claimed cells, which can't be undone");
+
+        struct cell {
+            std::atomic<std::size_t> sequence_;
+            alignas(T) unsigned char storage_[sizeof(T)];
+            [[no_unique_address]] instrument::Stopwatch enqueued_;
+        };
+
+        std::unique_ptr<cell[]> buffer_;
+        std::size_t mask_;
+
+        // Producers and consumers each own a position, keep them on separate cache lines.
+        alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos_{0};
+#ifdef COLITE_INSTRUMENT
+        std::atomic<std::size_t> high_water_mark_{0};
+#endif
+        alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos_{0};
+        [[no_unique_address]] instrument::HistogramCounters time_in_queue_;
+
+        static std::size_t round_up_capacity(std::size_t capacity) noexcept {
+            std::size_t retval = 2;
+            while (retval < capacity) {
+                retval <<= 1;
+            }
+            return retval;
+        }
+
+        static T *value_of(cell &c) noexcept {
+            return std::launder(reinterpret_cast<T *>(c.storage_));
+        }
+
+    public:
+        static constexpr bool lock_free = true;
+
+        /**
+         * @brief Create a queue holding at least `capacity` values, rounded up to a power of two.
+         */
+        explicit bounded_queue(std::size_t capacity)
+            : buffer_(std::make_unique<cell[]>(round_up_capacity(capacity))), mask_(round_up_capacity(capacity) - 1) {
+            for (std::size_t i = 0; i <= mask_; i++) {
+                buffer_[i].sequence_.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bounded_queue(const bounded_queue &) = delete;
+        bounded_queue &operator=(const bounded_queue &) = delete;
+
+        ~bounded_queue() {
+            while (try_pop()) {
+            }
+        }
+
+        /**
+         * @brief Push a value unless the queue is full. `value` is only moved from if the push succeeds.
+         */
+        bool try_push(T &value) noexcept {
+            cell *c;
+            auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                c = &buffer_[pos & mask_];
+                auto seq = c->sequence_.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+            ::new (static_cast<void *>(c->storage_)) T(std::move(value));
+            c->enqueued_.start();
+            c->sequence_.store(pos + 1, std::memory_order_release);
+#ifdef COLITE_INSTRUMENT
+            auto depth = this->depth();
+            auto max = high_water_mark_.load(std::memory_order_relaxed);
+            while (max < depth && !high_water_mark_.compare_exchange_weak(max, depth, std::memory_order_relaxed)) {
+            }
+#endif
+            return true;
+        }
+
+        /**
+         * @brief Pop the oldest value, or return an empty optional if the queue is empty.
+         */
+        std::optional<T> try_pop() noexcept {
+            cell *c;
+            auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                c = &buffer_[pos & mask_];
+                auto seq = c->sequence_.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return std::nullopt;
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+            auto *value = value_of(*c);
+            std::optional<T> retval(std::move(*value));
+            value->~T();
+            time_in_queue_.record(c->enqueued_.elapsed_ns());
+            c->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+            return retval;
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+        // The remaining functions are snapshots that may be slightly off while pushes and pops are in progress.
+
+        [[nodiscard]] bool empty() const noexcept {
+            return depth() == 0;
+        }
+
+        [[nodiscard]] std::size_t depth() const noexcept {
+            auto received = dequeue_pos_.load(std::memory_order_relaxed);
+            auto sent = enqueue_pos_.load(std::memory_order_relaxed);
+            return sent > received ? sent - received : 0;
+        }
+
+        [[nodiscard]] std::uint64_t sent() const noexcept {
+            return enqueue_pos_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::uint64_t received() const noexcept {
+            return dequeue_pos_.load(std::memory_order_relaxed);
+        }
+
+        // Only tracked when `COLITE_INSTRUMENT` is defined, it costs a read of the consumer position on every push.
+        [[nodiscard]] std::size_t high_water_mark() const noexcept {
+#ifdef COLITE_INSTRUMENT
+            return high_water_mark_.load(std::memory_order_relaxed);
+#else
+            return 0;
+#endif
+        }
+
+        [[nodiscard]] instrument::Histogram time_in_queue() const noexcept {
+            return time_in_queue_.snapshot();
+        }
+    };
+}// namespace colite::detail
@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * @file
+ * @brief The cache line size used to keep independently written data apart.
+ */
+
+#include <cstddef>
+#include <new>
+
+namespace colite::detail {
+    /**
+     * @brief Minimum offset between two objects to avoid false sharing.
+     *
+     * GCC warns about using `std::hardware_destructive_interference_size` in headers since its value may change
+     * between compiler versions and flags, which would silently change the layout of every type using it. A fixed
+     * value is used with GCC instead.
+     */
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+    inline constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#elif defined(__aarch64__) && defined(__APPLE__)
+    inline constexpr std::size_t cache_line_size = 128;
+#else
+    inline constexpr std::size_t cache_line_size = 64;
+#endif
+}// namespace colite::detail
@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * @file
+ * @brief A hint to the CPU that the calling thread is spin-waiting.
+ */
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64))
+#include <intrin.h>
+#elif !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__) && !defined(__arm__)
+#include <thread>
+#endif
+
+namespace colite::detail {
+    /**
+     * One iteration of a spin loop: `pause` on x86 and `yield` on ARM, which let a sibling hyper-thread run and avoid
+     * the memory order mis-speculation penalty when the loop exits. Elsewhere the thread yields to the scheduler.
+     */
+    inline void cpu_relax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+        __yield();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::this_thread::yield();
+#endif
+    }
+}// namespace colite::detail
@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+ * @file
+ * @brief A minimal intrusive doubly linked list used for waiter queues.
+ *
+ * Nodes derive from `intrusive_list_hook<Node>` and are linked and unlinked in O(1) without any allocation.
+ * The list never owns its nodes, and it performs no synchronization of its own.
+ */
+
+#include <cstddef>
+
+namespace colite::detail {
+    template<class Node>
+    struct intrusive_list_hook {
+        Node *prev_ = nullptr;
+        Node *next_ = nullptr;
+        bool linked_ = false;
+    };
+
+    template<class Node>
+    class intrusive_list {
+        Node *head_ = nullptr;
+        Node *tail_ = nullptr;
+        std::size_t size_ = 0;
+
+        static intrusive_list_hook<Node> &hook(Node &node) noexcept {
+            return static_cast<intrusive_list_hook<Node> &>(node);
+        }
+
+    public:
+        [[nodiscard]] bool empty() const noexcept {
+            return head_ == nullptr;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return size_;
+        }
+
+        [[nodiscard]] Node *front() const noexcept {
+            return head_;
+        }
+
+        [[nodiscard]] Node *back() const noexcept {
+            return tail_;
+        }
+
+        void push_back(Node &node) noexcept {
+            auto &h = hook(node);
+            h.prev_ = tail_;
+            h.next_ = nullptr;
+            if (tail_) {
+                hook(*tail_).next_ = &node;
+            } else {
+                head_ = &node;
+            }
+            tail_ = &node;
+            h.linked_ = true;
+            size_++;
+        }
+
+        /**
+         * Link `node` in front of `pos`, or at the back if `pos` is null.
+         */
+        void insert_before(Node *pos, Node &node) noexcept {
+            if (!pos) {
+                push_back(node);
+                return;
+            }
+            auto &h = hook(node);
+            auto &pos_hook = hook(*pos);
+            h.prev_ = pos_hook.prev_;
+            h.next_ = pos;
+            if (pos_hook.prev_) {
+                hook(*pos_hook.prev_).next_ = &node;
+            } else {
+                head_ = &node;
+            }
+            pos_hook.prev_ = &node;
+            h.linked_ = true;
+            size_++;
+        }
+
+        /**
+         * Unlink `node`, which must be linked into this list.
+         */
+        void erase(Node &node) noexcept {
+            auto &h = hook(node);
+            if (h.prev_) {
+                hook(*h.prev_).next_ = h.next_;
+            } else {
+                head_ = h.next_;
+            }
+            if (h.next_) {
+                hook(*h.next_).prev_ = h.prev_;
+            } else {
+                tail_ = h.prev_;
+            }
+            h.prev_ = h.next_ = nullptr;
+            h.linked_ = false;
+            size_--;
+        }
+
+        Node *pop_front() noexcept {
+            auto *node = head_;
+            if (node) {
+                erase(*node);
+            }
+            return node;
+        }
+
+        template<class Fn>
+        void for_each(Fn &&fn) const {
+            for (auto *node = head_; node; node = hook(*node).next_) {
+                fn(*node);
+            }
+        }
+    };
+}// namespace colite::detail
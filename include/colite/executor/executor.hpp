@@ -39,6 +39,7 @@
  * ```
  */
 
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 #include <concepts>
@@ -246,6 +247,40 @@ namespace colite::executor
 
     static_assert(Executor<AnyExecutor>, "any Executor");
 
+    namespace detail
+    {
+        // Whether storing an `F` in a `std::function` allocates, following the small buffer rules of the standard library.
+        template<class F>
+        inline constexpr bool function_allocates =
+#if defined(__GLIBCXX__)
+            !(std::is_trivially_copyable_v<F> && sizeof(F) <= 2 * sizeof(void *) && alignof(F) <= alignof(void *));
+#elif defined(_LIBCPP_VERSION)
+            !(std::is_nothrow_copy_constructible_v<F> && sizeof(F) <= 3 * sizeof(void *) && alignof(F) <= alignof(void *));
+#else
+            true;
+#endif
+
+        template<>
+        inline constexpr bool function_allocates<std::function<void()>> = false;
+
+        /**
+         * Heap allocations made by constructing an `AnyExecutor` from an `Exec`: none when an `AnyExecutor` is moved,
+         * one for a copy or for wrapping any other executor.
+         */
+        template<class Exec>
+        inline constexpr std::size_t any_executor_allocations =
+            std::is_same_v<Exec, AnyExecutor> || std::is_same_v<Exec, AnyExecutor &&> ? 0 : 1;
+
+        /**
+         * Heap allocations made by `execute(exec, f)` before the executor gets the function: one when `Exec` is an
+         * `AnyExecutor` and `F` doesn't fit the small buffer of the `std::function` it is wrapped in. What the
+         * executor itself allocates to queue the function isn't included.
+         */
+        template<class Exec, class F>
+        inline constexpr std::size_t execute_allocations =
+            std::is_same_v<std::remove_cvref_t<Exec>, AnyExecutor> && function_allocates<std::remove_cvref_t<F>> ? 1 : 0;
+    }
+
     /**
      * @brief Adapt an invocable object to be an Executor. The invocable object must be invocable with `std::function<void()>` arguments
      * @tparam Fn The object to adapt to an Executor
@@ -1,2326 +1,972 @@
-///
-// Expected - An implementation of std::Expected with extensions
-// Written in 2017 by Simon Brand (simonrbrand@gmail.com, @TartanLlama)
-//
-// Documentation available at http://tl.tartanllama.xyz/
-//
-// To the extent possible under law, the author(s) have dedicated all
-// copyright and related and neighboring rights to this software to the
-// public domain worldwide. This software is distributed without any warranty.
-//
-// You should have received a copy of the CC0 Public Domain Dedication
-// along with this software. If not, see
-// <http://creativecommons.org/publicdomain/zero/1.0/>.
-///
-
-#ifndef COLITE_EXPECTED_HPP
-#define COLITE_EXPECTED_HPP
-
-#define COLITE_EXPECTED_VERSION_MAJOR 1
-#define COLITE_EXPECTED_VERSION_MINOR 0
-#define COLITE_EXPECTED_VERSION_PATCH 1
+#pragma once
 
-#include <exception>
-#include <functional>
-#include <type_traits>
-#include <utility>
-
-#if defined(__EXCEPTIONS) || defined(_CPPUNWIND)
-#define COLITE_EXPECTED_EXCEPTIONS_ENABLED
-#endif
+/**
+ * @file
+ * @brief `colite::Expected<T, E>`, a value or an error.
+ *
+ * When the standard library has C++23 `std::expected`, `colite::Expected` and `colite::Unexpected` are aliases of
+ * `std::expected` and `std::unexpected`. Otherwise they are the small implementation below, which has the same
+ * interface: `has_value()`, `value()`, `error()`, `value_or()`, `emplace()`, `and_then()`, `or_else()`, `transform()`
+ * and `transform_error()`.
+ *
+ * Define `COLITE_NO_STD_EXPECTED` to always use the fallback.
+ *
+ * In both cases an `Expected` of trivially copyable types is itself trivially copyable, so a small result like
+ * `Expected<std::int64_t, ReceiveError>` is returned in registers.
+ */
 
-#if (defined(_MSC_VER) && _MSC_VER == 1900)
-#define COLITE_EXPECTED_MSVC2015
-#define COLITE_EXPECTED_MSVC2015_CONSTEXPR
-#else
-#define COLITE_EXPECTED_MSVC2015_CONSTEXPR constexpr
-#endif
+#include <version>
 
-#if (defined(__GNUC__) && __GNUC__ == 4 && __GNUC_MINOR__ <= 9 &&              \
-     !defined(__clang__))
-#define COLITE_EXPECTED_GCC49
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202211L && defined(__cpp_deduction_guides) &&               \
+    __cpp_deduction_guides >= 201907L && !defined(COLITE_NO_STD_EXPECTED)
+#define COLITE_STD_EXPECTED
 #endif
 
-#if (defined(__GNUC__) && __GNUC__ == 5 && __GNUC_MINOR__ <= 4 &&              \
-     !defined(__clang__))
-#define COLITE_EXPECTED_GCC54
-#endif
+#ifdef COLITE_STD_EXPECTED
 
-#if (defined(__GNUC__) && __GNUC__ == 5 && __GNUC_MINOR__ <= 5 &&              \
-     !defined(__clang__))
-#define COLITE_EXPECTED_GCC55
-#endif
+#include <expected>
+#include <utility>
 
-#if (defined(__GNUC__) && __GNUC__ == 4 && __GNUC_MINOR__ <= 9 &&              \
-     !defined(__clang__))
-// GCC < 5 doesn't support overloading on const&& for member functions
-
-#define COLITE_EXPECTED_NO_CONSTRR
-// GCC < 5 doesn't support some standard C++11 type traits
-#define COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(T)                         \
-  std::has_trivial_copy_constructor<T>
-#define COLITE_EXPECTED_IS_TRIVIALLY_COPY_ASSIGNABLE(T)                            \
-  std::has_trivial_copy_assign<T>
-
-// This one will be different for GCC 5.7 if it's ever supported
-#define COLITE_EXPECTED_IS_TRIVIALLY_DESTRUCTIBLE(T)                               \
-  std::is_trivially_destructible<T>
-
-// GCC 5 < v < 8 has a bug in is_trivially_copy_constructible which breaks std::vector
-// for non-copyable types
-#elif (defined(__GNUC__) && __GNUC__ < 8 &&                                                \
-     !defined(__clang__))
-#ifndef COLITE_GCC_LESS_8_TRIVIALLY_COPY_CONSTRUCTIBLE_MUTEX
-#define COLITE_GCC_LESS_8_TRIVIALLY_COPY_CONSTRUCTIBLE_MUTEX
 namespace colite {
-  namespace detail {
-      template<class T>
-      struct is_trivially_copy_constructible : std::is_trivially_copy_constructible<T>{};
-#ifdef _GLIBCXX_VECTOR
-      template<class T, class A>
-      struct is_trivially_copy_constructible<std::vector<T,A>>
-          : std::false_type{};
-#endif
-  }
-}
-#endif
+    template<class T, class E>
+    using Expected = std::expected<T, E>;
 
-#define COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(T)                                     \
-  colite::detail::is_trivially_copy_constructible<T>
-#define COLITE_EXPECTED_IS_TRIVIALLY_COPY_ASSIGNABLE(T)                                        \
-  std::is_trivially_copy_assignable<T>
-#define COLITE_EXPECTED_IS_TRIVIALLY_DESTRUCTIBLE(T) std::is_trivially_destructible<T>
-#else
-#define COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(T)                         \
-  std::is_trivially_copy_constructible<T>
-#define COLITE_EXPECTED_IS_TRIVIALLY_COPY_ASSIGNABLE(T)                            \
-  std::is_trivially_copy_assignable<T>
-#define COLITE_EXPECTED_IS_TRIVIALLY_DESTRUCTIBLE(T)                               \
-  std::is_trivially_destructible<T>
-#endif
+    template<class E>
+    using Unexpected = std::unexpected<E>;
 
-#if __cplusplus > 201103L
-#define COLITE_EXPECTED_CXX14
-#endif
+    template<class E>
+    using bad_expected_access = std::bad_expected_access<E>;
 
-#ifdef COLITE_EXPECTED_GCC49
-#define COLITE_EXPECTED_GCC49_CONSTEXPR
-#else
-#define COLITE_EXPECTED_GCC49_CONSTEXPR constexpr
-#endif
+    using std::in_place;
+    using std::in_place_t;
+    using std::unexpect;
+    using std::unexpect_t;
+}// namespace colite
 
-#if (__cplusplus == 201103L || defined(COLITE_EXPECTED_MSVC2015) ||                \
-     defined(COLITE_EXPECTED_GCC49))
-#define COLITE_EXPECTED_11_CONSTEXPR
 #else
-#define COLITE_EXPECTED_11_CONSTEXPR constexpr
-#endif
+
+#include <concepts>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace colite {
-    template <class T, class E> class Expected;
+    using std::in_place;
+    using std::in_place_t;
+
+    struct unexpect_t {
+        explicit unexpect_t() = default;
+    };
+    inline constexpr unexpect_t unexpect{};
 
-#ifndef COLITE_MONOSTATE_INPLACE_MUTEX
-#define COLITE_MONOSTATE_INPLACE_MUTEX
-    class monostate {};
+    template<class T, class E>
+    class Expected;
 
-    struct in_place_t {
-        explicit in_place_t() = default;
+    template<class E>
+    class bad_expected_access;
+
+    template<>
+    class bad_expected_access<void>: public std::exception {
+    public:
+        [[nodiscard]] const char *what() const noexcept override {
+            return "bad access to colite::Expected without a value";
+        }
     };
-    static constexpr in_place_t in_place{};
-#endif
 
-template <class E> class Unexpected {
-public:
-    static_assert(!std::is_same<E, void>::value, "E must not be void");
-
-    Unexpected() = delete;
-    constexpr explicit Unexpected(const E &e) : m_val(e) {}
-
-    constexpr explicit Unexpected(E &&e) : m_val(std::move(e)) {}
-
-    constexpr const E &value() const & { return m_val; }
-    COLITE_EXPECTED_11_CONSTEXPR E &value() & { return m_val; }
-    COLITE_EXPECTED_11_CONSTEXPR E &&value() && { return std::move(m_val); }
-    constexpr const E &&value() const && { return std::move(m_val); }
-
-private:
-    E m_val;
-};
-
-template <class E>
-constexpr bool operator==(const Unexpected<E> &lhs, const Unexpected<E> &rhs) {
-    return lhs.value() == rhs.value();
-}
-template <class E>
-constexpr bool operator!=(const Unexpected<E> &lhs, const Unexpected<E> &rhs) {
-    return lhs.value() != rhs.value();
-}
-template <class E>
-constexpr bool operator<(const Unexpected<E> &lhs, const Unexpected<E> &rhs) {
-    return lhs.value() < rhs.value();
-}
-template <class E>
-constexpr bool operator<=(const Unexpected<E> &lhs, const Unexpected<E> &rhs) {
-    return lhs.value() <= rhs.value();
-}
-template <class E>
-constexpr bool operator>(const Unexpected<E> &lhs, const Unexpected<E> &rhs) {
-    return lhs.value() > rhs.value();
-}
-template <class E>
-constexpr bool operator>=(const Unexpected<E> &lhs, const Unexpected<E> &rhs) {
-    return lhs.value() >= rhs.value();
-}
-
-template <class E>
-Unexpected<typename std::decay<E>::type> make_unexpected(E &&e) {
-    return Unexpected<typename std::decay<E>::type>(std::forward<E>(e));
-}
-
-struct unexpect_t {
-    unexpect_t() = default;
-};
-static constexpr unexpect_t unexpect{};
-
-namespace detail {
-    template<typename E>
-    [[noreturn]] COLITE_EXPECTED_11_CONSTEXPR void throw_exception(E &&e) {
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-        throw std::forward<E>(e);
-#else
-#ifdef _MSC_VER
-        __assume(0);
-#else
-        __builtin_unreachable();
-#endif
-#endif
-    }
-
-#ifndef COLITE_TRAITS_MUTEX
-#define COLITE_TRAITS_MUTEX
-// C++14-style aliases for brevity
-    template <class T> using remove_const_t = typename std::remove_const<T>::type;
-    template <class T>
-    using remove_reference_t = typename std::remove_reference<T>::type;
-    template <class T> using decay_t = typename std::decay<T>::type;
-    template <bool E, class T = void>
-    using enable_if_t = typename std::enable_if<E, T>::type;
-    template <bool B, class T, class F>
-    using conditional_t = typename std::conditional<B, T, F>::type;
-
-// std::conjunction from C++17
-    template <class...> struct conjunction : std::true_type {};
-    template <class B> struct conjunction<B> : B {};
-    template <class B, class... Bs>
-    struct conjunction<B, Bs...>
-        : std::conditional<bool(B::value), conjunction<Bs...>, B>::type {};
-
-#if defined(_LIBCPP_VERSION) && __cplusplus == 201103L
-#define COLITE_TRAITS_LIBCXX_MEM_FN_WORKAROUND
-#endif
+    template<class E>
+    class bad_expected_access: public bad_expected_access<void> {
+        E error_;
 
-// In C++11 mode, there's an issue in libc++'s std::mem_fn
-// which results in a hard-error when using it in a noexcept expression
-// in some cases. This is a check to workaround the common failing case.
-#ifdef COLITE_TRAITS_LIBCXX_MEM_FN_WORKAROUND
-    template <class T> struct is_pointer_to_non_const_member_func : std::false_type {};
-template <class T, class Ret, class... Args>
-struct is_pointer_to_non_const_member_func<Ret(T::*) (Args...)> : std::true_type {};
-template <class T, class Ret, class... Args>
-struct is_pointer_to_non_const_member_func<Ret(T::*) (Args...)&> : std::true_type {};
-template <class T, class Ret, class... Args>
-struct is_pointer_to_non_const_member_func<Ret(T::*) (Args...) &&> : std::true_type {};
-template <class T, class Ret, class... Args>
-struct is_pointer_to_non_const_member_func<Ret(T::*) (Args...) volatile> : std::true_type {};
-template <class T, class Ret, class... Args>
-struct is_pointer_to_non_const_member_func<Ret(T::*) (Args...) volatile &> : std::true_type {};
-template <class T, class Ret, class... Args>
-struct is_pointer_to_non_const_member_func<Ret(T::*) (Args...) volatile &&> : std::true_type {};
-
-template <class T> struct is_const_or_const_ref : std::false_type {};
-template <class T> struct is_const_or_const_ref<T const&> : std::true_type {};
-template <class T> struct is_const_or_const_ref<T const> : std::true_type {};
-#endif
+    public:
+        explicit bad_expected_access(E e) : error_(std::move(e)) {}
 
-// std::invoke from C++17
-// https://stackoverflow.com/questions/38288042/c11-14-invoke-workaround
-    template <typename Fn, typename... Args,
-#ifdef COLITE_TRAITS_LIBCXX_MEM_FN_WORKAROUND
-        typename = enable_if_t<!(is_pointer_to_non_const_member_func<Fn>::value
-    && is_const_or_const_ref<Args...>::value)>,
-#endif
-        typename = enable_if_t<std::is_member_pointer<decay_t<Fn>>::value>,
-        int = 0>
-    constexpr auto invoke(Fn && f, Args && ... args) noexcept(
-    noexcept(std::mem_fn(f)(std::forward<Args>(args)...)))
-    -> decltype(std::mem_fn(f)(std::forward<Args>(args)...)) {
-        return std::mem_fn(f)(std::forward<Args>(args)...);
-    }
-
-    template <typename Fn, typename... Args,
-        typename = enable_if_t<!std::is_member_pointer<decay_t<Fn>>::value>>
-    constexpr auto invoke(Fn && f, Args && ... args) noexcept(
-    noexcept(std::forward<Fn>(f)(std::forward<Args>(args)...)))
-    -> decltype(std::forward<Fn>(f)(std::forward<Args>(args)...)) {
-        return std::forward<Fn>(f)(std::forward<Args>(args)...);
-    }
-
-// std::invoke_result from C++17
-    template <class F, class, class... Us> struct invoke_result_impl;
-
-    template <class F, class... Us>
-    struct invoke_result_impl<
-        F, decltype(detail::invoke(std::declval<F>(), std::declval<Us>()...), void()),
-        Us...> {
-        using type = decltype(detail::invoke(std::declval<F>(), std::declval<Us>()...));
+        [[nodiscard]] const E &error() const & noexcept {
+            return error_;
+        }
+        [[nodiscard]] E &error() & noexcept {
+            return error_;
+        }
+        [[nodiscard]] const E &&error() const && noexcept {
+            return std::move(error_);
+        }
+        [[nodiscard]] E &&error() && noexcept {
+            return std::move(error_);
+        }
     };
 
-    template <class F, class... Us>
-    using invoke_result = invoke_result_impl<F, void, Us...>;
+    /**
+     * @brief The error of an `Expected`, used to construct or assign one that holds an error.
+     */
+    template<class E>
+    class Unexpected {
+        E error_;
 
-    template <class F, class... Us>
-    using invoke_result_t = typename invoke_result<F, Us...>::type;
+    public:
+        constexpr Unexpected(const Unexpected &) = default;
+        constexpr Unexpected(Unexpected &&) = default;
 
-#if defined(_MSC_VER) && _MSC_VER <= 1900
-    // TODO make a version which works with MSVC 2015
-template <class T, class U = T> struct is_swappable : std::true_type {};
+        template<class G = E>
+            requires(!std::same_as<std::remove_cvref_t<G>, Unexpected> && !std::same_as<std::remove_cvref_t<G>, in_place_t> && std::is_constructible_v<E, G>)
+        constexpr explicit Unexpected(G &&e) : error_(std::forward<G>(e)) {}
 
-template <class T, class U = T> struct is_nothrow_swappable : std::true_type {};
-#else
-// https://stackoverflow.com/questions/26744589/what-is-a-proper-way-to-implement-is-swappable-to-test-for-the-swappable-concept
-    namespace swap_adl_tests {
-        // if swap ADL finds this then it would call std::swap otherwise (same
-        // signature)
-        struct tag {};
-
-        template <class T> tag swap(T&, T&);
-        template <class T, std::size_t N> tag swap(T(&a)[N], T(&b)[N]);
-
-        // helper functions to test if an unqualified swap is possible, and if it
-        // becomes std::swap
-        template <class, class> std::false_type can_swap(...) noexcept(false);
-        template <class T, class U,
-            class = decltype(swap(std::declval<T&>(), std::declval<U&>()))>
-        std::true_type can_swap(int) noexcept(noexcept(swap(std::declval<T&>(),
-                                                            std::declval<U&>())));
-
-        template <class, class> std::false_type uses_std(...);
-        template <class T, class U>
-        std::is_same<decltype(swap(std::declval<T&>(), std::declval<U&>())), tag>
-        uses_std(int);
-
-        template <class T>
-        struct is_std_swap_noexcept
-            : std::integral_constant<bool,
-                                     std::is_nothrow_move_constructible<T>::value&&
-                                         std::is_nothrow_move_assignable<T>::value> {};
-
-        template <class T, std::size_t N>
-        struct is_std_swap_noexcept<T[N]> : is_std_swap_noexcept<T> {};
-
-        template <class T, class U>
-        struct is_adl_swap_noexcept
-            : std::integral_constant<bool, noexcept(can_swap<T, U>(0))> {};
-    } // namespace swap_adl_tests
-
-    template <class T, class U = T>
-    struct is_swappable
-        : std::integral_constant<
-            bool,
-        decltype(detail::swap_adl_tests::can_swap<T, U>(0))::value &&
-    (!decltype(detail::swap_adl_tests::uses_std<T, U>(0))::value ||
-    (std::is_move_assignable<T>::value &&
-        std::is_move_constructible<T>::value))> {};
-
-template <class T, std::size_t N>
-struct is_swappable<T[N], T[N]>
-    : std::integral_constant<
-        bool,
-    decltype(detail::swap_adl_tests::can_swap<T[N], T[N]>(0))::value &&
-(!decltype(
-    detail::swap_adl_tests::uses_std<T[N], T[N]>(0))::value ||
-is_swappable<T, T>::value)> {};
-
-template <class T, class U = T>
-struct is_nothrow_swappable
-    : std::integral_constant<
-        bool,
-        is_swappable<T, U>::value &&
-            ((decltype(detail::swap_adl_tests::uses_std<T, U>(0))::value
-        && detail::swap_adl_tests::is_std_swap_noexcept<T>::value) ||
-(!decltype(detail::swap_adl_tests::uses_std<T, U>(0))::value &&
-    detail::swap_adl_tests::is_adl_swap_noexcept<T,
-                                                 U>::value))> {
-};
-#endif
-#endif
+        template<class... Args>
+            requires std::is_constructible_v<E, Args...>
+        constexpr explicit Unexpected(in_place_t, Args &&...args) : error_(std::forward<Args>(args)...) {}
 
-// Trait for checking if a type is a colite::Expected
-template <class T> struct is_expected_impl : std::false_type {};
-template <class T, class E>
-struct is_expected_impl<Expected<T, E>> : std::true_type {};
-template <class T> using is_expected = is_expected_impl<decay_t<T>>;
-
-template <class T, class E, class U>
-using expected_enable_forward_value = detail::enable_if_t<
-    std::is_constructible<T, U &&>::value &&
-        !std::is_same<detail::decay_t<U>, in_place_t>::value &&
-        !std::is_same<Expected<T, E>, detail::decay_t<U>>::value &&
-!std::is_same<Unexpected<E>, detail::decay_t<U>>::value>;
-
-template <class T, class E, class U, class G, class UR, class GR>
-using expected_enable_from_other = detail::enable_if_t<
-    std::is_constructible<T, UR>::value &&
-        std::is_constructible<E, GR>::value &&
-        !std::is_constructible<T, Expected<U, G> &>::value &&
-!std::is_constructible<T, Expected<U, G> &&>::value &&
-!std::is_constructible<T, const Expected<U, G> &>::value &&
-!std::is_constructible<T, const Expected<U, G> &&>::value &&
-!std::is_convertible<Expected<U, G> &, T>::value &&
-!std::is_convertible<Expected<U, G> &&, T>::value &&
-!std::is_convertible<const Expected<U, G> &, T>::value &&
-!std::is_convertible<const Expected<U, G> &&, T>::value>;
-
-template <class T, class U>
-using is_void_or = conditional_t<std::is_void<T>::value, std::true_type, U>;
-
-template <class T>
-using is_copy_constructible_or_void =
-is_void_or<T, std::is_copy_constructible<T>>;
-
-template <class T>
-using is_move_constructible_or_void =
-is_void_or<T, std::is_move_constructible<T>>;
-
-template <class T>
-using is_copy_assignable_or_void =
-is_void_or<T, std::is_copy_assignable<T>>;
-
-
-template <class T>
-using is_move_assignable_or_void =
-is_void_or<T, std::is_move_assignable<T>>;
-
-
-} // namespace detail
-
-namespace detail {
-    struct no_init_t {};
-    static constexpr no_init_t no_init{};
-
-// Implements the storage of the values, and ensures that the destructor is
-// trivial if it can be.
-//
-// This specialization is for where neither `T` or `E` is trivially
-// destructible, so the destructors must be called on destruction of the
-// `Expected`
-template <class T, class E, bool = std::is_trivially_destructible<T>::value,
-    bool = std::is_trivially_destructible<E>::value>
-struct expected_storage_base {
-    constexpr expected_storage_base() : m_val(T{}), m_has_val(true) {}
-    constexpr expected_storage_base(no_init_t) : m_no_init(), m_has_val(false) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<T, Args &&...>::value> * =
-        nullptr>
-    constexpr expected_storage_base(in_place_t, Args &&... args)
-        : m_val(std::forward<Args>(args)...), m_has_val(true) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr expected_storage_base(in_place_t, std::initializer_list<U> il,
-                                    Args &&... args)
-        : m_val(il, std::forward<Args>(args)...), m_has_val(true) {}
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit expected_storage_base(unexpect_t, Args &&... args)
-        : m_unexpect(std::forward<Args>(args)...), m_has_val(false) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit expected_storage_base(unexpect_t,
-                                             std::initializer_list<U> il,
-                                             Args &&... args)
-        : m_unexpect(il, std::forward<Args>(args)...), m_has_val(false) {}
-
-    ~expected_storage_base() {
-        if (m_has_val) {
-            m_val.~T();
-        } else {
-            m_unexpect.~Unexpected<E>();
-        }
-    }
-    union {
-        T m_val;
-        Unexpected<E> m_unexpect;
-        char m_no_init;
-    };
-    bool m_has_val;
-};
-
-// This specialization is for when both `T` and `E` are trivially-destructible,
-// so the destructor of the `Expected` can be trivial.
-template <class T, class E> struct expected_storage_base<T, E, true, true> {
-    constexpr expected_storage_base() : m_val(T{}), m_has_val(true) {}
-    constexpr expected_storage_base(no_init_t) : m_no_init(), m_has_val(false) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<T, Args &&...>::value> * =
-        nullptr>
-    constexpr expected_storage_base(in_place_t, Args &&... args)
-        : m_val(std::forward<Args>(args)...), m_has_val(true) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr expected_storage_base(in_place_t, std::initializer_list<U> il,
-                                    Args &&... args)
-        : m_val(il, std::forward<Args>(args)...), m_has_val(true) {}
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit expected_storage_base(unexpect_t, Args &&... args)
-        : m_unexpect(std::forward<Args>(args)...), m_has_val(false) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit expected_storage_base(unexpect_t,
-                                             std::initializer_list<U> il,
-                                             Args &&... args)
-        : m_unexpect(il, std::forward<Args>(args)...), m_has_val(false) {}
-
-    ~expected_storage_base() = default;
-    union {
-        T m_val;
-        Unexpected<E> m_unexpect;
-        char m_no_init;
-    };
-    bool m_has_val;
-};
-
-// T is trivial, E is not.
-template <class T, class E> struct expected_storage_base<T, E, true, false> {
-    constexpr expected_storage_base() : m_val(T{}), m_has_val(true) {}
-    COLITE_EXPECTED_MSVC2015_CONSTEXPR expected_storage_base(no_init_t)
-        : m_no_init(), m_has_val(false) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<T, Args &&...>::value> * =
-        nullptr>
-    constexpr expected_storage_base(in_place_t, Args &&... args)
-        : m_val(std::forward<Args>(args)...), m_has_val(true) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr expected_storage_base(in_place_t, std::initializer_list<U> il,
-                                    Args &&... args)
-        : m_val(il, std::forward<Args>(args)...), m_has_val(true) {}
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit expected_storage_base(unexpect_t, Args &&... args)
-        : m_unexpect(std::forward<Args>(args)...), m_has_val(false) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit expected_storage_base(unexpect_t,
-                                             std::initializer_list<U> il,
-                                             Args &&... args)
-        : m_unexpect(il, std::forward<Args>(args)...), m_has_val(false) {}
-
-    ~expected_storage_base() {
-        if (!m_has_val) {
-            m_unexpect.~Unexpected<E>();
-        }
-    }
-
-    union {
-        T m_val;
-        Unexpected<E> m_unexpect;
-        char m_no_init;
-    };
-    bool m_has_val;
-};
-
-// E is trivial, T is not.
-template <class T, class E> struct expected_storage_base<T, E, false, true> {
-    constexpr expected_storage_base() : m_val(T{}), m_has_val(true) {}
-    constexpr expected_storage_base(no_init_t) : m_no_init(), m_has_val(false) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<T, Args &&...>::value> * =
-        nullptr>
-    constexpr expected_storage_base(in_place_t, Args &&... args)
-        : m_val(std::forward<Args>(args)...), m_has_val(true) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr expected_storage_base(in_place_t, std::initializer_list<U> il,
-                                    Args &&... args)
-        : m_val(il, std::forward<Args>(args)...), m_has_val(true) {}
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit expected_storage_base(unexpect_t, Args &&... args)
-        : m_unexpect(std::forward<Args>(args)...), m_has_val(false) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit expected_storage_base(unexpect_t,
-                                             std::initializer_list<U> il,
-                                             Args &&... args)
-        : m_unexpect(il, std::forward<Args>(args)...), m_has_val(false) {}
-
-    ~expected_storage_base() {
-        if (m_has_val) {
-            m_val.~T();
-        }
-    }
-    union {
-        T m_val;
-        Unexpected<E> m_unexpect;
-        char m_no_init;
-    };
-    bool m_has_val;
-};
-
-// `T` is `void`, `E` is trivially-destructible
-template <class E> struct expected_storage_base<void, E, false, true> {
-    COLITE_EXPECTED_MSVC2015_CONSTEXPR expected_storage_base() : m_has_val(true) {}
-    constexpr expected_storage_base(no_init_t) : m_val(), m_has_val(false) {}
-
-    constexpr expected_storage_base(in_place_t) : m_has_val(true) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit expected_storage_base(unexpect_t, Args &&... args)
-        : m_unexpect(std::forward<Args>(args)...), m_has_val(false) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit expected_storage_base(unexpect_t,
-                                             std::initializer_list<U> il,
-                                             Args &&... args)
-        : m_unexpect(il, std::forward<Args>(args)...), m_has_val(false) {}
-
-    ~expected_storage_base() = default;
-    struct dummy {};
-    union {
-        Unexpected<E> m_unexpect;
-        dummy m_val;
-    };
-    bool m_has_val;
-};
-
-// `T` is `void`, `E` is not trivially-destructible
-template <class E> struct expected_storage_base<void, E, false, false> {
-    constexpr expected_storage_base() : m_dummy(), m_has_val(true) {}
-    constexpr expected_storage_base(no_init_t) : m_dummy(), m_has_val(false) {}
-
-    constexpr expected_storage_base(in_place_t) : m_dummy(), m_has_val(true) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit expected_storage_base(unexpect_t, Args &&... args)
-        : m_unexpect(std::forward<Args>(args)...), m_has_val(false) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit expected_storage_base(unexpect_t,
-                                             std::initializer_list<U> il,
-                                             Args &&... args)
-        : m_unexpect(il, std::forward<Args>(args)...), m_has_val(false) {}
-
-    ~expected_storage_base() {
-        if (!m_has_val) {
-            m_unexpect.~Unexpected<E>();
-        }
-    }
-
-    union {
-        Unexpected<E> m_unexpect;
-        char m_dummy;
+        constexpr Unexpected &operator=(const Unexpected &) = default;
+        constexpr Unexpected &operator=(Unexpected &&) = default;
+
+        [[nodiscard]] constexpr const E &error() const & noexcept {
+            return error_;
+        }
+        [[nodiscard]] constexpr E &error() & noexcept {
+            return error_;
+        }
+        [[nodiscard]] constexpr const E &&error() const && noexcept {
+            return std::move(error_);
+        }
+        [[nodiscard]] constexpr E &&error() && noexcept {
+            return std::move(error_);
+        }
+
+        template<class G>
+        friend constexpr bool operator==(const Unexpected &lhs, const Unexpected<G> &rhs) {
+            return lhs.error() == rhs.error();
+        }
     };
-    bool m_has_val;
-};
-
-// This base class provides some handy member functions which can be used in
-// further derived classes
-template <class T, class E>
-struct expected_operations_base : expected_storage_base<T, E> {
-    using expected_storage_base<T, E>::expected_storage_base;
-
-    template <class... Args> void construct(Args &&... args) noexcept {
-        new (std::addressof(this->m_val)) T(std::forward<Args>(args)...);
-        this->m_has_val = true;
-    }
-
-    template <class Rhs> void construct_with(Rhs &&rhs) noexcept {
-        new (std::addressof(this->m_val)) T(std::forward<Rhs>(rhs).get());
-        this->m_has_val = true;
-    }
-
-    template <class... Args> void construct_error(Args &&... args) noexcept {
-        new (std::addressof(this->m_unexpect))
-            Unexpected<E>(std::forward<Args>(args)...);
-        this->m_has_val = false;
-    }
-
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-
-    // These assign overloads ensure that the most efficient assignment
-  // implementation is used while maintaining the strong exception guarantee.
-  // The problematic case is where rhs has a value, but *this does not.
-  //
-  // This overload handles the case where we can just copy-construct `T`
-  // directly into place without throwing.
-  template <class U = T,
-            detail::enable_if_t<std::is_nothrow_copy_constructible<U>::value>
-                * = nullptr>
-  void assign(const expected_operations_base &rhs) noexcept {
-    if (!this->m_has_val && rhs.m_has_val) {
-      geterr().~Unexpected<E>();
-      construct(rhs.get());
-    } else {
-      assign_common(rhs);
-    }
-  }
-
-  // This overload handles the case where we can attempt to create a copy of
-  // `T`, then no-throw move it into place if the copy was successful.
-  template <class U = T,
-            detail::enable_if_t<!std::is_nothrow_copy_constructible<U>::value &&
-                                std::is_nothrow_move_constructible<U>::value>
-                * = nullptr>
-  void assign(const expected_operations_base &rhs) noexcept {
-    if (!this->m_has_val && rhs.m_has_val) {
-      T tmp = rhs.get();
-      geterr().~Unexpected<E>();
-      construct(std::move(tmp));
-    } else {
-      assign_common(rhs);
-    }
-  }
-
-  // This overload is the worst-case, where we have to move-construct the
-  // Unexpected value into temporary storage, then try to copy the T into place.
-  // If the construction succeeds, then everything is fine, but if it throws,
-  // then we move the old Unexpected value back into place before rethrowing the
-  // exception.
-  template <class U = T,
-            detail::enable_if_t<!std::is_nothrow_copy_constructible<U>::value &&
-                                !std::is_nothrow_move_constructible<U>::value>
-                * = nullptr>
-  void assign(const expected_operations_base &rhs) {
-    if (!this->m_has_val && rhs.m_has_val) {
-      auto tmp = std::move(geterr());
-      geterr().~Unexpected<E>();
-
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-      try {
-        construct(rhs.get());
-      } catch (...) {
-        geterr() = std::move(tmp);
-        throw;
-      }
+
+    template<class E>
+    Unexpected(E) -> Unexpected<E>;
+
+    namespace detail {
+        template<class T>
+        inline constexpr bool is_expected = false;
+        template<class T, class E>
+        inline constexpr bool is_expected<Expected<T, E>> = true;
+
+        template<class T>
+        inline constexpr bool is_unexpected = false;
+        template<class E>
+        inline constexpr bool is_unexpected<Unexpected<E>> = true;
+
+        template<class T>
+        concept trivially_copyable_member = std::is_void_v<T> || (std::is_trivially_copy_constructible_v<T> && std::is_trivially_copy_assignable_v<T> && std::is_trivially_destructible_v<T>);
+
+        template<class T>
+        concept trivially_movable_member = std::is_void_v<T> || (std::is_trivially_move_constructible_v<T> && std::is_trivially_move_assignable_v<T> && std::is_trivially_destructible_v<T>);
+
+        [[noreturn]] inline void throw_bad_access(auto &&error) {
+#if defined(__cpp_exceptions)
+            throw bad_expected_access<std::decay_t<decltype(error)>>(std::forward<decltype(error)>(error));
 #else
-      construct(rhs.get());
+            std::terminate();
 #endif
-    } else {
-      assign_common(rhs);
-    }
-  }
-
-  // These overloads do the same as above, but for rvalues
-  template <class U = T,
-            detail::enable_if_t<std::is_nothrow_move_constructible<U>::value>
-                * = nullptr>
-  void assign(expected_operations_base &&rhs) noexcept {
-    if (!this->m_has_val && rhs.m_has_val) {
-      geterr().~Unexpected<E>();
-      construct(std::move(rhs).get());
-    } else {
-      assign_common(std::move(rhs));
-    }
-  }
-
-  template <class U = T,
-            detail::enable_if_t<!std::is_nothrow_move_constructible<U>::value>
-                * = nullptr>
-  void assign(expected_operations_base &&rhs) {
-    if (!this->m_has_val && rhs.m_has_val) {
-      auto tmp = std::move(geterr());
-      geterr().~Unexpected<E>();
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-      try {
-        construct(std::move(rhs).get());
-      } catch (...) {
-        geterr() = std::move(tmp);
-        throw;
-      }
+        }
+
+        // Placement construction and destruction of the union members. `std::construct_at` would make these usable in
+        // constant expressions but needs `<memory>`, which alone costs more to include than this whole header.
+        template<class T, class... Args>
+        constexpr void construct(T &slot, Args &&...args) {
+            ::new (static_cast<void *>(__builtin_addressof(slot))) T(std::forward<Args>(args)...);
+        }
+
+        template<class T>
+        constexpr void destroy(T &slot) noexcept {
+            slot.~T();
+        }
+
+        // Replaces `old` with a `New` constructed from `args`. If that throws, `old` is left as it was.
+        template<class New, class Old, class... Args>
+        constexpr void reinit(New &new_member, Old &old_member, Args &&...args) {
+            if constexpr (std::is_nothrow_constructible_v<New, Args...>) {
+                detail::destroy(old_member);
+                detail::construct(new_member, std::forward<Args>(args)...);
+            } else if constexpr (std::is_nothrow_move_constructible_v<New>) {
+                New tmp(std::forward<Args>(args)...);
+                detail::destroy(old_member);
+                detail::construct(new_member, std::move(tmp));
+            } else {
+                Old tmp(std::move(old_member));
+                detail::destroy(old_member);
+#if defined(__cpp_exceptions)
+                try {
+                    detail::construct(new_member, std::forward<Args>(args)...);
+                } catch (...) {
+                    detail::construct(old_member, std::move(tmp));
+                    throw;
+                }
 #else
-      construct(std::move(rhs).get());
+                detail::construct(new_member, std::forward<Args>(args)...);
 #endif
-    } else {
-      assign_common(std::move(rhs));
-    }
-  }
+            }
+        }
+    }// namespace detail
+
+    /**
+     * @brief Holds either a `T` or an error `E`.
+     */
+    template<class T, class E>
+    class Expected {
+        static_assert(!std::is_reference_v<T> && !std::is_same_v<std::remove_cv_t<T>, in_place_t> && !std::is_same_v<std::remove_cv_t<T>, unexpect_t>);
+
+        template<class, class>
+        friend class Expected;
+
+        union {
+            T value_;
+            E error_;
+        };
+        bool has_value_;
+
+        template<class Self, class F>
+        static constexpr auto and_then_impl(Self &&self, F &&f) {
+            using Result = std::remove_cvref_t<std::invoke_result_t<F, decltype(std::forward<Self>(self).value_)>>;
+            static_assert(detail::is_expected<Result>, "and_then must return an Expected");
+            if (self.has_value_) {
+                return std::forward<F>(f)(std::forward<Self>(self).value_);
+            }
+            return Result(unexpect, std::forward<Self>(self).error_);
+        }
 
-#else
+        template<class Self, class F>
+        static constexpr auto or_else_impl(Self &&self, F &&f) {
+            using Result = std::remove_cvref_t<std::invoke_result_t<F, decltype(std::forward<Self>(self).error_)>>;
+            static_assert(detail::is_expected<Result>, "or_else must return an Expected");
+            if (self.has_value_) {
+                return Result(in_place, std::forward<Self>(self).value_);
+            }
+            return std::forward<F>(f)(std::forward<Self>(self).error_);
+        }
 
-    // If exceptions are disabled then we can just copy-construct
-    void assign(const expected_operations_base &rhs) noexcept {
-        if (!this->m_has_val && rhs.m_has_val) {
-            geterr().~Unexpected<E>();
-            construct(rhs.get());
-        } else {
-            assign_common(rhs);
+        template<class Self, class F>
+        static constexpr auto transform_impl(Self &&self, F &&f) {
+            using U = std::remove_cv_t<std::invoke_result_t<F, decltype(std::forward<Self>(self).value_)>>;
+            if (!self.has_value_) {
+                return Expected<U, E>(unexpect, std::forward<Self>(self).error_);
+            }
+            if constexpr (std::is_void_v<U>) {
+                std::forward<F>(f)(std::forward<Self>(self).value_);
+                return Expected<U, E>();
+            } else {
+                return Expected<U, E>(in_place, std::forward<F>(f)(std::forward<Self>(self).value_));
+            }
         }
-    }
 
-    void assign(expected_operations_base &&rhs) noexcept {
-        if (!this->m_has_val && rhs.m_has_val) {
-            geterr().~Unexpected<E>();
-            construct(std::move(rhs).get());
-        } else {
-            assign_common(rhs);
+        template<class Self, class F>
+        static constexpr auto transform_error_impl(Self &&self, F &&f) {
+            using G = std::remove_cv_t<std::invoke_result_t<F, decltype(std::forward<Self>(self).error_)>>;
+            if (self.has_value_) {
+                return Expected<T, G>(in_place, std::forward<Self>(self).value_);
+            }
+            return Expected<T, G>(unexpect, std::forward<F>(f)(std::forward<Self>(self).error_));
         }
-    }
 
-#endif
+    public:
+        using value_type = T;
+        using error_type = E;
+        using unexpected_type = Unexpected<E>;
+
+        template<class U>
+        using rebind = Expected<U, error_type>;
+
+        constexpr Expected()
+            requires std::is_default_constructible_v<T>
+            : value_(), has_value_(true) {}
+
+        constexpr Expected(const Expected &)
+            requires std::is_trivially_copy_constructible_v<T> && std::is_trivially_copy_constructible_v<E>
+        = default;
+        constexpr Expected(const Expected &rhs)
+            requires std::is_copy_constructible_v<T> && std::is_copy_constructible_v<E> && (!std::is_trivially_copy_constructible_v<T> || !std::is_trivially_copy_constructible_v<E>)
+            : has_value_(rhs.has_value_) {
+            if (has_value_) {
+                detail::construct(value_, rhs.value_);
+            } else {
+                detail::construct(error_, rhs.error_);
+            }
+        }
 
-    // The common part of move/copy assigning
-    template <class Rhs> void assign_common(Rhs &&rhs) {
-        if (this->m_has_val) {
-            if (rhs.m_has_val) {
-                get() = std::forward<Rhs>(rhs).get();
+        constexpr Expected(Expected &&)
+            requires std::is_trivially_move_constructible_v<T> && std::is_trivially_move_constructible_v<E>
+        = default;
+        constexpr Expected(Expected &&rhs) noexcept(std::is_nothrow_move_constructible_v<T> &&std::is_nothrow_move_constructible_v<E>)
+            requires std::is_move_constructible_v<T> && std::is_move_constructible_v<E> && (!std::is_trivially_move_constructible_v<T> || !std::is_trivially_move_constructible_v<E>)
+            : has_value_(rhs.has_value_) {
+            if (has_value_) {
+                detail::construct(value_, std::move(rhs.value_));
             } else {
-                destroy_val();
-                construct_error(std::forward<Rhs>(rhs).geterr());
+                detail::construct(error_, std::move(rhs.error_));
             }
-        } else {
-            if (!rhs.m_has_val) {
-                geterr() = std::forward<Rhs>(rhs).geterr();
+        }
+
+        template<class U, class G>
+            requires std::is_constructible_v<T, const U &> && std::is_constructible_v<E, const G &> && (!std::is_same_v<Expected<U, G>, Expected>)
+        constexpr explicit(!std::is_convertible_v<const U &, T> || !std::is_convertible_v<const G &, E>) Expected(const Expected<U, G> &rhs)
+            : has_value_(rhs.has_value_) {
+            if (has_value_) {
+                detail::construct(value_, rhs.value_);
+            } else {
+                detail::construct(error_, rhs.error_);
             }
         }
-    }
 
-    bool has_value() const { return this->m_has_val; }
+        template<class U, class G>
+            requires std::is_constructible_v<T, U> && std::is_constructible_v<E, G> && (!std::is_same_v<Expected<U, G>, Expected>)
+        constexpr explicit(!std::is_convertible_v<U, T> || !std::is_convertible_v<G, E>) Expected(Expected<U, G> &&rhs)
+            : has_value_(rhs.has_value_) {
+            if (has_value_) {
+                detail::construct(value_, std::move(rhs.value_));
+            } else {
+                detail::construct(error_, std::move(rhs.error_));
+            }
+        }
 
-    COLITE_EXPECTED_11_CONSTEXPR T &get() & { return this->m_val; }
-    constexpr const T &get() const & { return this->m_val; }
-    COLITE_EXPECTED_11_CONSTEXPR T &&get() && { return std::move(this->m_val); }
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    constexpr const T &&get() const && { return std::move(this->m_val); }
-#endif
+        template<class U = T>
+            requires(!std::is_same_v<std::remove_cvref_t<U>, in_place_t> && !std::is_same_v<std::remove_cvref_t<U>, Expected> && !detail::is_unexpected<std::remove_cvref_t<U>> && std::is_constructible_v<T, U>)
+        constexpr explicit(!std::is_convertible_v<U, T>) Expected(U &&v) : value_(std::forward<U>(v)), has_value_(true) {}
+
+        template<class G>
+            requires std::is_constructible_v<E, const G &>
+        constexpr explicit(!std::is_convertible_v<const G &, E>) Expected(const Unexpected<G> &e) : error_(e.error()), has_value_(false) {}
+
+        template<class G>
+            requires std::is_constructible_v<E, G>
+        constexpr explicit(!std::is_convertible_v<G, E>) Expected(Unexpected<G> &&e) : error_(std::move(e).error()), has_value_(false) {}
+
+        template<class... Args>
+            requires std::is_constructible_v<T, Args...>
+        constexpr explicit Expected(in_place_t, Args &&...args) : value_(std::forward<Args>(args)...), has_value_(true) {}
+
+        template<class... Args>
+            requires std::is_constructible_v<E, Args...>
+        constexpr explicit Expected(unexpect_t, Args &&...args) : error_(std::forward<Args>(args)...), has_value_(false) {}
+
+        constexpr ~Expected()
+            requires std::is_trivially_destructible_v<T> && std::is_trivially_destructible_v<E>
+        = default;
+        constexpr ~Expected()
+            requires(!std::is_trivially_destructible_v<T> || !std::is_trivially_destructible_v<E>)
+        {
+            if (has_value_) {
+                detail::destroy(value_);
+            } else {
+                detail::destroy(error_);
+            }
+        }
 
-    COLITE_EXPECTED_11_CONSTEXPR Unexpected<E> &geterr() & {
-        return this->m_unexpect;
-    }
-    constexpr const Unexpected<E> &geterr() const & { return this->m_unexpect; }
-    COLITE_EXPECTED_11_CONSTEXPR Unexpected<E> &&geterr() && {
-        return std::move(this->m_unexpect);
-    }
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    constexpr const Unexpected<E> &&geterr() const && {
-        return std::move(this->m_unexpect);
-    }
-#endif
+        constexpr Expected &operator=(const Expected &)
+            requires detail::trivially_copyable_member<T> && detail::trivially_copyable_member<E>
+        = default;
+        constexpr Expected &operator=(const Expected &rhs)
+            requires std::is_copy_constructible_v<T> && std::is_copy_assignable_v<T> && std::is_copy_constructible_v<E> && std::is_copy_assignable_v<E> &&
+                     (std::is_nothrow_move_constructible_v<T> || std::is_nothrow_move_constructible_v<E>) &&
+                     (!detail::trivially_copyable_member<T> || !detail::trivially_copyable_member<E>)
+        {
+            if (has_value_ && rhs.has_value_) {
+                value_ = rhs.value_;
+            } else if (has_value_) {
+                detail::reinit(error_, value_, rhs.error_);
+            } else if (rhs.has_value_) {
+                detail::reinit(value_, error_, rhs.value_);
+            } else {
+                error_ = rhs.error_;
+            }
+            has_value_ = rhs.has_value_;
+            return *this;
+        }
 
-    COLITE_EXPECTED_11_CONSTEXPR void destroy_val() {
-        get().~T();
-    }
-};
-
-// This base class provides some handy member functions which can be used in
-// further derived classes
-template <class E>
-struct expected_operations_base<void, E> : expected_storage_base<void, E> {
-    using expected_storage_base<void, E>::expected_storage_base;
-
-    template <class... Args> void construct() noexcept { this->m_has_val = true; }
-
-    // This function doesn't use its argument, but needs it so that code in
-    // levels above this can work independently of whether T is void
-    template <class Rhs> void construct_with(Rhs &&) noexcept {
-        this->m_has_val = true;
-    }
-
-    template <class... Args> void construct_error(Args &&... args) noexcept {
-        new (std::addressof(this->m_unexpect))
-            Unexpected<E>(std::forward<Args>(args)...);
-        this->m_has_val = false;
-    }
-
-    template <class Rhs> void assign(Rhs &&rhs) noexcept {
-        if (!this->m_has_val) {
-            if (rhs.m_has_val) {
-                geterr().~Unexpected<E>();
-                construct();
+        constexpr Expected &operator=(Expected &&)
+            requires detail::trivially_movable_member<T> && detail::trivially_movable_member<E>
+        = default;
+        constexpr Expected &operator=(Expected &&rhs) noexcept(std::is_nothrow_move_assignable_v<T> &&std::is_nothrow_move_constructible_v<T> &&std::is_nothrow_move_assignable_v<E> &&std::is_nothrow_move_constructible_v<E>)
+            requires std::is_move_constructible_v<T> && std::is_move_assignable_v<T> && std::is_move_constructible_v<E> && std::is_move_assignable_v<E> &&
+                     (std::is_nothrow_move_constructible_v<T> || std::is_nothrow_move_constructible_v<E>) &&
+                     (!detail::trivially_movable_member<T> || !detail::trivially_movable_member<E>)
+        {
+            if (has_value_ && rhs.has_value_) {
+                value_ = std::move(rhs.value_);
+            } else if (has_value_) {
+                detail::reinit(error_, value_, std::move(rhs.error_));
+            } else if (rhs.has_value_) {
+                detail::reinit(value_, error_, std::move(rhs.value_));
             } else {
-                geterr() = std::forward<Rhs>(rhs).geterr();
+                error_ = std::move(rhs.error_);
             }
-        } else {
-            if (!rhs.m_has_val) {
-                construct_error(std::forward<Rhs>(rhs).geterr());
+            has_value_ = rhs.has_value_;
+            return *this;
+        }
+
+        template<class U = T>
+            requires(!std::is_same_v<std::remove_cvref_t<U>, Expected> && !detail::is_unexpected<std::remove_cvref_t<U>> && std::is_constructible_v<T, U> && std::is_assignable_v<T &, U> &&
+                     (std::is_nothrow_constructible_v<T, U> || std::is_nothrow_move_constructible_v<T> || std::is_nothrow_move_constructible_v<E>))
+        constexpr Expected &operator=(U &&v) {
+            if (has_value_) {
+                value_ = std::forward<U>(v);
+            } else {
+                detail::reinit(value_, error_, std::forward<U>(v));
+                has_value_ = true;
             }
+            return *this;
         }
-    }
-
-    bool has_value() const { return this->m_has_val; }
-
-    COLITE_EXPECTED_11_CONSTEXPR Unexpected<E> &geterr() & {
-        return this->m_unexpect;
-    }
-    constexpr const Unexpected<E> &geterr() const & { return this->m_unexpect; }
-    COLITE_EXPECTED_11_CONSTEXPR Unexpected<E> &&geterr() && {
-        return std::move(this->m_unexpect);
-    }
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    constexpr const Unexpected<E> &&geterr() const && {
-        return std::move(this->m_unexpect);
-    }
-#endif
 
-    COLITE_EXPECTED_11_CONSTEXPR void destroy_val() {
-        //no-op
-    }
-};
-
-// This class manages conditionally having a trivial copy constructor
-// This specialization is for when T and E are trivially copy constructible
-template <class T, class E,
-    bool = is_void_or<T, COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(T)>::
-value &&COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(E)::value>
-struct expected_copy_base : expected_operations_base<T, E> {
-    using expected_operations_base<T, E>::expected_operations_base;
-};
-
-// This specialization is for when T or E are not trivially copy constructible
-template <class T, class E>
-struct expected_copy_base<T, E, false> : expected_operations_base<T, E> {
-    using expected_operations_base<T, E>::expected_operations_base;
-
-    expected_copy_base() = default;
-    expected_copy_base(const expected_copy_base &rhs)
-        : expected_operations_base<T, E>(no_init) {
-        if (rhs.has_value()) {
-            this->construct_with(rhs);
-        } else {
-            this->construct_error(rhs.geterr());
-        }
-    }
-
-    expected_copy_base(expected_copy_base &&rhs) = default;
-    expected_copy_base &operator=(const expected_copy_base &rhs) = default;
-    expected_copy_base &operator=(expected_copy_base &&rhs) = default;
-};
-
-// This class manages conditionally having a trivial move constructor
-// Unfortunately there's no way to achieve this in GCC < 5 AFAIK, since it
-// doesn't implement an analogue to std::is_trivially_move_constructible. We
-// have to make do with a non-trivial move constructor even if T is trivially
-// move constructible
-#ifndef COLITE_EXPECTED_GCC49
-template <class T, class E,
-    bool = is_void_or<T, std::is_trivially_move_constructible<T>>::value
-    &&std::is_trivially_move_constructible<E>::value>
-struct expected_move_base : expected_copy_base<T, E> {
-    using expected_copy_base<T, E>::expected_copy_base;
-};
-#else
-template <class T, class E, bool = false> struct expected_move_base;
-#endif
-template <class T, class E>
-struct expected_move_base<T, E, false> : expected_copy_base<T, E> {
-    using expected_copy_base<T, E>::expected_copy_base;
-
-    expected_move_base() = default;
-    expected_move_base(const expected_move_base &rhs) = default;
-
-    expected_move_base(expected_move_base &&rhs) noexcept(
-        std::is_nothrow_move_constructible<T>::value)
-        : expected_copy_base<T, E>(no_init) {
-            if (rhs.has_value()) {
-                this->construct_with(std::move(rhs));
+        template<class G>
+            requires std::is_constructible_v<E, const G &> && std::is_assignable_v<E &, const G &>
+        constexpr Expected &operator=(const Unexpected<G> &e) {
+            if (has_value_) {
+                detail::reinit(error_, value_, e.error());
+                has_value_ = false;
             } else {
-                this->construct_error(std::move(rhs.geterr()));
+                error_ = e.error();
             }
+            return *this;
         }
-    expected_move_base &operator=(const expected_move_base &rhs) = default;
-    expected_move_base &operator=(expected_move_base &&rhs) = default;
-};
-
-// This class manages conditionally having a trivial copy assignment operator
-template <class T, class E,
-    bool = is_void_or<
-        T, conjunction<COLITE_EXPECTED_IS_TRIVIALLY_COPY_ASSIGNABLE(T),
-    COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(T),
-    COLITE_EXPECTED_IS_TRIVIALLY_DESTRUCTIBLE(T)>>::value
-    &&COLITE_EXPECTED_IS_TRIVIALLY_COPY_ASSIGNABLE(E)::value
-&&COLITE_EXPECTED_IS_TRIVIALLY_COPY_CONSTRUCTIBLE(E)::value
-    &&COLITE_EXPECTED_IS_TRIVIALLY_DESTRUCTIBLE(E)::value>
-struct expected_copy_assign_base : expected_move_base<T, E> {
-    using expected_move_base<T, E>::expected_move_base;
-};
-
-template <class T, class E>
-struct expected_copy_assign_base<T, E, false> : expected_move_base<T, E> {
-    using expected_move_base<T, E>::expected_move_base;
-
-    expected_copy_assign_base() = default;
-    expected_copy_assign_base(const expected_copy_assign_base &rhs) = default;
-
-    expected_copy_assign_base(expected_copy_assign_base &&rhs) = default;
-    expected_copy_assign_base &operator=(const expected_copy_assign_base &rhs) {
-        this->assign(rhs);
-        return *this;
-    }
-    expected_copy_assign_base &
-    operator=(expected_copy_assign_base &&rhs) = default;
-};
-
-// This class manages conditionally having a trivial move assignment operator
-// Unfortunately there's no way to achieve this in GCC < 5 AFAIK, since it
-// doesn't implement an analogue to std::is_trivially_move_assignable. We have
-// to make do with a non-trivial move assignment operator even if T is trivially
-// move assignable
-#ifndef COLITE_EXPECTED_GCC49
-template <class T, class E,
-    bool =
-    is_void_or<T, conjunction<std::is_trivially_destructible<T>,
-    std::is_trivially_move_constructible<T>,
-    std::is_trivially_move_assignable<T>>>::
-value &&std::is_trivially_destructible<E>::value
-&&std::is_trivially_move_constructible<E>::value
-    &&std::is_trivially_move_assignable<E>::value>
-struct expected_move_assign_base : expected_copy_assign_base<T, E> {
-    using expected_copy_assign_base<T, E>::expected_copy_assign_base;
-};
-#else
-template <class T, class E, bool = false> struct expected_move_assign_base;
-#endif
 
-template <class T, class E>
-struct expected_move_assign_base<T, E, false>
-    : expected_copy_assign_base<T, E> {
-    using expected_copy_assign_base<T, E>::expected_copy_assign_base;
-
-    expected_move_assign_base() = default;
-    expected_move_assign_base(const expected_move_assign_base &rhs) = default;
-
-    expected_move_assign_base(expected_move_assign_base &&rhs) = default;
-
-    expected_move_assign_base &
-    operator=(const expected_move_assign_base &rhs) = default;
-
-    expected_move_assign_base &
-    operator=(expected_move_assign_base &&rhs) noexcept(
-        std::is_nothrow_move_constructible<T>::value
-    &&std::is_nothrow_move_assignable<T>::value) {
-        this->assign(std::move(rhs));
-        return *this;
-    }
-};
-
-// expected_delete_ctor_base will conditionally delete copy and move
-// constructors depending on whether T is copy/move constructible
-template <class T, class E,
-    bool EnableCopy = (is_copy_constructible_or_void<T>::value &&
-        std::is_copy_constructible<E>::value),
-    bool EnableMove = (is_move_constructible_or_void<T>::value &&
-        std::is_move_constructible<E>::value)>
-struct expected_delete_ctor_base {
-    expected_delete_ctor_base() = default;
-    expected_delete_ctor_base(const expected_delete_ctor_base &) = default;
-    expected_delete_ctor_base(expected_delete_ctor_base &&) noexcept = default;
-    expected_delete_ctor_base &
-    operator=(const expected_delete_ctor_base &) = default;
-    expected_delete_ctor_base &
-    operator=(expected_delete_ctor_base &&) noexcept = default;
-};
-
-template <class T, class E>
-struct expected_delete_ctor_base<T, E, true, false> {
-    expected_delete_ctor_base() = default;
-    expected_delete_ctor_base(const expected_delete_ctor_base &) = default;
-    expected_delete_ctor_base(expected_delete_ctor_base &&) noexcept = delete;
-    expected_delete_ctor_base &
-    operator=(const expected_delete_ctor_base &) = default;
-    expected_delete_ctor_base &
-    operator=(expected_delete_ctor_base &&) noexcept = default;
-};
-
-template <class T, class E>
-struct expected_delete_ctor_base<T, E, false, true> {
-    expected_delete_ctor_base() = default;
-    expected_delete_ctor_base(const expected_delete_ctor_base &) = delete;
-    expected_delete_ctor_base(expected_delete_ctor_base &&) noexcept = default;
-    expected_delete_ctor_base &
-    operator=(const expected_delete_ctor_base &) = default;
-    expected_delete_ctor_base &
-    operator=(expected_delete_ctor_base &&) noexcept = default;
-};
-
-template <class T, class E>
-struct expected_delete_ctor_base<T, E, false, false> {
-    expected_delete_ctor_base() = default;
-    expected_delete_ctor_base(const expected_delete_ctor_base &) = delete;
-    expected_delete_ctor_base(expected_delete_ctor_base &&) noexcept = delete;
-    expected_delete_ctor_base &
-    operator=(const expected_delete_ctor_base &) = default;
-    expected_delete_ctor_base &
-    operator=(expected_delete_ctor_base &&) noexcept = default;
-};
-
-// expected_delete_assign_base will conditionally delete copy and move
-// constructors depending on whether T and E are copy/move constructible +
-// assignable
-template <class T, class E,
-    bool EnableCopy = (is_copy_constructible_or_void<T>::value &&
-        std::is_copy_constructible<E>::value &&
-        is_copy_assignable_or_void<T>::value &&
-        std::is_copy_assignable<E>::value),
-    bool EnableMove = (is_move_constructible_or_void<T>::value &&
-        std::is_move_constructible<E>::value &&
-        is_move_assignable_or_void<T>::value &&
-        std::is_move_assignable<E>::value)>
-struct expected_delete_assign_base {
-    expected_delete_assign_base() = default;
-    expected_delete_assign_base(const expected_delete_assign_base &) = default;
-    expected_delete_assign_base(expected_delete_assign_base &&) noexcept =
-    default;
-    expected_delete_assign_base &
-    operator=(const expected_delete_assign_base &) = default;
-    expected_delete_assign_base &
-    operator=(expected_delete_assign_base &&) noexcept = default;
-};
-
-template <class T, class E>
-struct expected_delete_assign_base<T, E, true, false> {
-    expected_delete_assign_base() = default;
-    expected_delete_assign_base(const expected_delete_assign_base &) = default;
-    expected_delete_assign_base(expected_delete_assign_base &&) noexcept =
-    default;
-    expected_delete_assign_base &
-    operator=(const expected_delete_assign_base &) = default;
-    expected_delete_assign_base &
-    operator=(expected_delete_assign_base &&) noexcept = delete;
-};
-
-template <class T, class E>
-struct expected_delete_assign_base<T, E, false, true> {
-    expected_delete_assign_base() = default;
-    expected_delete_assign_base(const expected_delete_assign_base &) = default;
-    expected_delete_assign_base(expected_delete_assign_base &&) noexcept =
-    default;
-    expected_delete_assign_base &
-    operator=(const expected_delete_assign_base &) = delete;
-    expected_delete_assign_base &
-    operator=(expected_delete_assign_base &&) noexcept = default;
-};
-
-template <class T, class E>
-struct expected_delete_assign_base<T, E, false, false> {
-    expected_delete_assign_base() = default;
-    expected_delete_assign_base(const expected_delete_assign_base &) = default;
-    expected_delete_assign_base(expected_delete_assign_base &&) noexcept =
-    default;
-    expected_delete_assign_base &
-    operator=(const expected_delete_assign_base &) = delete;
-    expected_delete_assign_base &
-    operator=(expected_delete_assign_base &&) noexcept = delete;
-};
-
-// This is needed to be able to construct the expected_default_ctor_base which
-// follows, while still conditionally deleting the default constructor.
-struct default_constructor_tag {
-    explicit constexpr default_constructor_tag() = default;
-};
-
-// expected_default_ctor_base will ensure that Expected has a deleted default
-// consturctor if T is not default constructible.
-// This specialization is for when T is default constructible
-template <class T, class E,
-    bool Enable =
-    std::is_default_constructible<T>::value || std::is_void<T>::value>
-struct expected_default_ctor_base {
-    constexpr expected_default_ctor_base() noexcept = default;
-    constexpr expected_default_ctor_base(
-        expected_default_ctor_base const &) noexcept = default;
-    constexpr expected_default_ctor_base(expected_default_ctor_base &&) noexcept =
-    default;
-    expected_default_ctor_base &
-    operator=(expected_default_ctor_base const &) noexcept = default;
-    expected_default_ctor_base &
-    operator=(expected_default_ctor_base &&) noexcept = default;
-
-    constexpr explicit expected_default_ctor_base(default_constructor_tag) {}
-};
-
-// This specialization is for when T is not default constructible
-template <class T, class E> struct expected_default_ctor_base<T, E, false> {
-    constexpr expected_default_ctor_base() noexcept = delete;
-    constexpr expected_default_ctor_base(
-        expected_default_ctor_base const &) noexcept = default;
-    constexpr expected_default_ctor_base(expected_default_ctor_base &&) noexcept =
-    default;
-    expected_default_ctor_base &
-    operator=(expected_default_ctor_base const &) noexcept = default;
-    expected_default_ctor_base &
-    operator=(expected_default_ctor_base &&) noexcept = default;
-
-    constexpr explicit expected_default_ctor_base(default_constructor_tag) {}
-};
-} // namespace detail
-
-template <class E> class bad_expected_access : public std::exception {
-public:
-    explicit bad_expected_access(E e) : m_val(std::move(e)) {}
-
-    virtual const char *what() const noexcept override {
-        return "Bad Expected access";
-    }
-
-    const E &error() const & { return m_val; }
-    E &error() & { return m_val; }
-    const E &&error() const && { return std::move(m_val); }
-    E &&error() && { return std::move(m_val); }
-
-private:
-    E m_val;
-};
-
-/// An `Expected<T, E>` object is an object that contains the storage for
-/// another object and manages the lifetime of this contained object `T`.
-/// Alternatively it could contain the storage for another Unexpected object
-/// `E`. The contained object may not be initialized after the Expected object
-/// has been initialized, and may not be destroyed before the Expected object
-/// has been destroyed. The initialization state of the contained object is
-/// tracked by the Expected object.
-template <class T, class E>
-class Expected : private detail::expected_move_assign_base<T, E>,
-                 private detail::expected_delete_ctor_base<T, E>,
-                 private detail::expected_delete_assign_base<T, E>,
-                 private detail::expected_default_ctor_base<T, E> {
-    static_assert(!std::is_reference<T>::value, "T must not be a reference");
-    static_assert(!std::is_same<T, std::remove_cv<in_place_t>>::value,
-    "T must not be in_place_t");
-    static_assert(!std::is_same<T, std::remove_cv<unexpect_t>>::value,
-    "T must not be unexpect_t");
-    static_assert(!std::is_same<T, std::remove_cv<Unexpected<E>>>::value,
-    "T must not be Unexpected<E>");
-    static_assert(!std::is_reference<E>::value, "E must not be a reference");
-
-    T *valptr() { return std::addressof(this->m_val); }
-    const T *valptr() const { return std::addressof(this->m_val); }
-    Unexpected<E> *errptr() { return std::addressof(this->m_unexpect); }
-    const Unexpected<E> *errptr() const { return std::addressof(this->m_unexpect); }
-
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR U &val() {
-        return this->m_val;
-    }
-    COLITE_EXPECTED_11_CONSTEXPR Unexpected<E> &err() { return this->m_unexpect; }
-
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    constexpr const U &val() const {
-        return this->m_val;
-    }
-    constexpr const Unexpected<E> &err() const { return this->m_unexpect; }
-
-    using impl_base = detail::expected_move_assign_base<T, E>;
-    using ctor_base = detail::expected_default_ctor_base<T, E>;
-
-public:
-    typedef T value_type;
-    typedef E error_type;
-    typedef Unexpected<E> unexpected_type;
-
-#if defined(COLITE_EXPECTED_CXX14) && !defined(COLITE_EXPECTED_GCC49) &&               \
-    !defined(COLITE_EXPECTED_GCC54) && !defined(COLITE_EXPECTED_GCC55)
-    template <class F> COLITE_EXPECTED_11_CONSTEXPR auto and_then(F &&f) & {
-    return and_then_impl(*this, std::forward<F>(f));
-  }
-  template <class F> COLITE_EXPECTED_11_CONSTEXPR auto and_then(F &&f) && {
-    return and_then_impl(std::move(*this), std::forward<F>(f));
-  }
-  template <class F> constexpr auto and_then(F &&f) const & {
-    return and_then_impl(*this, std::forward<F>(f));
-  }
-
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-  template <class F> constexpr auto and_then(F &&f) const && {
-    return and_then_impl(std::move(*this), std::forward<F>(f));
-  }
-#endif
+        template<class G>
+            requires std::is_constructible_v<E, G> && std::is_assignable_v<E &, G>
+        constexpr Expected &operator=(Unexpected<G> &&e) {
+            if (has_value_) {
+                detail::reinit(error_, value_, std::move(e).error());
+                has_value_ = false;
+            } else {
+                error_ = std::move(e).error();
+            }
+            return *this;
+        }
 
-#else
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR auto
-    and_then(F &&f) & -> decltype(and_then_impl(std::declval<Expected&>(), std::forward<F>(f))) {
-        return and_then_impl(*this, std::forward<F>(f));
-    }
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR auto and_then(F &&f) && -> decltype(
-    and_then_impl(std::declval<Expected&&>(), std::forward<F>(f))) {
-        return and_then_impl(std::move(*this), std::forward<F>(f));
-    }
-    template <class F>
-    constexpr auto and_then(F &&f) const & -> decltype(
-    and_then_impl(std::declval<Expected const&>(), std::forward<F>(f))) {
-        return and_then_impl(*this, std::forward<F>(f));
-    }
-
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    template <class F>
-    constexpr auto and_then(F &&f) const && -> decltype(
-    and_then_impl(std::declval<Expected const&&>(), std::forward<F>(f))) {
-        return and_then_impl(std::move(*this), std::forward<F>(f));
-    }
-#endif
-#endif
+        template<class... Args>
+            requires std::is_nothrow_constructible_v<T, Args...>
+        constexpr T &emplace(Args &&...args) noexcept {
+            if (has_value_) {
+                detail::destroy(value_);
+            } else {
+                detail::destroy(error_);
+                has_value_ = true;
+            }
+            detail::construct(value_, std::forward<Args>(args)...);
+            return value_;
+        }
 
-#if defined(COLITE_EXPECTED_CXX14) && !defined(COLITE_EXPECTED_GCC49) &&               \
-    !defined(COLITE_EXPECTED_GCC54) && !defined(COLITE_EXPECTED_GCC55)
-    template <class F> COLITE_EXPECTED_11_CONSTEXPR auto map(F &&f) & {
-    return expected_map_impl(*this, std::forward<F>(f));
-  }
-  template <class F> COLITE_EXPECTED_11_CONSTEXPR auto map(F &&f) && {
-    return expected_map_impl(std::move(*this), std::forward<F>(f));
-  }
-  template <class F> constexpr auto map(F &&f) const & {
-    return expected_map_impl(*this, std::forward<F>(f));
-  }
-  template <class F> constexpr auto map(F &&f) const && {
-    return expected_map_impl(std::move(*this), std::forward<F>(f));
-  }
-#else
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR decltype(
-        expected_map_impl(std::declval<Expected &>(), std::declval<F &&>()))
-    map(F &&f) & {
-        return expected_map_impl(*this, std::forward<F>(f));
-    }
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR decltype(
-        expected_map_impl(std::declval<Expected>(), std::declval<F &&>()))
-    map(F &&f) && {
-        return expected_map_impl(std::move(*this), std::forward<F>(f));
-    }
-    template <class F>
-    constexpr decltype(expected_map_impl(std::declval<const Expected &>(),
-                       std::declval<F &&>()))
-    map(F &&f) const & {
-        return expected_map_impl(*this, std::forward<F>(f));
-    }
-
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    template <class F>
-    constexpr decltype(expected_map_impl(std::declval<const Expected &&>(),
-                       std::declval<F &&>()))
-    map(F &&f) const && {
-        return expected_map_impl(std::move(*this), std::forward<F>(f));
-    }
-#endif
-#endif
+        constexpr void swap(Expected &rhs) noexcept(std::is_nothrow_move_constructible_v<T> &&std::is_nothrow_swappable_v<T> &&std::is_nothrow_move_constructible_v<E> &&std::is_nothrow_swappable_v<E>)
+            requires std::is_swappable_v<T> && std::is_swappable_v<E> && std::is_move_constructible_v<T> && std::is_move_constructible_v<E>
+        {
+            using std::swap;
+            if (has_value_ && rhs.has_value_) {
+                swap(value_, rhs.value_);
+            } else if (!has_value_ && !rhs.has_value_) {
+                swap(error_, rhs.error_);
+            } else if (has_value_) {
+                rhs.swap(*this);
+            } else {
+                // `this` holds an error and `rhs` a value.
+                E tmp(std::move(error_));
+                detail::destroy(error_);
+                detail::construct(value_, std::move(rhs.value_));
+                detail::destroy(rhs.value_);
+                detail::construct(rhs.error_, std::move(tmp));
+                has_value_ = true;
+                rhs.has_value_ = false;
+            }
+        }
 
-#if defined(COLITE_EXPECTED_CXX14) && !defined(COLITE_EXPECTED_GCC49) &&               \
-    !defined(COLITE_EXPECTED_GCC54) && !defined(COLITE_EXPECTED_GCC55)
-    template <class F> COLITE_EXPECTED_11_CONSTEXPR auto transform(F &&f) & {
-    return expected_map_impl(*this, std::forward<F>(f));
-  }
-  template <class F> COLITE_EXPECTED_11_CONSTEXPR auto transform(F &&f) && {
-    return expected_map_impl(std::move(*this), std::forward<F>(f));
-  }
-  template <class F> constexpr auto transform(F &&f) const & {
-    return expected_map_impl(*this, std::forward<F>(f));
-  }
-  template <class F> constexpr auto transform(F &&f) const && {
-    return expected_map_impl(std::move(*this), std::forward<F>(f));
-  }
-#else
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR decltype(
-        expected_map_impl(std::declval<Expected &>(), std::declval<F &&>()))
-    transform(F &&f) & {
-        return expected_map_impl(*this, std::forward<F>(f));
-    }
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR decltype(
-        expected_map_impl(std::declval<Expected>(), std::declval<F &&>()))
-    transform(F &&f) && {
-        return expected_map_impl(std::move(*this), std::forward<F>(f));
-    }
-    template <class F>
-    constexpr decltype(expected_map_impl(std::declval<const Expected &>(),
-                       std::declval<F &&>()))
-    transform(F &&f) const & {
-        return expected_map_impl(*this, std::forward<F>(f));
-    }
-
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    template <class F>
-    constexpr decltype(expected_map_impl(std::declval<const Expected &&>(),
-                       std::declval<F &&>()))
-    transform(F &&f) const && {
-        return expected_map_impl(std::move(*this), std::forward<F>(f));
-    }
-#endif
-#endif
+        friend constexpr void swap(Expected &lhs, Expected &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+            lhs.swap(rhs);
+        }
 
-#if defined(COLITE_EXPECTED_CXX14) && !defined(COLITE_EXPECTED_GCC49) &&               \
-    !defined(COLITE_EXPECTED_GCC54) && !defined(COLITE_EXPECTED_GCC55)
-    template <class F> COLITE_EXPECTED_11_CONSTEXPR auto map_error(F &&f) & {
-    return map_error_impl(*this, std::forward<F>(f));
-  }
-  template <class F> COLITE_EXPECTED_11_CONSTEXPR auto map_error(F &&f) && {
-    return map_error_impl(std::move(*this), std::forward<F>(f));
-  }
-  template <class F> constexpr auto map_error(F &&f) const & {
-    return map_error_impl(*this, std::forward<F>(f));
-  }
-  template <class F> constexpr auto map_error(F &&f) const && {
-    return map_error_impl(std::move(*this), std::forward<F>(f));
-  }
-#else
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR decltype(map_error_impl(std::declval<Expected &>(),
-                                      std::declval<F &&>()))
-    map_error(F &&f) & {
-        return map_error_impl(*this, std::forward<F>(f));
-    }
-    template <class F>
-    COLITE_EXPECTED_11_CONSTEXPR decltype(map_error_impl(std::declval<Expected &&>(),
-                                      std::declval<F &&>()))
-    map_error(F &&f) && {
-        return map_error_impl(std::move(*this), std::forward<F>(f));
-    }
-    template <class F>
-    constexpr decltype(map_error_impl(std::declval<const Expected &>(),
-                       std::declval<F &&>()))
-    map_error(F &&f) const & {
-        return map_error_impl(*this, std::forward<F>(f));
-    }
-
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    template <class F>
-    constexpr decltype(map_error_impl(std::declval<const Expected &&>(),
-                       std::declval<F &&>()))
-    map_error(F &&f) const && {
-        return map_error_impl(std::move(*this), std::forward<F>(f));
-    }
-#endif
-#endif
-    template <class F> Expected COLITE_EXPECTED_11_CONSTEXPR or_else(F &&f) & {
-        return or_else_impl(*this, std::forward<F>(f));
-    }
-
-    template <class F> Expected COLITE_EXPECTED_11_CONSTEXPR or_else(F &&f) && {
-        return or_else_impl(std::move(*this), std::forward<F>(f));
-    }
-
-    template <class F> Expected constexpr or_else(F &&f) const & {
-        return or_else_impl(*this, std::forward<F>(f));
-    }
-
-#ifndef COLITE_EXPECTED_NO_CONSTRR
-    template <class F> Expected constexpr or_else(F &&f) const && {
-        return or_else_impl(std::move(*this), std::forward<F>(f));
-    }
-#endif
-    constexpr Expected() = default;
-    constexpr Expected(const Expected &rhs) = default;
-    constexpr Expected(Expected &&rhs) = default;
-    Expected &operator=(const Expected &rhs) = default;
-    Expected &operator=(Expected &&rhs) = default;
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<T, Args &&...>::value> * =
-        nullptr>
-    constexpr Expected(in_place_t, Args &&... args)
-        : impl_base(in_place, std::forward<Args>(args)...),
-          ctor_base(detail::default_constructor_tag{}) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr Expected(in_place_t, std::initializer_list<U> il, Args &&... args)
-        : impl_base(in_place, il, std::forward<Args>(args)...),
-          ctor_base(detail::default_constructor_tag{}) {}
-
-    template <class G = E,
-        detail::enable_if_t<std::is_constructible<E, const G &>::value> * =
-        nullptr,
-        detail::enable_if_t<!std::is_convertible<const G &, E>::value> * =
-        nullptr>
-    explicit constexpr Expected(const Unexpected<G> &e)
-        : impl_base(unexpect, e.value()),
-          ctor_base(detail::default_constructor_tag{}) {}
-
-    template <
-        class G = E,
-        detail::enable_if_t<std::is_constructible<E, const G &>::value> * =
-        nullptr,
-        detail::enable_if_t<std::is_convertible<const G &, E>::value> * = nullptr>
-    constexpr Expected(Unexpected<G> const &e)
-        : impl_base(unexpect, e.value()),
-          ctor_base(detail::default_constructor_tag{}) {}
-
-    template <
-        class G = E,
-        detail::enable_if_t<std::is_constructible<E, G &&>::value> * = nullptr,
-        detail::enable_if_t<!std::is_convertible<G &&, E>::value> * = nullptr>
-    explicit constexpr Expected(Unexpected<G> &&e) noexcept(
-    std::is_nothrow_constructible<E, G &&>::value)
-        : impl_base(unexpect, std::move(e.value())),
-    ctor_base(detail::default_constructor_tag{}) {}
-
-    template <
-        class G = E,
-        detail::enable_if_t<std::is_constructible<E, G &&>::value> * = nullptr,
-        detail::enable_if_t<std::is_convertible<G &&, E>::value> * = nullptr>
-    constexpr Expected(Unexpected<G> &&e) noexcept(
-    std::is_nothrow_constructible<E, G &&>::value)
-        : impl_base(unexpect, std::move(e.value())),
-    ctor_base(detail::default_constructor_tag{}) {}
-
-    template <class... Args,
-        detail::enable_if_t<std::is_constructible<E, Args &&...>::value> * =
-        nullptr>
-    constexpr explicit Expected(unexpect_t, Args &&... args)
-        : impl_base(unexpect, std::forward<Args>(args)...),
-          ctor_base(detail::default_constructor_tag{}) {}
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_constructible<
-            E, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    constexpr explicit Expected(unexpect_t, std::initializer_list<U> il,
-                                Args &&... args)
-        : impl_base(unexpect, il, std::forward<Args>(args)...),
-          ctor_base(detail::default_constructor_tag{}) {}
-
-    template <class U, class G,
-        detail::enable_if_t<!(std::is_convertible<U const &, T>::value &&
-        std::is_convertible<G const &, E>::value)> * =
-    nullptr,
-    detail::expected_enable_from_other<T, E, U, G, const U &, const G &>
-    * = nullptr>
-    explicit COLITE_EXPECTED_11_CONSTEXPR Expected(const Expected<U, G> &rhs)
-        : ctor_base(detail::default_constructor_tag{}) {
-        if (rhs.has_value()) {
-            this->construct(*rhs);
-        } else {
-            this->construct_error(rhs.error());
-        }
-    }
-
-    template <class U, class G,
-        detail::enable_if_t<(std::is_convertible<U const &, T>::value &&
-        std::is_convertible<G const &, E>::value)> * =
-    nullptr,
-    detail::expected_enable_from_other<T, E, U, G, const U &, const G &>
-    * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR Expected(const Expected<U, G> &rhs)
-        : ctor_base(detail::default_constructor_tag{}) {
-        if (rhs.has_value()) {
-            this->construct(*rhs);
-        } else {
-            this->construct_error(rhs.error());
-        }
-    }
-
-    template <
-        class U, class G,
-        detail::enable_if_t<!(std::is_convertible<U &&, T>::value &&
-            std::is_convertible<G &&, E>::value)> * = nullptr,
-        detail::expected_enable_from_other<T, E, U, G, U &&, G &&> * = nullptr>
-    explicit COLITE_EXPECTED_11_CONSTEXPR Expected(Expected<U, G> &&rhs)
-        : ctor_base(detail::default_constructor_tag{}) {
-        if (rhs.has_value()) {
-            this->construct(std::move(*rhs));
-        } else {
-            this->construct_error(std::move(rhs.error()));
-        }
-    }
-
-    template <
-        class U, class G,
-        detail::enable_if_t<(std::is_convertible<U &&, T>::value &&
-            std::is_convertible<G &&, E>::value)> * = nullptr,
-        detail::expected_enable_from_other<T, E, U, G, U &&, G &&> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR Expected(Expected<U, G> &&rhs)
-        : ctor_base(detail::default_constructor_tag{}) {
-        if (rhs.has_value()) {
-            this->construct(std::move(*rhs));
-        } else {
-            this->construct_error(std::move(rhs.error()));
-        }
-    }
-
-    template <
-        class U = T,
-        detail::enable_if_t<!std::is_convertible<U &&, T>::value> * = nullptr,
-        detail::expected_enable_forward_value<T, E, U> * = nullptr>
-    explicit COLITE_EXPECTED_MSVC2015_CONSTEXPR Expected(U &&v)
-        : Expected(in_place, std::forward<U>(v)) {}
-
-    template <
-        class U = T,
-        detail::enable_if_t<std::is_convertible<U &&, T>::value> * = nullptr,
-        detail::expected_enable_forward_value<T, E, U> * = nullptr>
-    COLITE_EXPECTED_MSVC2015_CONSTEXPR Expected(U &&v)
-        : Expected(in_place, std::forward<U>(v)) {}
-
-    template <
-        class U = T, class G = T,
-        detail::enable_if_t<std::is_nothrow_constructible<T, U &&>::value> * =
-        nullptr,
-        detail::enable_if_t<!std::is_void<G>::value> * = nullptr,
-        detail::enable_if_t<
-            (!std::is_same<Expected<T, E>, detail::decay_t<U>>::value &&
-                !detail::conjunction<std::is_scalar<T>,
-                std::is_same<T, detail::decay_t<U>>>::value &&
-        std::is_constructible<T, U>::value &&
-    std::is_assignable<G &, U>::value &&
-        std::is_nothrow_move_constructible<E>::value)> * = nullptr>
-    Expected &operator=(U &&v) {
-        if (has_value()) {
-            val() = std::forward<U>(v);
-        } else {
-            err().~Unexpected<E>();
-            ::new (valptr()) T(std::forward<U>(v));
-            this->m_has_val = true;
-        }
-
-        return *this;
-    }
-
-    template <
-        class U = T, class G = T,
-        detail::enable_if_t<!std::is_nothrow_constructible<T, U &&>::value> * =
-        nullptr,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr,
-        detail::enable_if_t<
-            (!std::is_same<Expected<T, E>, detail::decay_t<U>>::value &&
-                !detail::conjunction<std::is_scalar<T>,
-                std::is_same<T, detail::decay_t<U>>>::value &&
-        std::is_constructible<T, U>::value &&
-    std::is_assignable<G &, U>::value &&
-        std::is_nothrow_move_constructible<E>::value)> * = nullptr>
-    Expected &operator=(U &&v) {
-        if (has_value()) {
-            val() = std::forward<U>(v);
-        } else {
-            auto tmp = std::move(err());
-            err().~Unexpected<E>();
-
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-            try {
-        ::new (valptr()) T(std::forward<U>(v));
-        this->m_has_val = true;
-      } catch (...) {
-        err() = std::move(tmp);
-        throw;
-      }
-#else
-            ::new (valptr()) T(std::forward<U>(v));
-            this->m_has_val = true;
-#endif
+        [[nodiscard]] constexpr const T *operator->() const noexcept {
+            return __builtin_addressof(value_);
+        }
+        [[nodiscard]] constexpr T *operator->() noexcept {
+            return __builtin_addressof(value_);
+        }
+        [[nodiscard]] constexpr const T &operator*() const & noexcept {
+            return value_;
+        }
+        [[nodiscard]] constexpr T &operator*() & noexcept {
+            return value_;
+        }
+        [[nodiscard]] constexpr const T &&operator*() const && noexcept {
+            return std::move(value_);
+        }
+        [[nodiscard]] constexpr T &&operator*() && noexcept {
+            return std::move(value_);
         }
 
-        return *this;
-    }
-
-    template <class G = E,
-        detail::enable_if_t<std::is_nothrow_copy_constructible<G>::value &&
-            std::is_assignable<G &, G>::value> * = nullptr>
-    Expected &operator=(const Unexpected<G> &rhs) {
-        if (!has_value()) {
-            err() = rhs;
-        } else {
-            this->destroy_val();
-            ::new (errptr()) Unexpected<E>(rhs);
-            this->m_has_val = false;
-        }
-
-        return *this;
-    }
-
-    template <class G = E,
-        detail::enable_if_t<std::is_nothrow_move_constructible<G>::value &&
-            std::is_move_assignable<G>::value> * = nullptr>
-    Expected &operator=(Unexpected<G> &&rhs) noexcept {
-        if (!has_value()) {
-            err() = std::move(rhs);
-        } else {
-            this->destroy_val();
-            ::new (errptr()) Unexpected<E>(std::move(rhs));
-            this->m_has_val = false;
-        }
-
-        return *this;
-    }
-
-    template <class... Args, detail::enable_if_t<std::is_nothrow_constructible<
-        T, Args &&...>::value> * = nullptr>
-    void emplace(Args &&... args) {
-        if (has_value()) {
-            val() = T(std::forward<Args>(args)...);
-        } else {
-            err().~Unexpected<E>();
-            ::new (valptr()) T(std::forward<Args>(args)...);
-            this->m_has_val = true;
-        }
-    }
-
-    template <class... Args, detail::enable_if_t<!std::is_nothrow_constructible<
-        T, Args &&...>::value> * = nullptr>
-    void emplace(Args &&... args) {
-        if (has_value()) {
-            val() = T(std::forward<Args>(args)...);
-        } else {
-            auto tmp = std::move(err());
-            err().~Unexpected<E>();
-
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-            try {
-        ::new (valptr()) T(std::forward<Args>(args)...);
-        this->m_has_val = true;
-      } catch (...) {
-        err() = std::move(tmp);
-        throw;
-      }
-#else
-            ::new (valptr()) T(std::forward<Args>(args)...);
-            this->m_has_val = true;
-#endif
+        [[nodiscard]] constexpr bool has_value() const noexcept {
+            return has_value_;
         }
-    }
-
-    template <class U, class... Args,
-        detail::enable_if_t<std::is_nothrow_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    void emplace(std::initializer_list<U> il, Args &&... args) {
-        if (has_value()) {
-            T t(il, std::forward<Args>(args)...);
-            val() = std::move(t);
-        } else {
-            err().~Unexpected<E>();
-            ::new (valptr()) T(il, std::forward<Args>(args)...);
-            this->m_has_val = true;
-        }
-    }
-
-    template <class U, class... Args,
-        detail::enable_if_t<!std::is_nothrow_constructible<
-            T, std::initializer_list<U> &, Args &&...>::value> * = nullptr>
-    void emplace(std::initializer_list<U> il, Args &&... args) {
-        if (has_value()) {
-            T t(il, std::forward<Args>(args)...);
-            val() = std::move(t);
-        } else {
-            auto tmp = std::move(err());
-            err().~Unexpected<E>();
-
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-            try {
-        ::new (valptr()) T(il, std::forward<Args>(args)...);
-        this->m_has_val = true;
-      } catch (...) {
-        err() = std::move(tmp);
-        throw;
-      }
-#else
-            ::new (valptr()) T(il, std::forward<Args>(args)...);
-            this->m_has_val = true;
-#endif
+        constexpr explicit operator bool() const noexcept {
+            return has_value_;
         }
-    }
-
-private:
-    using t_is_void = std::true_type;
-    using t_is_not_void = std::false_type;
-    using t_is_nothrow_move_constructible = std::true_type;
-    using move_constructing_t_can_throw = std::false_type;
-    using e_is_nothrow_move_constructible = std::true_type;
-    using move_constructing_e_can_throw = std::false_type;
-
-    void swap_where_both_have_value(Expected &/*rhs*/ , t_is_void) noexcept {
-        // swapping void is a no-op
-    }
-
-    void swap_where_both_have_value(Expected &rhs, t_is_not_void) {
-        using std::swap;
-        swap(val(), rhs.val());
-    }
-
-    void swap_where_only_one_has_value(Expected &rhs, t_is_void) noexcept(
-        std::is_nothrow_move_constructible<E>::value) {
-            ::new (errptr()) unexpected_type(std::move(rhs.err()));
-            rhs.err().~unexpected_type();
-            std::swap(this->m_has_val, rhs.m_has_val);
-        }
-
-    void swap_where_only_one_has_value(Expected &rhs, t_is_not_void) {
-        swap_where_only_one_has_value_and_t_is_not_void(
-            rhs, typename std::is_nothrow_move_constructible<T>::type{},
-            typename std::is_nothrow_move_constructible<E>::type{});
-    }
-
-    void swap_where_only_one_has_value_and_t_is_not_void(
-        Expected &rhs, t_is_nothrow_move_constructible,
-        e_is_nothrow_move_constructible) noexcept {
-        auto temp = std::move(val());
-        val().~T();
-        ::new (errptr()) unexpected_type(std::move(rhs.err()));
-        rhs.err().~unexpected_type();
-        ::new (rhs.valptr()) T(std::move(temp));
-        std::swap(this->m_has_val, rhs.m_has_val);
-    }
-
-    void swap_where_only_one_has_value_and_t_is_not_void(
-        Expected &rhs, t_is_nothrow_move_constructible,
-        move_constructing_e_can_throw) {
-        auto temp = std::move(val());
-        val().~T();
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-        try {
-      ::new (errptr()) unexpected_type(std::move(rhs.err()));
-      rhs.err().~unexpected_type();
-      ::new (rhs.valptr()) T(std::move(temp));
-      std::swap(this->m_has_val, rhs.m_has_val);
-    } catch (...) {
-      val() = std::move(temp);
-      throw;
-    }
-#else
-        ::new (errptr()) unexpected_type(std::move(rhs.err()));
-        rhs.err().~unexpected_type();
-        ::new (rhs.valptr()) T(std::move(temp));
-        std::swap(this->m_has_val, rhs.m_has_val);
-#endif
-    }
-
-    void swap_where_only_one_has_value_and_t_is_not_void(
-        Expected &rhs, move_constructing_t_can_throw,
-        t_is_nothrow_move_constructible) {
-        auto temp = std::move(rhs.err());
-        rhs.err().~unexpected_type();
-#ifdef COLITE_EXPECTED_EXCEPTIONS_ENABLED
-        try {
-      ::new (rhs.valptr()) T(val());
-      val().~T();
-      ::new (errptr()) unexpected_type(std::move(temp));
-      std::swap(this->m_has_val, rhs.m_has_val);
-    } catch (...) {
-      rhs.err() = std::move(temp);
-      throw;
-    }
-#else
-        ::new (rhs.valptr()) T(val());
-        val().~T();
-        ::new (errptr()) unexpected_type(std::move(temp));
-        std::swap(this->m_has_val, rhs.m_has_val);
-#endif
-    }
-
-public:
-    template <class OT = T, class OE = E>
-    detail::enable_if_t<detail::is_swappable<OT>::value &&
-        detail::is_swappable<OE>::value &&
-        (std::is_nothrow_move_constructible<OT>::value ||
-            std::is_nothrow_move_constructible<OE>::value)>
-    swap(Expected &rhs) noexcept(
-        std::is_nothrow_move_constructible<T>::value
-    &&detail::is_nothrow_swappable<T>::value
-        &&std::is_nothrow_move_constructible<E>::value
-    &&detail::is_nothrow_swappable<E>::value) {
-        if (has_value() && rhs.has_value()) {
-            swap_where_both_have_value(rhs, typename std::is_void<T>::type{});
-        } else if (!has_value() && rhs.has_value()) {
-            rhs.swap(*this);
-        } else if (has_value()) {
-            swap_where_only_one_has_value(rhs, typename std::is_void<T>::type{});
-        } else {
+
+        constexpr const T &value() const & {
+            if (!has_value_) {
+                detail::throw_bad_access(error_);
+            }
+            return value_;
+        }
+        constexpr T &value() & {
+            if (!has_value_) {
+                detail::throw_bad_access(std::as_const(error_));
+            }
+            return value_;
+        }
+        constexpr const T &&value() const && {
+            if (!has_value_) {
+                detail::throw_bad_access(std::move(error_));
+            }
+            return std::move(value_);
+        }
+        constexpr T &&value() && {
+            if (!has_value_) {
+                detail::throw_bad_access(std::move(error_));
+            }
+            return std::move(value_);
+        }
+
+        [[nodiscard]] constexpr const E &error() const & noexcept {
+            return error_;
+        }
+        [[nodiscard]] constexpr E &error() & noexcept {
+            return error_;
+        }
+        [[nodiscard]] constexpr const E &&error() const && noexcept {
+            return std::move(error_);
+        }
+        [[nodiscard]] constexpr E &&error() && noexcept {
+            return std::move(error_);
+        }
+
+        template<class U>
+        [[nodiscard]] constexpr T value_or(U &&v) const & {
+            return has_value_ ? value_ : static_cast<T>(std::forward<U>(v));
+        }
+        template<class U>
+        [[nodiscard]] constexpr T value_or(U &&v) && {
+            return has_value_ ? std::move(value_) : static_cast<T>(std::forward<U>(v));
+        }
+
+        template<class F>
+        constexpr auto and_then(F &&f) & {
+            return and_then_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto and_then(F &&f) const & {
+            return and_then_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto and_then(F &&f) && {
+            return and_then_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto and_then(F &&f) const && {
+            return and_then_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class F>
+        constexpr auto or_else(F &&f) & {
+            return or_else_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto or_else(F &&f) const & {
+            return or_else_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto or_else(F &&f) && {
+            return or_else_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto or_else(F &&f) const && {
+            return or_else_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class F>
+        constexpr auto transform(F &&f) & {
+            return transform_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform(F &&f) const & {
+            return transform_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform(F &&f) && {
+            return transform_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform(F &&f) const && {
+            return transform_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class F>
+        constexpr auto transform_error(F &&f) & {
+            return transform_error_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform_error(F &&f) const & {
+            return transform_error_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform_error(F &&f) && {
+            return transform_error_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform_error(F &&f) const && {
+            return transform_error_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class T2, class E2>
+            requires(!std::is_void_v<T2>)
+        friend constexpr bool operator==(const Expected &lhs, const Expected<T2, E2> &rhs) {
+            if (lhs.has_value() != rhs.has_value()) {
+                return false;
+            }
+            return lhs.has_value() ? *lhs == *rhs : lhs.error() == rhs.error();
+        }
+
+        template<class T2>
+            requires(!detail::is_expected<T2>)
+        friend constexpr bool operator==(const Expected &lhs, const T2 &rhs) {
+            return lhs.has_value() && *lhs == rhs;
+        }
+
+        template<class E2>
+        friend constexpr bool operator==(const Expected &lhs, const Unexpected<E2> &rhs) {
+            return !lhs.has_value() && lhs.error() == rhs.error();
+        }
+    };
+
+    /**
+     * @brief Either nothing, or an error `E`.
+     */
+    template<class T, class E>
+        requires std::is_void_v<T>
+    class Expected<T, E> {
+        template<class, class>
+        friend class Expected;
+
+        struct empty {};
+        union {
+            empty empty_;
+            E error_;
+        };
+        bool has_value_;
+
+        template<class Self, class F>
+        static constexpr auto and_then_impl(Self &&self, F &&f) {
+            using Result = std::remove_cvref_t<std::invoke_result_t<F>>;
+            static_assert(detail::is_expected<Result>, "and_then must return an Expected");
+            if (self.has_value_) {
+                return std::forward<F>(f)();
+            }
+            return Result(unexpect, std::forward<Self>(self).error_);
+        }
+
+        template<class Self, class F>
+        static constexpr auto or_else_impl(Self &&self, F &&f) {
+            using Result = std::remove_cvref_t<std::invoke_result_t<F, decltype(std::forward<Self>(self).error_)>>;
+            static_assert(detail::is_expected<Result>, "or_else must return an Expected");
+            if (self.has_value_) {
+                return Result();
+            }
+            return std::forward<F>(f)(std::forward<Self>(self).error_);
+        }
+
+        template<class Self, class F>
+        static constexpr auto transform_impl(Self &&self, F &&f) {
+            using U = std::remove_cv_t<std::invoke_result_t<F>>;
+            if (!self.has_value_) {
+                return Expected<U, E>(unexpect, std::forward<Self>(self).error_);
+            }
+            if constexpr (std::is_void_v<U>) {
+                std::forward<F>(f)();
+                return Expected<U, E>();
+            } else {
+                return Expected<U, E>(in_place, std::forward<F>(f)());
+            }
+        }
+
+        template<class Self, class F>
+        static constexpr auto transform_error_impl(Self &&self, F &&f) {
+            using G = std::remove_cv_t<std::invoke_result_t<F, decltype(std::forward<Self>(self).error_)>>;
+            if (self.has_value_) {
+                return Expected<T, G>();
+            }
+            return Expected<T, G>(unexpect, std::forward<F>(f)(std::forward<Self>(self).error_));
+        }
+
+    public:
+        using value_type = T;
+        using error_type = E;
+        using unexpected_type = Unexpected<E>;
+
+        template<class U>
+        using rebind = Expected<U, error_type>;
+
+        constexpr Expected() noexcept : empty_(), has_value_(true) {}
+
+        constexpr Expected(const Expected &)
+            requires std::is_trivially_copy_constructible_v<E>
+        = default;
+        constexpr Expected(const Expected &rhs)
+            requires std::is_copy_constructible_v<E> && (!std::is_trivially_copy_constructible_v<E>)
+            : empty_(), has_value_(rhs.has_value_) {
+            if (!has_value_) {
+                detail::construct(error_, rhs.error_);
+            }
+        }
+
+        constexpr Expected(Expected &&)
+            requires std::is_trivially_move_constructible_v<E>
+        = default;
+        constexpr Expected(Expected &&rhs) noexcept(std::is_nothrow_move_constructible_v<E>)
+            requires std::is_move_constructible_v<E> && (!std::is_trivially_move_constructible_v<E>)
+            : empty_(), has_value_(rhs.has_value_) {
+            if (!has_value_) {
+                detail::construct(error_, std::move(rhs.error_));
+            }
+        }
+
+        template<class U, class G>
+            requires std::is_void_v<U> && std::is_constructible_v<E, const G &> && (!std::is_same_v<G, E>)
+        constexpr explicit(!std::is_convertible_v<const G &, E>) Expected(const Expected<U, G> &rhs) : empty_(), has_value_(rhs.has_value_) {
+            if (!has_value_) {
+                detail::construct(error_, rhs.error_);
+            }
+        }
+
+        template<class U, class G>
+            requires std::is_void_v<U> && std::is_constructible_v<E, G> && (!std::is_same_v<G, E>)
+        constexpr explicit(!std::is_convertible_v<G, E>) Expected(Expected<U, G> &&rhs) : empty_(), has_value_(rhs.has_value_) {
+            if (!has_value_) {
+                detail::construct(error_, std::move(rhs.error_));
+            }
+        }
+
+        template<class G>
+            requires std::is_constructible_v<E, const G &>
+        constexpr explicit(!std::is_convertible_v<const G &, E>) Expected(const Unexpected<G> &e) : error_(e.error()), has_value_(false) {}
+
+        template<class G>
+            requires std::is_constructible_v<E, G>
+        constexpr explicit(!std::is_convertible_v<G, E>) Expected(Unexpected<G> &&e) : error_(std::move(e).error()), has_value_(false) {}
+
+        constexpr explicit Expected(in_place_t) noexcept : empty_(), has_value_(true) {}
+
+        template<class... Args>
+            requires std::is_constructible_v<E, Args...>
+        constexpr explicit Expected(unexpect_t, Args &&...args) : error_(std::forward<Args>(args)...), has_value_(false) {}
+
+        constexpr ~Expected()
+            requires std::is_trivially_destructible_v<E>
+        = default;
+        constexpr ~Expected()
+            requires(!std::is_trivially_destructible_v<E>)
+        {
+            if (!has_value_) {
+                detail::destroy(error_);
+            }
+        }
+
+        constexpr Expected &operator=(const Expected &)
+            requires detail::trivially_copyable_member<E>
+        = default;
+        constexpr Expected &operator=(const Expected &rhs)
+            requires std::is_copy_constructible_v<E> && std::is_copy_assignable_v<E> && (!detail::trivially_copyable_member<E>)
+        {
+            if (!has_value_ && !rhs.has_value_) {
+                error_ = rhs.error_;
+            } else if (!rhs.has_value_) {
+                detail::construct(error_, rhs.error_);
+            } else if (!has_value_) {
+                detail::destroy(error_);
+            }
+            has_value_ = rhs.has_value_;
+            return *this;
+        }
+
+        constexpr Expected &operator=(Expected &&)
+            requires detail::trivially_movable_member<E>
+        = default;
+        constexpr Expected &operator=(Expected &&rhs) noexcept(std::is_nothrow_move_constructible_v<E> &&std::is_nothrow_move_assignable_v<E>)
+            requires std::is_move_constructible_v<E> && std::is_move_assignable_v<E> && (!detail::trivially_movable_member<E>)
+        {
+            if (!has_value_ && !rhs.has_value_) {
+                error_ = std::move(rhs.error_);
+            } else if (!rhs.has_value_) {
+                detail::construct(error_, std::move(rhs.error_));
+            } else if (!has_value_) {
+                detail::destroy(error_);
+            }
+            has_value_ = rhs.has_value_;
+            return *this;
+        }
+
+        template<class G>
+            requires std::is_constructible_v<E, const G &> && std::is_assignable_v<E &, const G &>
+        constexpr Expected &operator=(const Unexpected<G> &e) {
+            if (has_value_) {
+                detail::construct(error_, e.error());
+                has_value_ = false;
+            } else {
+                error_ = e.error();
+            }
+            return *this;
+        }
+
+        template<class G>
+            requires std::is_constructible_v<E, G> && std::is_assignable_v<E &, G>
+        constexpr Expected &operator=(Unexpected<G> &&e) {
+            if (has_value_) {
+                detail::construct(error_, std::move(e).error());
+                has_value_ = false;
+            } else {
+                error_ = std::move(e).error();
+            }
+            return *this;
+        }
+
+        constexpr void emplace() noexcept {
+            if (!has_value_) {
+                detail::destroy(error_);
+                has_value_ = true;
+            }
+        }
+
+        constexpr void swap(Expected &rhs) noexcept(std::is_nothrow_move_constructible_v<E> &&std::is_nothrow_swappable_v<E>)
+            requires std::is_swappable_v<E> && std::is_move_constructible_v<E>
+        {
             using std::swap;
-            swap(err(), rhs.err());
-        }
-    }
-
-    constexpr const T *operator->() const { return valptr(); }
-    COLITE_EXPECTED_11_CONSTEXPR T *operator->() { return valptr(); }
-
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    constexpr const U &operator*() const & {
-        return val();
-    }
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR U &operator*() & {
-        return val();
-    }
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    constexpr const U &&operator*() const && {
-        return std::move(val());
-    }
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR U &&operator*() && {
-        return std::move(val());
-    }
-
-    constexpr bool has_value() const noexcept { return this->m_has_val; }
-    constexpr explicit operator bool() const noexcept { return this->m_has_val; }
-
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR const U &value() const & {
-        if (!has_value())
-            detail::throw_exception(bad_expected_access<E>(err().value()));
-        return val();
-    }
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR U &value() & {
-        if (!has_value())
-            detail::throw_exception(bad_expected_access<E>(err().value()));
-        return val();
-    }
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR const U &&value() const && {
-        if (!has_value())
-            detail::throw_exception(bad_expected_access<E>(std::move(err()).value()));
-        return std::move(val());
-    }
-    template <class U = T,
-        detail::enable_if_t<!std::is_void<U>::value> * = nullptr>
-    COLITE_EXPECTED_11_CONSTEXPR U &&value() && {
-        if (!has_value())
-            detail::throw_exception(bad_expected_access<E>(std::move(err()).value()));
-        return std::move(val());
-    }
-
-    constexpr const E &error() const & { return err().value(); }
-    COLITE_EXPECTED_11_CONSTEXPR E &error() & { return err().value(); }
-    constexpr const E &&error() const && { return std::move(err().value()); }
-    COLITE_EXPECTED_11_CONSTEXPR E &&error() && { return std::move(err().value()); }
-
-    template <class U> constexpr T value_or(U &&v) const & {
-        static_assert(std::is_copy_constructible<T>::value &&
-                          std::is_convertible<U &&, T>::value,
-                      "T must be copy-constructible and convertible to from U&&");
-        return bool(*this) ? **this : static_cast<T>(std::forward<U>(v));
-    }
-    template <class U> COLITE_EXPECTED_11_CONSTEXPR T value_or(U &&v) && {
-        static_assert(std::is_move_constructible<T>::value &&
-                          std::is_convertible<U &&, T>::value,
-                      "T must be move-constructible and convertible to from U&&");
-        return bool(*this) ? std::move(**this) : static_cast<T>(std::forward<U>(v));
-    }
-};
-
-namespace detail {
-    template <class Exp> using exp_t = typename detail::decay_t<Exp>::value_type;
-    template <class Exp> using err_t = typename detail::decay_t<Exp>::error_type;
-    template <class Exp, class Ret> using ret_t = Expected<Ret, err_t<Exp>>;
-
-#ifdef COLITE_EXPECTED_CXX14
-    template <class Exp, class F,
-          detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              *std::declval<Exp>()))>
-constexpr auto and_then_impl(Exp &&exp, F &&f) {
-  static_assert(detail::is_expected<Ret>::value, "F must return an Expected");
-
-  return exp.has_value()
-             ? detail::invoke(std::forward<F>(f), *std::forward<Exp>(exp))
-             : Ret(unexpect, std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-          detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,
-          class Ret = decltype(detail::invoke(std::declval<F>()))>
-constexpr auto and_then_impl(Exp &&exp, F &&f) {
-  static_assert(detail::is_expected<Ret>::value, "F must return an Expected");
-
-  return exp.has_value() ? detail::invoke(std::forward<F>(f))
-                         : Ret(unexpect, std::forward<Exp>(exp).error());
-}
-#else
-    template <class> struct TC;
-    template <class Exp, class F,
-        class Ret = decltype(detail::invoke(std::declval<F>(),
-                                            *std::declval<Exp>())),
-        detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr>
-    auto and_then_impl(Exp &&exp, F &&f) -> Ret {
-        static_assert(detail::is_expected<Ret>::value, "F must return an Expected");
-
-        return exp.has_value()
-               ? detail::invoke(std::forward<F>(f), *std::forward<Exp>(exp))
-               : Ret(unexpect, std::forward<Exp>(exp).error());
-    }
-
-    template <class Exp, class F,
-        class Ret = decltype(detail::invoke(std::declval<F>())),
-        detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr>
-    constexpr auto and_then_impl(Exp &&exp, F &&f) -> Ret {
-    static_assert(detail::is_expected<Ret>::value, "F must return an Expected");
-
-    return exp.has_value() ? detail::invoke(std::forward<F>(f))
-    : Ret(unexpect, std::forward<Exp>(exp).error());
-}
-#endif
+            if (!has_value_ && !rhs.has_value_) {
+                swap(error_, rhs.error_);
+            } else if (!has_value_) {
+                rhs.swap(*this);
+            } else if (!rhs.has_value_) {
+                detail::construct(error_, std::move(rhs.error_));
+                detail::destroy(rhs.error_);
+                has_value_ = false;
+                rhs.has_value_ = true;
+            }
+        }
 
-#ifdef COLITE_EXPECTED_CXX14
-template <class Exp, class F,
-          detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,          
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              *std::declval<Exp>())),
-          detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto expected_map_impl(Exp &&exp, F &&f) {
-  using result = ret_t<Exp, detail::decay_t<Ret>>;
-  return exp.has_value() ? result(detail::invoke(std::forward<F>(f),
-                                                 *std::forward<Exp>(exp)))
-                         : result(unexpect, std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-          detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,          
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              *std::declval<Exp>())),
-          detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-auto expected_map_impl(Exp &&exp, F &&f) {
-  using result = Expected<void, err_t<Exp>>;
-  if (exp.has_value()) {
-    detail::invoke(std::forward<F>(f), *std::forward<Exp>(exp));
-    return result();
-  }
-
-  return result(unexpect, std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-          detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,
-          class Ret = decltype(detail::invoke(std::declval<F>())),
-          detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto expected_map_impl(Exp &&exp, F &&f) {
-  using result = ret_t<Exp, detail::decay_t<Ret>>;
-  return exp.has_value() ? result(detail::invoke(std::forward<F>(f)))
-                         : result(unexpect, std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-          detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,          
-          class Ret = decltype(detail::invoke(std::declval<F>())),
-          detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-auto expected_map_impl(Exp &&exp, F &&f) {
-  using result = Expected<void, err_t<Exp>>;
-  if (exp.has_value()) {
-    detail::invoke(std::forward<F>(f));
-    return result();
-  }
-
-  return result(unexpect, std::forward<Exp>(exp).error());
-}
-#else
-template <class Exp, class F,
-    detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>(),
-                                    *std::declval<Exp>())),
-detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-
-constexpr auto expected_map_impl(Exp &&exp, F &&f)
--> ret_t<Exp, detail::decay_t<Ret>> {
-using result = ret_t<Exp, detail::decay_t<Ret>>;
-
-return exp.has_value() ? result(detail::invoke(std::forward<F>(f),
-                                               *std::forward<Exp>(exp)))
-: result(unexpect, std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-    detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>(),
-                                    *std::declval<Exp>())),
-detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-
-auto expected_map_impl(Exp &&exp, F &&f) -> Expected<void, err_t<Exp>> {
-if (exp.has_value()) {
-detail::invoke(std::forward<F>(f), *std::forward<Exp>(exp));
-return {};
-}
-
-return Unexpected<err_t<Exp>>(std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-    detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>())),
-    detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-
-constexpr auto expected_map_impl(Exp &&exp, F &&f)
--> ret_t<Exp, detail::decay_t<Ret>> {
-using result = ret_t<Exp, detail::decay_t<Ret>>;
-
-return exp.has_value() ? result(detail::invoke(std::forward<F>(f)))
-: result(unexpect, std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-    detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>())),
-    detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-
-auto expected_map_impl(Exp &&exp, F &&f) -> Expected<void, err_t<Exp>> {
-if (exp.has_value()) {
-detail::invoke(std::forward<F>(f));
-return {};
-}
-
-return Unexpected<err_t<Exp>>(std::forward<Exp>(exp).error());
-}
-#endif
+        friend constexpr void swap(Expected &lhs, Expected &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+            lhs.swap(rhs);
+        }
 
-#if defined(COLITE_EXPECTED_CXX14) && !defined(COLITE_EXPECTED_GCC49) &&               \
-    !defined(COLITE_EXPECTED_GCC54) && !defined(COLITE_EXPECTED_GCC55)
-template <class Exp, class F,
-          detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,          
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              std::declval<Exp>().error())),
-          detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto map_error_impl(Exp &&exp, F &&f) {
-  using result = Expected<exp_t<Exp>, detail::decay_t<Ret>>;
-  return exp.has_value()
-             ? result(*std::forward<Exp>(exp))
-             : result(unexpect, detail::invoke(std::forward<F>(f),
-                                               std::forward<Exp>(exp).error()));
-}
-template <class Exp, class F,
-          detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,                    
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              std::declval<Exp>().error())),
-          detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-auto map_error_impl(Exp &&exp, F &&f) {
-  using result = Expected<exp_t<Exp>, monostate>;
-  if (exp.has_value()) {
-    return result(*std::forward<Exp>(exp));
-  }
-
-  detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error());
-  return result(unexpect, monostate{});
-}
-template <class Exp, class F,
-          detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,          
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              std::declval<Exp>().error())),
-          detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto map_error_impl(Exp &&exp, F &&f) {
-  using result = Expected<exp_t<Exp>, detail::decay_t<Ret>>;
-  return exp.has_value()
-             ? result()
-             : result(unexpect, detail::invoke(std::forward<F>(f),
-                                               std::forward<Exp>(exp).error()));
-}
-template <class Exp, class F,
-          detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,                    
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              std::declval<Exp>().error())),
-          detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-auto map_error_impl(Exp &&exp, F &&f) {
-  using result = Expected<exp_t<Exp>, monostate>;
-  if (exp.has_value()) {
-    return result();
-  }
-
-  detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error());
-  return result(unexpect, monostate{});
-}
-#else
-template <class Exp, class F,
-    detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>(),
-                                    std::declval<Exp>().error())),
-detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto map_error_impl(Exp &&exp, F &&f)
--> Expected<exp_t<Exp>, detail::decay_t<Ret>> {
-using result = Expected<exp_t<Exp>, detail::decay_t<Ret>>;
-
-return exp.has_value()
-? result(*std::forward<Exp>(exp))
-: result(unexpect, detail::invoke(std::forward<F>(f),
-                                  std::forward<Exp>(exp).error()));
-}
-
-template <class Exp, class F,
-    detail::enable_if_t<!std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>(),
-                                    std::declval<Exp>().error())),
-detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-auto map_error_impl(Exp &&exp, F &&f) -> Expected<exp_t<Exp>, monostate> {
-using result = Expected<exp_t<Exp>, monostate>;
-if (exp.has_value()) {
-return result(*std::forward<Exp>(exp));
-}
-
-detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error());
-return result(unexpect, monostate{});
-}
-
-template <class Exp, class F,
-    detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>(),
-                                    std::declval<Exp>().error())),
-detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto map_error_impl(Exp &&exp, F &&f)
--> Expected<exp_t<Exp>, detail::decay_t<Ret>> {
-using result = Expected<exp_t<Exp>, detail::decay_t<Ret>>;
-
-return exp.has_value()
-? result()
-    : result(unexpect, detail::invoke(std::forward<F>(f),
-                                      std::forward<Exp>(exp).error()));
-}
-
-template <class Exp, class F,
-    detail::enable_if_t<std::is_void<exp_t<Exp>>::value> * = nullptr,
-class Ret = decltype(detail::invoke(std::declval<F>(),
-                                    std::declval<Exp>().error())),
-detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-auto map_error_impl(Exp &&exp, F &&f) -> Expected<exp_t<Exp>, monostate> {
-using result = Expected<exp_t<Exp>, monostate>;
-if (exp.has_value()) {
-return result();
-}
-
-detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error());
-return result(unexpect, monostate{});
-}
-#endif
+        [[nodiscard]] constexpr bool has_value() const noexcept {
+            return has_value_;
+        }
+        constexpr explicit operator bool() const noexcept {
+            return has_value_;
+        }
 
-#ifdef COLITE_EXPECTED_CXX14
-template <class Exp, class F,
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              std::declval<Exp>().error())),
-          detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-constexpr auto or_else_impl(Exp &&exp, F &&f) {
-  static_assert(detail::is_expected<Ret>::value, "F must return an Expected");
-  return exp.has_value()
-  ? std::forward<Exp>(exp)
-  : detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-          class Ret = decltype(detail::invoke(std::declval<F>(),
-                                              std::declval<Exp>().error())),
-          detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-detail::decay_t<Exp> or_else_impl(Exp &&exp, F &&f) {
-  return exp.has_value()
-  ? std::forward<Exp>(exp)
-  : (detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error()),
-    std::forward<Exp>(exp));
-}
-#else
-template <class Exp, class F,
-    class Ret = decltype(detail::invoke(std::declval<F>(),
-                                        std::declval<Exp>().error())),
-    detail::enable_if_t<!std::is_void<Ret>::value> * = nullptr>
-auto or_else_impl(Exp &&exp, F &&f) -> Ret {
-    static_assert(detail::is_expected<Ret>::value, "F must return an Expected");
-    return exp.has_value()
-           ? std::forward<Exp>(exp)
-           : detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error());
-}
-
-template <class Exp, class F,
-    class Ret = decltype(detail::invoke(std::declval<F>(),
-                                        std::declval<Exp>().error())),
-    detail::enable_if_t<std::is_void<Ret>::value> * = nullptr>
-detail::decay_t<Exp> or_else_impl(Exp &&exp, F &&f) {
-    return exp.has_value()
-           ? std::forward<Exp>(exp)
-           : (detail::invoke(std::forward<F>(f), std::forward<Exp>(exp).error()),
-            std::forward<Exp>(exp));
-}
-#endif
-} // namespace detail
-
-template <class T, class E, class U, class F>
-constexpr bool operator==(const Expected<T, E> &lhs,
-                          const Expected<U, F> &rhs) {
-    return (lhs.has_value() != rhs.has_value())
-           ? false
-           : (!lhs.has_value() ? lhs.error() == rhs.error() : *lhs == *rhs);
-}
-template <class T, class E, class U, class F>
-constexpr bool operator!=(const Expected<T, E> &lhs,
-                          const Expected<U, F> &rhs) {
-    return (lhs.has_value() != rhs.has_value())
-           ? true
-           : (!lhs.has_value() ? lhs.error() != rhs.error() : *lhs != *rhs);
-}
-
-template <class T, class E, class U>
-constexpr bool operator==(const Expected<T, E> &x, const U &v) {
-    return x.has_value() ? *x == v : false;
-}
-template <class T, class E, class U>
-constexpr bool operator==(const U &v, const Expected<T, E> &x) {
-    return x.has_value() ? *x == v : false;
-}
-template <class T, class E, class U>
-constexpr bool operator!=(const Expected<T, E> &x, const U &v) {
-    return x.has_value() ? *x != v : true;
-}
-template <class T, class E, class U>
-constexpr bool operator!=(const U &v, const Expected<T, E> &x) {
-    return x.has_value() ? *x != v : true;
-}
-
-template <class T, class E>
-constexpr bool operator==(const Expected<T, E> &x, const Unexpected<E> &e) {
-    return x.has_value() ? false : x.error() == e.value();
-}
-template <class T, class E>
-constexpr bool operator==(const Unexpected<E> &e, const Expected<T, E> &x) {
-    return x.has_value() ? false : x.error() == e.value();
-}
-template <class T, class E>
-constexpr bool operator!=(const Expected<T, E> &x, const Unexpected<E> &e) {
-    return x.has_value() ? true : x.error() != e.value();
-}
-template <class T, class E>
-constexpr bool operator!=(const Unexpected<E> &e, const Expected<T, E> &x) {
-    return x.has_value() ? true : x.error() != e.value();
-}
-
-template <class T, class E,
-    detail::enable_if_t<(std::is_void<T>::value ||
-        std::is_move_constructible<T>::value) &&
-        detail::is_swappable<T>::value &&
-        std::is_move_constructible<E>::value &&
-        detail::is_swappable<E>::value> * = nullptr>
-void swap(Expected<T, E> &lhs,
-          Expected<T, E> &rhs) noexcept(noexcept(lhs.swap(rhs))) {
-lhs.swap(rhs);
-}
-} // namespace colite
+        constexpr void operator*() const noexcept {}
+
+        constexpr void value() const & {
+            if (!has_value_) {
+                detail::throw_bad_access(error_);
+            }
+        }
+        constexpr void value() && {
+            if (!has_value_) {
+                detail::throw_bad_access(std::move(error_));
+            }
+        }
+
+        [[nodiscard]] constexpr const E &error() const & noexcept {
+            return error_;
+        }
+        [[nodiscard]] constexpr E &error() & noexcept {
+            return error_;
+        }
+        [[nodiscard]] constexpr const E &&error() const && noexcept {
+            return std::move(error_);
+        }
+        [[nodiscard]] constexpr E &&error() && noexcept {
+            return std::move(error_);
+        }
+
+        template<class F>
+        constexpr auto and_then(F &&f) & {
+            return and_then_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto and_then(F &&f) const & {
+            return and_then_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto and_then(F &&f) && {
+            return and_then_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto and_then(F &&f) const && {
+            return and_then_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class F>
+        constexpr auto or_else(F &&f) & {
+            return or_else_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto or_else(F &&f) const & {
+            return or_else_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto or_else(F &&f) && {
+            return or_else_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto or_else(F &&f) const && {
+            return or_else_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class F>
+        constexpr auto transform(F &&f) & {
+            return transform_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform(F &&f) const & {
+            return transform_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform(F &&f) && {
+            return transform_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform(F &&f) const && {
+            return transform_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class F>
+        constexpr auto transform_error(F &&f) & {
+            return transform_error_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform_error(F &&f) const & {
+            return transform_error_impl(*this, std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform_error(F &&f) && {
+            return transform_error_impl(std::move(*this), std::forward<F>(f));
+        }
+        template<class F>
+        constexpr auto transform_error(F &&f) const && {
+            return transform_error_impl(std::move(*this), std::forward<F>(f));
+        }
+
+        template<class T2, class E2>
+            requires std::is_void_v<T2>
+        friend constexpr bool operator==(const Expected &lhs, const Expected<T2, E2> &rhs) {
+            if (lhs.has_value() != rhs.has_value()) {
+                return false;
+            }
+            return lhs.has_value() || lhs.error() == rhs.error();
+        }
+
+        template<class E2>
+        friend constexpr bool operator==(const Expected &lhs, const Unexpected<E2> &rhs) {
+            return !lhs.has_value() && lhs.error() == rhs.error();
+        }
+    };
+}// namespace colite
 
 #endif
@@ -0,0 +1,311 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Opt-in instrumentation counters for the synchronization primitives.
+ *
+ * Define `COLITE_INSTRUMENT` (for instance with the `COLITE_INSTRUMENT` CMake option) to make every `Mutex` and
+ * channel count the heap allocations, executor posts, spurious wakeups and re-enqueues it performs. The counters
+ * are read with `instrumentation()` on the primitive, which returns a `Snapshot`. A `Mutex` additionally keeps contention
+ * statistics, read with `statistics()` as a `LockStatistics`, and channels record how long each value spent in the queue.
+ *
+ * Without `COLITE_INSTRUMENT` the counters are empty types whose member functions do nothing, so they take no space
+ * and compile to nothing. `instrumentation()` then always returns an all-zero `Snapshot`.
+ *
+ * @note `COLITE_INSTRUMENT` changes the layout of the primitives, it must be defined the same way in every translation unit.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace colite::instrument
+{
+#ifdef COLITE_INSTRUMENT
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    /**
+     * @brief A point in time copy of the counters of one primitive.
+     */
+    struct Snapshot
+    {
+        // Heap allocations made on behalf of the primitive: waiter nodes, alive checks, type-erased executors and
+        // handlers, timeout nodes, wakeup lists and queue storage.
+        std::uint64_t allocations = 0;
+        // Functions posted to an executor to resume or re-check a waiter.
+        std::uint64_t executor_posts = 0;
+        // Posted wakeups that found nothing to do once they ran.
+        std::uint64_t spurious_wakeups = 0;
+        // Waiters that were put back into the wait queue after a wakeup.
+        std::uint64_t requeues = 0;
+    };
+
+    inline constexpr std::size_t histogram_buckets = 32;
+
+    /**
+     * @brief A latency histogram in nanoseconds with power of two buckets.
+     *
+     * Bucket `i` counts durations in `[2^i, 2^(i+1))` ns (bucket 0 also counts 0 ns) and the last bucket counts everything longer.
+     */
+    using Histogram = std::array<std::uint64_t, histogram_buckets>;
+
+    /**
+     * @brief A point in time copy of the contention statistics of one lock.
+     *
+     * Times are in nanoseconds.
+     */
+    struct LockStatistics
+    {
+        std::uint64_t acquisitions = 0;
+        // Acquisitions that had to wait in the queue first.
+        std::uint64_t contended_acquisitions = 0;
+        std::uint64_t total_wait_ns = 0;
+        std::uint64_t max_wait_ns = 0;
+        Histogram hold_time_histogram{};
+        std::uint64_t max_queue_depth = 0;
+        // Waiters that were woken up but found the lock taken and had to go back to waiting.
+        std::uint64_t spurious_wakeups = 0;
+        // Acquisitions that spun until the lock was released instead of waiting in the queue.
+        std::uint64_t spin_acquisitions = 0;
+    };
+
+#ifdef COLITE_INSTRUMENT
+    /**
+     * @brief Counters of one primitive, updated with relaxed atomics.
+     */
+    class Counters
+    {
+        std::atomic<std::uint64_t> allocations_{0};
+        std::atomic<std::uint64_t> executor_posts_{0};
+        std::atomic<std::uint64_t> spurious_wakeups_{0};
+        std::atomic<std::uint64_t> requeues_{0};
+
+    public:
+        void allocation(std::uint64_t count = 1) noexcept {
+            allocations_.fetch_add(count, std::memory_order_relaxed);
+        }
+        void executor_post() noexcept {
+            executor_posts_.fetch_add(1, std::memory_order_relaxed);
+        }
+        void spurious_wakeup() noexcept {
+            spurious_wakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+        void requeue() noexcept {
+            requeues_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] Snapshot snapshot() const noexcept {
+            return Snapshot{
+                allocations_.load(std::memory_order_relaxed),
+                executor_posts_.load(std::memory_order_relaxed),
+                spurious_wakeups_.load(std::memory_order_relaxed),
+                requeues_.load(std::memory_order_relaxed),
+            };
+        }
+    };
+
+    /**
+     * @brief Measures the time since `start()`.
+     */
+    class Stopwatch
+    {
+        std::chrono::steady_clock::time_point start_;
+
+    public:
+        void start() noexcept {
+            start_ = std::chrono::steady_clock::now();
+        }
+
+        [[nodiscard]] std::uint64_t elapsed_ns() const noexcept {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    };
+
+    /**
+     * @brief Atomic counterpart of `Histogram`.
+     */
+    class HistogramCounters
+    {
+        std::array<std::atomic<std::uint64_t>, histogram_buckets> buckets_{};
+
+    public:
+        void record(std::uint64_t ns) noexcept {
+            std::size_t bucket = 0;
+            while (ns > 1 && bucket + 1 < histogram_buckets) {
+                ns >>= 1;
+                bucket++;
+            }
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] Histogram snapshot() const noexcept {
+            Histogram retval;
+            for (std::size_t i = 0; i < histogram_buckets; i++) {
+                retval[i] = buckets_[i].load(std::memory_order_relaxed);
+            }
+            return retval;
+        }
+    };
+
+    /**
+     * @brief A `std::allocator` that counts every allocation it makes on `Counters`, for containers of a primitive.
+     */
+    template<class T>
+    class CountingAllocator
+    {
+        template<class U>
+        friend class CountingAllocator;
+
+        Counters *counters_;
+
+    public:
+        using value_type = T;
+
+        explicit CountingAllocator(Counters &counters) noexcept : counters_(&counters) {}
+        template<class U>
+        CountingAllocator(const CountingAllocator<U> &other) noexcept : counters_(other.counters_) {}
+
+        [[nodiscard]] T *allocate(std::size_t n) {
+            counters_->allocation();
+            return std::allocator<T>{}.allocate(n);
+        }
+        void deallocate(T *p, std::size_t n) noexcept {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template<class U>
+        friend bool operator==(const CountingAllocator &lhs, const CountingAllocator<U> &rhs) noexcept {
+            return lhs.counters_ == rhs.counters_;
+        }
+    };
+
+    /**
+     * @brief Contention counters of one lock, updated with relaxed atomics so they can be polled at any time.
+     */
+    class LockCounters
+    {
+        std::atomic<std::uint64_t> acquisitions_{0};
+        std::atomic<std::uint64_t> contended_acquisitions_{0};
+        std::atomic<std::uint64_t> total_wait_ns_{0};
+        std::atomic<std::uint64_t> max_wait_ns_{0};
+        HistogramCounters hold_time_histogram_;
+        std::atomic<std::uint64_t> max_queue_depth_{0};
+        std::atomic<std::uint64_t> spin_acquisitions_{0};
+
+        static void update_max(std::atomic<std::uint64_t> &max, std::uint64_t value) noexcept {
+            auto current = max.load(std::memory_order_relaxed);
+            while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+
+    public:
+        void acquired() noexcept {
+            acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        void acquired_after_wait(std::uint64_t wait_ns) noexcept {
+            acquisitions_.fetch_add(1, std::memory_order_relaxed);
+            contended_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+            total_wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+            update_max(max_wait_ns_, wait_ns);
+        }
+        void released(std::uint64_t hold_ns) noexcept {
+            hold_time_histogram_.record(hold_ns);
+        }
+        void queue_depth(std::size_t depth) noexcept {
+            update_max(max_queue_depth_, depth);
+        }
+        void spun() noexcept {
+            spin_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] LockStatistics snapshot() const noexcept {
+            LockStatistics retval;
+            retval.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+            retval.contended_acquisitions = contended_acquisitions_.load(std::memory_order_relaxed);
+            retval.total_wait_ns = total_wait_ns_.load(std::memory_order_relaxed);
+            retval.max_wait_ns = max_wait_ns_.load(std::memory_order_relaxed);
+            retval.hold_time_histogram = hold_time_histogram_.snapshot();
+            retval.max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+            retval.spin_acquisitions = spin_acquisitions_.load(std::memory_order_relaxed);
+            return retval;
+        }
+    };
+#else
+    class Counters
+    {
+    public:
+        void allocation(std::uint64_t = 1) noexcept {}
+        void executor_post() noexcept {}
+        void spurious_wakeup() noexcept {}
+        void requeue() noexcept {}
+
+        [[nodiscard]] Snapshot snapshot() const noexcept {
+            return {};
+        }
+    };
+
+    class Stopwatch
+    {
+    public:
+        void start() noexcept {}
+
+        [[nodiscard]] std::uint64_t elapsed_ns() const noexcept {
+            return 0;
+        }
+    };
+
+    class HistogramCounters
+    {
+    public:
+        void record(std::uint64_t) noexcept {}
+
+        [[nodiscard]] Histogram snapshot() const noexcept {
+            return {};
+        }
+    };
+
+    template<class T>
+    class CountingAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit CountingAllocator(Counters &) noexcept {}
+        template<class U>
+        CountingAllocator(const CountingAllocator<U> &) noexcept {}
+
+        [[nodiscard]] T *allocate(std::size_t n) {
+            return std::allocator<T>{}.allocate(n);
+        }
+        void deallocate(T *p, std::size_t n) noexcept {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template<class U>
+        friend bool operator==(const CountingAllocator &, const CountingAllocator<U> &) noexcept {
+            return true;
+        }
+    };
+
+    class LockCounters
+    {
+    public:
+        void acquired() noexcept {}
+        void acquired_after_wait(std::uint64_t) noexcept {}
+        void released(std::uint64_t) noexcept {}
+        void queue_depth(std::size_t) noexcept {}
+        void spun() noexcept {}
+
+        [[nodiscard]] LockStatistics snapshot() const noexcept {
+            return {};
+        }
+    };
+#endif
+}// namespace colite::instrument
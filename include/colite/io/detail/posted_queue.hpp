@@ -0,0 +1,113 @@
+#pragma once
+
+/**
+ * @file
+ * @brief The queue of functions posted to the run loop of an I/O context.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace colite::io::detail {
+    /**
+     * Functions posted to `EpollReactor` and `UringContext`, run in batches by their loops.
+     *
+     * Functions posted from the loop thread go to a local queue without taking the lock. Functions posted from other
+     * threads go to a locked queue, and only the first one posted since the loop last ran them asks the caller to wake
+     * the loop up.
+     */
+    class posted_queue {
+        // Posted from the loop thread itself, no lock needed.
+        std::deque<std::function<void()>> local_;
+        std::atomic<std::thread::id> loop_thread_{};
+
+        // Posted from other threads.
+        std::mutex mutex_;
+        std::deque<std::function<void()>> remote_;
+        bool wakeup_pending_ = false;
+
+        std::vector<std::function<void()>> batch_;
+
+    public:
+        /**
+         * Marks the calling thread as the loop thread until it is destroyed.
+         */
+        class loop_scope {
+            posted_queue *queue_;
+
+        public:
+            explicit loop_scope(posted_queue &queue) noexcept : queue_(&queue) {
+                queue_->loop_thread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+            }
+            loop_scope(const loop_scope &) = delete;
+            loop_scope &operator=(const loop_scope &) = delete;
+            ~loop_scope() {
+                queue_->loop_thread_.store(std::thread::id{}, std::memory_order_relaxed);
+            }
+        };
+
+        /**
+         * Queues `fn`. Returns true if the caller has to wake the loop up.
+         */
+        [[nodiscard]] bool post(std::function<void()> fn) {
+            if (loop_thread_.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+                local_.push_back(std::move(fn));
+                return false;
+            }
+            std::scoped_lock lock{mutex_};
+            remote_.push_back(std::move(fn));
+            return !std::exchange(wakeup_pending_, true);
+        }
+
+        /**
+         * Runs the functions that were posted before the call, on the loop thread. Returns how many ran.
+         *
+         * If one of them throws the exception propagates, and the functions after it run first thing in the next call.
+         */
+        std::size_t run() {
+            {
+                std::scoped_lock lock{mutex_};
+                wakeup_pending_ = false;
+                for (auto &fn : remote_) {
+                    batch_.push_back(std::move(fn));
+                }
+                remote_.clear();
+            }
+            for (auto &fn : local_) {
+                batch_.push_back(std::move(fn));
+            }
+            local_.clear();
+
+            // Drops the functions that were called, even when one of them throws, so none is called twice.
+            struct erase_called {
+                std::vector<std::function<void()>> &batch_;
+                std::size_t called_ = 0;
+                ~erase_called() {
+                    batch_.erase(batch_.begin(), batch_.begin() + static_cast<std::ptrdiff_t>(called_));
+                }
+            } called{batch_};
+            while (called.called_ < batch_.size()) {
+                auto fn = std::move(batch_[called.called_++]);
+                fn();
+            }
+            return called.called_;
+        }
+
+        /**
+         * True if nothing is waiting to be run, on the loop thread.
+         */
+        [[nodiscard]] bool empty() {
+            if (!local_.empty()) {
+                return false;
+            }
+            std::scoped_lock lock{mutex_};
+            return remote_.empty();
+        }
+    };
+}// namespace colite::io::detail
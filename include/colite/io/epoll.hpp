@@ -0,0 +1,409 @@
+#pragma once
+
+/**
+ * @file
+ * @brief An epoll based reactor and executor.
+ *
+ * `EpollReactor` is the readiness based counterpart of `UringContext`, for kernels where io_uring is missing or
+ * disabled. Instead of performing the I/O it tells a coroutine when a non-blocking file descriptor has become readable
+ * or writable, the coroutine then does the I/O itself until it would block.
+ *
+ * Descriptors are registered edge-triggered for both directions the first time they are awaited, so each descriptor
+ * costs a single `epoll_ctl` call for its whole lifetime. Readiness that arrives while nobody is waiting is remembered,
+ * and the next `readable`/`writable` completes right away.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * task echo(colite::io::EpollReactor &reactor, int fd) {
+ *     std::array<char, 4096> buffer;
+ *     for (;;) {
+ *         auto read = ::read(fd, buffer.data(), buffer.size());
+ *         if (read < 0 && errno == EAGAIN) {
+ *             co_await reactor.readable(fd);
+ *             continue;
+ *         }
+ *         if (read <= 0) {
+ *             break;
+ *         }
+ *         ::write(fd, buffer.data(), read);
+ *     }
+ *     reactor.deregister(fd);
+ *     ::close(fd);
+ * }
+ * ```
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <colite/detail/intrusive_list.hpp>
+#include <colite/executor/executor.hpp>
+#include <colite/expected.hpp>
+#include <colite/io/detail/posted_queue.hpp>
+#include <colite/trace/trace.hpp>
+
+namespace colite::io {
+    class EpollReactor;
+
+    namespace detail {
+        // A coroutine waiting for a descriptor to become ready. Lives in the awaitable, so waiting doesn't allocate.
+        struct epoll_waiter: colite::detail::intrusive_list_hook<epoll_waiter> {
+            std::coroutine_handle<> waiting_coro_;
+            // The list the waiter is linked into, either a descriptor's or the reactor's ready list.
+            colite::detail::intrusive_list<epoll_waiter> *list_ = nullptr;
+            std::error_code error_;
+        };
+
+        struct epoll_descriptor {
+            int fd_;
+            // Events reported while no one was waiting for them.
+            std::uint32_t ready_ = 0;
+            colite::detail::intrusive_list<epoll_waiter> readers_;
+            colite::detail::intrusive_list<epoll_waiter> writers_;
+
+            explicit epoll_descriptor(int fd) noexcept : fd_(fd) {}
+        };
+    }// namespace detail
+
+    /**
+     * @brief Executor that runs functions on the loop of an `EpollReactor`.
+     *
+     * Cheap to copy, it only refers to the reactor. The reactor must outlive all its executors.
+     */
+    class EpollExecutor {
+        EpollReactor *reactor_;
+
+    public:
+        explicit EpollExecutor(EpollReactor &reactor) noexcept : reactor_(&reactor) {}
+
+        friend bool operator==(const EpollExecutor &lhs, const EpollExecutor &rhs) noexcept {
+            return lhs.reactor_ == rhs.reactor_;
+        }
+
+        template<std::invocable Func>
+        void execute(Func &&f) const;
+    };
+
+    /**
+     * @brief An epoll instance with a run loop that is also an executor.
+     *
+     * The loop runs on whichever thread calls `run()`, `run_once()` or `poll()`, and only one thread may do so at a
+     * time. Functions can be posted to `executor()` from any thread, functions posted from the loop thread skip the
+     * lock and the eventfd. Awaitables must be created, awaited and destroyed on the loop thread, and resume their
+     * coroutine on it.
+     *
+     * Descriptors must be non-blocking. Since they are registered edge-triggered, a coroutine should keep reading or
+     * writing until the call fails with `EAGAIN` before it awaits the same direction again.
+     */
+    class EpollReactor {
+        static constexpr std::uint32_t read_events = EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR;
+        static constexpr std::uint32_t write_events = EPOLLOUT | EPOLLHUP | EPOLLERR;
+
+        int epoll_fd_ = -1;
+        std::vector<::epoll_event> events_;
+        std::unordered_map<int, std::unique_ptr<detail::epoll_descriptor>> descriptors_;
+        // Waiters whose descriptor is ready, resumed by the loop.
+        colite::detail::intrusive_list<detail::epoll_waiter> ready_;
+
+        // Functions posted from other threads write to wakeup_fd_ to interrupt a waiting loop.
+        detail::posted_queue posted_;
+        int wakeup_fd_ = -1;
+        std::atomic<bool> stopped_{false};
+
+        static void check(bool ok, const char *what) {
+            if (!ok) {
+                throw std::system_error(errno, std::system_category(), what);
+            }
+        }
+
+        void close() noexcept {
+            if (wakeup_fd_ >= 0) {
+                ::close(wakeup_fd_);
+            }
+            if (epoll_fd_ >= 0) {
+                ::close(epoll_fd_);
+            }
+        }
+
+        void wakeup() {
+            std::uint64_t one = 1;
+            [[maybe_unused]] auto written = ::write(wakeup_fd_, &one, sizeof(one));
+        }
+
+        colite::Expected<detail::epoll_descriptor *, std::error_code> descriptor(int fd) {
+            auto it = descriptors_.find(fd);
+            if (it != descriptors_.end()) {
+                return it->second.get();
+            }
+            auto desc = std::make_unique<detail::epoll_descriptor>(fd);
+            ::epoll_event event{};
+            event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            event.data.ptr = desc.get();
+            if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+                return colite::Unexpected(std::error_code(errno, std::system_category()));
+            }
+            return descriptors_.emplace(fd, std::move(desc)).first->second.get();
+        }
+
+        void make_ready(colite::detail::intrusive_list<detail::epoll_waiter> &waiters) noexcept {
+            while (auto *waiter = waiters.pop_front()) {
+                waiter->list_ = &ready_;
+                ready_.push_back(*waiter);
+            }
+        }
+
+        void dispatch(detail::epoll_descriptor &desc, std::uint32_t events) noexcept {
+            // Readiness no one is waiting for is kept for the next awaitable.
+            if (events & read_events) {
+                if (desc.readers_.empty()) {
+                    desc.ready_ |= EPOLLIN;
+                }
+                make_ready(desc.readers_);
+            }
+            if (events & write_events) {
+                if (desc.writers_.empty()) {
+                    desc.ready_ |= EPOLLOUT;
+                }
+                make_ready(desc.writers_);
+            }
+        }
+
+        std::size_t resume_ready() {
+            std::size_t count = 0;
+            // A resumed coroutine may destroy other ready waiters, they unlink themselves.
+            while (auto *waiter = ready_.pop_front()) {
+                waiter->list_ = nullptr;
+                trace::emit(trace::Phase::Schedule, "io::epoll", this, waiter->waiting_coro_);
+                trace::emit(trace::Phase::Resume, "io::epoll", this, waiter->waiting_coro_);
+                waiter->waiting_coro_.resume();
+                count++;
+            }
+            return count;
+        }
+
+        std::size_t wait(bool block) {
+            int ready;
+            do {
+                ready = ::epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), block ? -1 : 0);
+            } while (ready < 0 && errno == EINTR);
+            check(ready >= 0, "epoll_wait");
+
+            std::size_t count = 0;
+            for (int i = 0; i < ready; i++) {
+                auto *desc = static_cast<detail::epoll_descriptor *>(events_[i].data.ptr);
+                if (desc == nullptr) {
+                    std::uint64_t value;
+                    [[maybe_unused]] auto read = ::read(wakeup_fd_, &value, sizeof(value));
+                    continue;
+                }
+                dispatch(*desc, events_[i].events);
+                count++;
+            }
+            return count;
+        }
+
+        std::size_t run_once(bool block) {
+            detail::posted_queue::loop_scope loop{posted_};
+            auto count = posted_.run();
+            count += resume_ready();
+            bool idle = posted_.empty() && ready_.empty() && count == 0 && !stopped_.load(std::memory_order_relaxed);
+            count += wait(block && idle);
+            count += resume_ready();
+            return count;
+        }
+
+        template<std::uint32_t Event>
+        class awaitable {
+            EpollReactor *reactor_;
+            int fd_;
+            detail::epoll_waiter waiter_;
+
+            auto &waiters(detail::epoll_descriptor &desc) noexcept {
+                if constexpr (Event == EPOLLIN) {
+                    return desc.readers_;
+                } else {
+                    return desc.writers_;
+                }
+            }
+
+        public:
+            awaitable(EpollReactor &reactor, int fd) noexcept : reactor_(&reactor), fd_(fd) {}
+            awaitable(const awaitable &) = delete;
+            awaitable &operator=(const awaitable &) = delete;
+            ~awaitable() {
+                if (waiter_.list_) {
+                    waiter_.list_->erase(waiter_);
+                }
+            }
+
+            bool await_ready() {
+                auto desc = reactor_->descriptor(fd_);
+                if (!desc) {
+                    waiter_.error_ = desc.error();
+                    return true;
+                }
+                if ((*desc)->ready_ & Event) {
+                    (*desc)->ready_ &= ~Event;
+                    return true;
+                }
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> to_suspend) {
+                waiter_.waiting_coro_ = to_suspend;
+                auto &list = waiters(*reactor_->descriptors_.at(fd_));
+                waiter_.list_ = &list;
+                list.push_back(waiter_);
+                trace::emit(trace::Phase::Suspend, "io::epoll", reactor_, to_suspend);
+            }
+
+            colite::Expected<void, std::error_code> await_resume() const {
+                if (waiter_.error_) {
+                    return colite::Unexpected(waiter_.error_);
+                }
+                return {};
+            }
+        };
+
+    public:
+        /**
+         * @brief Create a reactor that handles up to `max_events` ready descriptors per `epoll_wait`.
+         * @throws std::system_error if the epoll instance or its eventfd can't be created.
+         */
+        explicit EpollReactor(std::size_t max_events = 64) : events_(max_events == 0 ? 1 : max_events) {
+            try {
+                epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+                check(epoll_fd_ >= 0, "epoll_create1");
+                wakeup_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                check(wakeup_fd_ >= 0, "eventfd");
+                ::epoll_event event{};
+                event.events = EPOLLIN | EPOLLET;
+                event.data.ptr = nullptr;
+                check(::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) == 0, "epoll_ctl");
+            } catch (...) {
+                close();
+                throw;
+            }
+        }
+
+        EpollReactor(const EpollReactor &) = delete;
+        EpollReactor &operator=(const EpollReactor &) = delete;
+
+        /**
+         * Coroutines still waiting are dropped without being resumed.
+         */
+        ~EpollReactor() {
+            close();
+        }
+
+        [[nodiscard]] EpollExecutor executor() noexcept {
+            return EpollExecutor(*this);
+        }
+
+        /**
+         * @brief Run `fn` on the loop thread. Thread-safe.
+         */
+        void post(std::function<void()> fn) {
+            if (posted_.post(std::move(fn))) {
+                wakeup();
+            }
+        }
+
+        /**
+         * @brief Run posted functions and ready coroutines until `stop()` is called.
+         *
+         * Waits in `epoll_wait` while there is nothing to do. Returns right away if `stop()` was called before, and
+         * clears the stop request on return.
+         */
+        void run() {
+            while (!stopped_.load(std::memory_order_relaxed)) {
+                run_once(true);
+            }
+            stopped_.store(false, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Run the posted functions and resume the coroutines whose descriptors are ready. Waits if there was
+         * nothing to do.
+         * @return The number of functions run, coroutines resumed and descriptor events handled.
+         */
+        std::size_t run_once() {
+            return run_once(true);
+        }
+
+        /**
+         * @brief Like `run_once`, but never waits.
+         */
+        std::size_t poll() {
+            return run_once(false);
+        }
+
+        /**
+         * @brief Make `run()` return. Thread-safe.
+         */
+        void stop() {
+            stopped_.store(true, std::memory_order_relaxed);
+            post([] {});
+        }
+
+        /**
+         * @brief Remove `fd` from the reactor, must be called before `fd` is closed.
+         *
+         * Coroutines waiting for `fd` are resumed with `std::errc::operation_canceled`. Does nothing if `fd` was never
+         * awaited.
+         */
+        void deregister(int fd) {
+            auto it = descriptors_.find(fd);
+            if (it == descriptors_.end()) {
+                return;
+            }
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            auto &desc = *it->second;
+            for (auto *list : {&desc.readers_, &desc.writers_}) {
+                list->for_each([](detail::epoll_waiter &waiter) {
+                    waiter.error_ = std::make_error_code(std::errc::operation_canceled);
+                });
+                make_ready(*list);
+            }
+            descriptors_.erase(it);
+        }
+
+        /**
+         * @brief Wait until `fd` is readable, or the peer has hung up or an error is pending.
+         * @return An `AWAITABLE<Expected<void, std::error_code>>`, with an error if `fd` can't be registered or was
+         * deregistered while waiting.
+         */
+        [[nodiscard]] auto readable(int fd) noexcept {
+            return awaitable<EPOLLIN>(*this, fd);
+        }
+
+        /**
+         * @brief Wait until `fd` is writable, or an error is pending.
+         * @return An `AWAITABLE<Expected<void, std::error_code>>`, with an error if `fd` can't be registered or was
+         * deregistered while waiting.
+         */
+        [[nodiscard]] auto writable(int fd) noexcept {
+            return awaitable<EPOLLOUT>(*this, fd);
+        }
+    };
+
+    template<std::invocable Func>
+    void EpollExecutor::execute(Func &&f) const {
+        reactor_->post(std::forward<Func>(f));
+    }
+
+    static_assert(colite::executor::Executor<EpollExecutor>, "epoll executor");
+}// namespace colite::io
@@ -0,0 +1,640 @@
+#pragma once
+
+/**
+ * @file
+ * @brief An io_uring based I/O context and executor.
+ *
+ * `UringContext` owns an io_uring instance and a run loop. The loop runs functions posted to its executor and
+ * resumes coroutines whose I/O has completed, all on the thread that calls `run()`.
+ *
+ * I/O awaitables only fill in a submission queue entry when they are awaited. Everything queued while the loop runs
+ * a batch of work is submitted with a single `io_uring_enter` call, which also waits for the next completion.
+ *
+ * The ring is driven through the kernel interface directly, so liburing is not needed. It requires Linux 5.6 or later.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * task echo(colite::io::UringContext &ctx, int fd) {
+ *     std::array<std::byte, 4096> buffer;
+ *     for (;;) {
+ *         auto read = co_await ctx.recv(fd, buffer);
+ *         if (!read || *read == 0) {
+ *             break;
+ *         }
+ *         co_await ctx.send(fd, std::span(buffer).first(*read));
+ *     }
+ * }
+ *
+ * colite::io::UringContext ctx;
+ * echo(ctx, client_fd).start_on(ctx.executor());
+ * ctx.run();
+ * ```
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <colite/detail/intrusive_list.hpp>
+#include <colite/executor/executor.hpp>
+#include <colite/expected.hpp>
+#include <colite/io/detail/posted_queue.hpp>
+#include <colite/trace/trace.hpp>
+
+namespace colite::io {
+    class UringContext;
+
+    namespace detail {
+        inline int io_uring_setup(unsigned entries, io_uring_params *params) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        inline int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        inline int io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+        }
+
+        // An operation the kernel is working on. It is referenced by the `user_data` of its submission.
+        struct uring_op: colite::detail::intrusive_list_hook<uring_op> {
+            // Keeps the operation alive until the kernel is done with it, even if the awaitable is gone.
+            std::shared_ptr<uring_op> self_;
+            std::coroutine_handle<> waiting_coro_;
+            std::int32_t result_ = 0;
+            // Set when the awaitable is destroyed before the operation completes.
+            bool abandoned_ = false;
+
+            virtual ~uring_op() = default;
+        };
+
+        // The address passed to connect has to stay valid until the kernel has read it.
+        struct connect_op final: uring_op {
+            ::sockaddr_storage address_{};
+        };
+
+        template<class Result>
+        Result make_result(std::int32_t res) {
+            if (res < 0) {
+                return colite::Unexpected(std::error_code(-res, std::system_category()));
+            }
+            if constexpr (std::is_same_v<Result, colite::Expected<void, std::error_code>>) {
+                return {};
+            } else if constexpr (std::is_same_v<Result, colite::Expected<int, std::error_code>>) {
+                return res;
+            } else {
+                return static_cast<std::size_t>(res);
+            }
+        }
+
+        // The mapped submission and completion queues of a ring.
+        class uring {
+            int fd_ = -1;
+            io_uring_params params_{};
+            void *sq_ptr_ = MAP_FAILED;
+            std::size_t sq_size_ = 0;
+            void *cq_ptr_ = MAP_FAILED;
+            std::size_t cq_size_ = 0;
+            io_uring_sqe *sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+
+            std::atomic_ref<unsigned> sq_head() const noexcept {
+                return std::atomic_ref(*at<unsigned>(sq_ptr_, params_.sq_off.head));
+            }
+            std::atomic_ref<unsigned> sq_tail() const noexcept {
+                return std::atomic_ref(*at<unsigned>(sq_ptr_, params_.sq_off.tail));
+            }
+            std::atomic_ref<unsigned> cq_head() const noexcept {
+                return std::atomic_ref(*at<unsigned>(cq_ptr_, params_.cq_off.head));
+            }
+            std::atomic_ref<unsigned> cq_tail() const noexcept {
+                return std::atomic_ref(*at<unsigned>(cq_ptr_, params_.cq_off.tail));
+            }
+
+            template<class T>
+            static T *at(void *base, std::uint32_t offset) noexcept {
+                return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+            }
+
+            static void check(bool ok, const char *what) {
+                if (!ok) {
+                    throw std::system_error(errno, std::system_category(), what);
+                }
+            }
+
+            void *map(std::size_t size, off_t offset) {
+                auto *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+                check(ptr != MAP_FAILED, "mmap io_uring");
+                return ptr;
+            }
+
+        public:
+            explicit uring(unsigned entries) {
+                fd_ = io_uring_setup(entries, &params_);
+                check(fd_ >= 0, "io_uring_setup");
+                try {
+                    sq_size_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+                    cq_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+                    if (params_.features & IORING_FEAT_SINGLE_MMAP) {
+                        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+                    }
+                    sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+                    cq_ptr_ = (params_.features & IORING_FEAT_SINGLE_MMAP) ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+                    sqes_ = static_cast<io_uring_sqe *>(map(params_.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+                } catch (...) {
+                    close();
+                    throw;
+                }
+            }
+
+            uring(const uring &) = delete;
+            uring &operator=(const uring &) = delete;
+
+            ~uring() {
+                close();
+            }
+
+            // Unmaps the queues and closes the ring, the kernel cancels everything still in flight.
+            void close() noexcept {
+                if (sqes_ != MAP_FAILED) {
+                    ::munmap(sqes_, params_.sq_entries * sizeof(io_uring_sqe));
+                    sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+                }
+                if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+                    ::munmap(cq_ptr_, cq_size_);
+                }
+                cq_ptr_ = MAP_FAILED;
+                if (sq_ptr_ != MAP_FAILED) {
+                    ::munmap(sq_ptr_, sq_size_);
+                    sq_ptr_ = MAP_FAILED;
+                }
+                if (fd_ >= 0) {
+                    ::close(fd_);
+                    fd_ = -1;
+                }
+            }
+
+            [[nodiscard]] int fd() const noexcept {
+                return fd_;
+            }
+
+            // Returns a cleared entry, or nullptr if the submission queue is full.
+            io_uring_sqe *get_sqe() noexcept {
+                auto tail = sq_tail().load(std::memory_order_relaxed);
+                if (tail - sq_head().load(std::memory_order_acquire) == params_.sq_entries) {
+                    return nullptr;
+                }
+                auto index = tail & *at<unsigned>(sq_ptr_, params_.sq_off.ring_mask);
+                at<unsigned>(sq_ptr_, params_.sq_off.array)[index] = index;
+                auto *sqe = &sqes_[index];
+                std::memset(sqe, 0, sizeof(*sqe));
+                // Published to the kernel by the next io_uring_enter.
+                sq_tail().store(tail + 1, std::memory_order_release);
+                return sqe;
+            }
+
+            [[nodiscard]] unsigned entries() const noexcept {
+                return params_.sq_entries;
+            }
+
+            // Entries queued since the last call to enter.
+            [[nodiscard]] unsigned unsubmitted() const noexcept {
+                return sq_tail().load(std::memory_order_relaxed) - sq_head().load(std::memory_order_acquire);
+            }
+
+            // Submits everything queued and, if `wait` is set, waits for at least one completion.
+            void enter(bool wait) {
+                for (;;) {
+                    auto to_submit = unsubmitted();
+                    if (to_submit == 0 && !wait) {
+                        return;
+                    }
+                    auto res = io_uring_enter(fd_, to_submit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+                    if (res >= 0 || errno == EBUSY || errno == EAGAIN) {
+                        // Busy means the completion queue is full, the caller reaps it before entering again.
+                        return;
+                    }
+                    check(errno == EINTR, "io_uring_enter");
+                }
+            }
+
+            // Calls `fn(user_data, res)` for every completion that is ready. Returns the number of completions.
+            //
+            // `fn` may reap again, for instance when a resumed coroutine has to make room in a full submission queue,
+            // so the head is read back before every entry instead of being kept across calls to `fn`.
+            template<class Fn>
+            std::size_t reap(Fn &&fn) {
+                std::size_t count = 0;
+                auto mask = *at<unsigned>(cq_ptr_, params_.cq_off.ring_mask);
+                auto *cqes = at<io_uring_cqe>(cq_ptr_, params_.cq_off.cqes);
+                for (;;) {
+                    auto head = cq_head().load(std::memory_order_relaxed);
+                    if (head == cq_tail().load(std::memory_order_acquire)) {
+                        return count;
+                    }
+                    auto cqe = cqes[head & mask];
+                    // Hand the slot back before running the handler, it may submit and complete more work.
+                    cq_head().store(head + 1, std::memory_order_release);
+                    fn(cqe.user_data, cqe.res);
+                    count++;
+                }
+            }
+        };
+    }// namespace detail
+
+    /**
+     * @brief Executor that runs functions on the loop of a `UringContext`.
+     *
+     * Cheap to copy, it only refers to the context. The context must outlive all its executors.
+     */
+    class UringExecutor {
+        UringContext *context_;
+
+    public:
+        explicit UringExecutor(UringContext &context) noexcept : context_(&context) {}
+
+        friend bool operator==(const UringExecutor &lhs, const UringExecutor &rhs) noexcept {
+            return lhs.context_ == rhs.context_;
+        }
+
+        template<std::invocable Func>
+        void execute(Func &&f) const;
+    };
+
+    /**
+     * @brief An io_uring instance with a run loop that is also an executor.
+     *
+     * The loop runs on whichever thread calls `run()`, `run_once()` or `poll()`, and only one thread may do so at a
+     * time. Functions can be posted to `executor()` from any thread. I/O awaitables must be created, awaited and
+     * destroyed on the loop thread, and resume their coroutine on it.
+     *
+     * Buffers passed to an operation must stay valid until it completes. Destroying an awaitable before its operation
+     * has completed asks the kernel to cancel it, but the kernel may still touch the buffer until then.
+     */
+    class UringContext {
+        // `user_data` of submissions that aren't operations. Operations are at least pointer aligned.
+        static constexpr std::uint64_t ignore_tag = 0;
+        static constexpr std::uint64_t wakeup_tag = 1;
+
+        detail::uring ring_;
+        colite::detail::intrusive_list<detail::uring_op> in_flight_;
+
+        // Functions posted from other threads write to wakeup_fd_ to interrupt a waiting loop.
+        detail::posted_queue posted_;
+        int wakeup_fd_ = -1;
+        std::uint64_t wakeup_value_ = 0;
+        bool wakeup_armed_ = false;
+        std::atomic<bool> stopped_{false};
+
+        io_uring_sqe *get_sqe() {
+            for (;;) {
+                if (auto *sqe = ring_.get_sqe()) {
+                    return sqe;
+                }
+                // Full, make room by submitting what is queued. This is usually called from a coroutine resumed by
+                // reap, so completions are only reaped here if the kernel took nothing because its completion
+                // queue is full.
+                ring_.enter(false);
+                if (ring_.unsubmitted() == ring_.entries()) {
+                    reap();
+                }
+            }
+        }
+
+        void arm_wakeup() {
+            if (wakeup_armed_) {
+                return;
+            }
+            auto *sqe = get_sqe();
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = wakeup_fd_;
+            sqe->addr = reinterpret_cast<std::uint64_t>(&wakeup_value_);
+            sqe->len = sizeof(wakeup_value_);
+            sqe->user_data = wakeup_tag;
+            wakeup_armed_ = true;
+        }
+
+        void wakeup() {
+            std::uint64_t one = 1;
+            [[maybe_unused]] auto written = ::write(wakeup_fd_, &one, sizeof(one));
+        }
+
+        void complete(std::uint64_t user_data, std::int32_t res) {
+            if (user_data == ignore_tag) {
+                return;
+            }
+            if (user_data == wakeup_tag) {
+                wakeup_armed_ = false;
+                return;
+            }
+            auto *op = reinterpret_cast<detail::uring_op *>(user_data);
+            in_flight_.erase(*op);
+            auto self = std::move(op->self_);
+            if (op->abandoned_) {
+                return;
+            }
+            op->result_ = res;
+            trace::emit(trace::Phase::Schedule, "io::uring", this, op->waiting_coro_);
+            trace::emit(trace::Phase::Resume, "io::uring", this, op->waiting_coro_);
+            op->waiting_coro_.resume();
+        }
+
+        std::size_t reap() {
+            return ring_.reap([this](std::uint64_t user_data, std::int32_t res) {
+                complete(user_data, res);
+            });
+        }
+
+        std::size_t run_once(bool wait) {
+            detail::posted_queue::loop_scope loop{posted_};
+            auto count = posted_.run();
+            count += reap();
+            arm_wakeup();
+            bool idle = posted_.empty() && count == 0 && !stopped_.load(std::memory_order_relaxed);
+            ring_.enter(wait && idle);
+            count += reap();
+            return count;
+        }
+
+    public:
+        /**
+         * @brief Create a ring with room for `entries` queued submissions.
+         * @throws std::system_error if the ring can't be created, for instance if io_uring is disabled.
+         */
+        explicit UringContext(unsigned entries = 256) : ring_(entries) {
+            wakeup_fd_ = ::eventfd(0, EFD_CLOEXEC);
+            if (wakeup_fd_ < 0) {
+                throw std::system_error(errno, std::system_category(), "eventfd");
+            }
+        }
+
+        UringContext(const UringContext &) = delete;
+        UringContext &operator=(const UringContext &) = delete;
+
+        /**
+         * Operations still in flight are dropped without resuming their coroutines.
+         */
+        ~UringContext() {
+            ring_.close();
+            while (auto *op = in_flight_.pop_front()) {
+                op->self_.reset();
+            }
+            ::close(wakeup_fd_);
+        }
+
+        [[nodiscard]] UringExecutor executor() noexcept {
+            return UringExecutor(*this);
+        }
+
+        /**
+         * @brief Run `fn` on the loop thread. Thread-safe.
+         */
+        void post(std::function<void()> fn) {
+            if (posted_.post(std::move(fn))) {
+                wakeup();
+            }
+        }
+
+        /**
+         * @brief Run posted functions and completions until `stop()` is called.
+         *
+         * Waits in the kernel while there is nothing to do. Returns right away if `stop()` was called before, and
+         * clears the stop request on return.
+         */
+        void run() {
+            while (!stopped_.load(std::memory_order_relaxed)) {
+                run_once(true);
+            }
+            stopped_.store(false, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Run the posted functions, submit queued I/O and handle completions. Waits if there was nothing to do.
+         * @return The number of functions run and completions handled.
+         */
+        std::size_t run_once() {
+            return run_once(true);
+        }
+
+        /**
+         * @brief Like `run_once`, but never waits.
+         */
+        std::size_t poll() {
+            return run_once(false);
+        }
+
+        /**
+         * @brief Make `run()` return. Thread-safe.
+         */
+        void stop() {
+            stopped_.store(true, std::memory_order_relaxed);
+            post([] {});
+        }
+
+        /**
+         * @brief Register buffers for `read_fixed` and `write_fixed`.
+         *
+         * Registered buffers are pinned once instead of on every operation. Only one set can be registered at a time.
+         */
+        colite::Expected<void, std::error_code> register_buffers(std::span<const ::iovec> buffers) {
+            if (detail::io_uring_register(ring_.fd(), IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) < 0) {
+                return colite::Unexpected(std::error_code(errno, std::system_category()));
+            }
+            return {};
+        }
+
+        colite::Expected<void, std::error_code> unregister_buffers() {
+            if (detail::io_uring_register(ring_.fd(), IORING_UNREGISTER_BUFFERS, nullptr, 0) < 0) {
+                return colite::Unexpected(std::error_code(errno, std::system_category()));
+            }
+            return {};
+        }
+
+    private:
+        template<class Result, class Op, class Prep>
+        class awaitable {
+            UringContext *context_;
+            std::shared_ptr<Op> op_;
+            Prep prep_;
+
+        public:
+            awaitable(UringContext &context, Prep prep) : context_(&context), op_(std::make_shared<Op>()), prep_(std::move(prep)) {}
+            awaitable(awaitable &&) noexcept = default;
+            ~awaitable() {
+                if (op_ && op_->self_) {
+                    op_->abandoned_ = true;
+                    context_->cancel(*op_);
+                }
+            }
+
+            static constexpr bool await_ready() noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> to_suspend) {
+                op_->waiting_coro_ = to_suspend;
+                auto *sqe = context_->get_sqe();
+                prep_(*op_, *sqe);
+                sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<detail::uring_op *>(op_.get()));
+                op_->self_ = op_;
+                context_->in_flight_.push_back(*op_);
+                trace::emit(trace::Phase::Suspend, "io::uring", context_, to_suspend);
+            }
+
+            Result await_resume() const {
+                return detail::make_result<Result>(op_->result_);
+            }
+        };
+
+        template<class Result, class Op = detail::uring_op, class Prep>
+        auto submit(Prep prep) {
+            return awaitable<Result, Op, Prep>(*this, std::move(prep));
+        }
+
+        void cancel(detail::uring_op &op) {
+            auto *sqe = get_sqe();
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = reinterpret_cast<std::uint64_t>(&op);
+            sqe->user_data = ignore_tag;
+        }
+
+        static void prep_rw(io_uring_sqe &sqe, std::uint8_t opcode, int fd, const void *addr, std::size_t len, std::uint64_t offset) noexcept {
+            sqe.opcode = opcode;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(addr);
+            sqe.len = static_cast<std::uint32_t>(len);
+            sqe.off = offset;
+        }
+
+    public:
+        using size_result = colite::Expected<std::size_t, std::error_code>;
+
+        // Reads and writes at the current file position when used as offset.
+        static constexpr std::uint64_t current_position = static_cast<std::uint64_t>(-1);
+
+        /**
+         * @brief Read up to `buffer.size()` bytes from `fd`.
+         * @return An `AWAITABLE<Expected<std::size_t, std::error_code>>` with the number of bytes read, 0 at end of file.
+         */
+        [[nodiscard]] auto read(int fd, std::span<std::byte> buffer, std::uint64_t offset = current_position) {
+            return submit<size_result>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_READ, fd, buffer.data(), buffer.size(), offset);
+            });
+        }
+
+        /**
+         * @brief Write up to `buffer.size()` bytes to `fd`.
+         * @return An `AWAITABLE<Expected<std::size_t, std::error_code>>` with the number of bytes written.
+         */
+        [[nodiscard]] auto write(int fd, std::span<const std::byte> buffer, std::uint64_t offset = current_position) {
+            return submit<size_result>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_WRITE, fd, buffer.data(), buffer.size(), offset);
+            });
+        }
+
+        /**
+         * @brief `read` into a part of the registered buffer `buffer_index`.
+         */
+        [[nodiscard]] auto read_fixed(int fd, std::span<std::byte> buffer, unsigned buffer_index, std::uint64_t offset = current_position) {
+            return submit<size_result>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_READ_FIXED, fd, buffer.data(), buffer.size(), offset);
+                sqe.buf_index = static_cast<std::uint16_t>(buffer_index);
+            });
+        }
+
+        /**
+         * @brief `write` from a part of the registered buffer `buffer_index`.
+         */
+        [[nodiscard]] auto write_fixed(int fd, std::span<const std::byte> buffer, unsigned buffer_index, std::uint64_t offset = current_position) {
+            return submit<size_result>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_WRITE_FIXED, fd, buffer.data(), buffer.size(), offset);
+                sqe.buf_index = static_cast<std::uint16_t>(buffer_index);
+            });
+        }
+
+        /**
+         * @brief Receive up to `buffer.size()` bytes from the socket `fd`.
+         * @return An `AWAITABLE<Expected<std::size_t, std::error_code>>` with the number of bytes received, 0 once the
+         * peer has shut down.
+         */
+        [[nodiscard]] auto recv(int fd, std::span<std::byte> buffer, int flags = 0) {
+            return submit<size_result>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_RECV, fd, buffer.data(), buffer.size(), 0);
+                sqe.msg_flags = static_cast<std::uint32_t>(flags);
+            });
+        }
+
+        /**
+         * @brief Send up to `buffer.size()` bytes on the socket `fd`.
+         * @return An `AWAITABLE<Expected<std::size_t, std::error_code>>` with the number of bytes sent.
+         */
+        [[nodiscard]] auto send(int fd, std::span<const std::byte> buffer, int flags = 0) {
+            return submit<size_result>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_SEND, fd, buffer.data(), buffer.size(), 0);
+                sqe.msg_flags = static_cast<std::uint32_t>(flags | MSG_NOSIGNAL);
+            });
+        }
+
+        /**
+         * @brief Accept a connection on the listening socket `fd`.
+         * @return An `AWAITABLE<Expected<int, std::error_code>>` with the connected socket, created with `SOCK_CLOEXEC`.
+         */
+        [[nodiscard]] auto accept(int fd) {
+            return submit<colite::Expected<int, std::error_code>>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_ACCEPT, fd, nullptr, 0, 0);
+                sqe.accept_flags = SOCK_CLOEXEC;
+            });
+        }
+
+        /**
+         * @brief Connect the socket `fd` to `address`.
+         * @return An `AWAITABLE<Expected<void, std::error_code>>`.
+         *
+         * The address is copied, it doesn't have to outlive the call.
+         */
+        [[nodiscard]] auto connect(int fd, const ::sockaddr *address, ::socklen_t length) {
+            ::sockaddr_storage copy{};
+            std::memcpy(&copy, address, std::min<std::size_t>(length, sizeof(copy)));
+            return submit<colite::Expected<void, std::error_code>, detail::connect_op>([=](detail::uring_op &op, io_uring_sqe &sqe) {
+                auto &connect = static_cast<detail::connect_op &>(op);
+                connect.address_ = copy;
+                prep_rw(sqe, IORING_OP_CONNECT, fd, &connect.address_, 0, length);
+            });
+        }
+
+        /**
+         * @brief Flush the data and metadata of `fd` to storage.
+         * @return An `AWAITABLE<Expected<void, std::error_code>>`.
+         */
+        [[nodiscard]] auto fsync(int fd) {
+            return submit<colite::Expected<void, std::error_code>>([=](detail::uring_op &, io_uring_sqe &sqe) {
+                prep_rw(sqe, IORING_OP_FSYNC, fd, nullptr, 0, 0);
+            });
+        }
+    };
+
+    template<std::invocable Func>
+    void UringExecutor::execute(Func &&f) const {
+        context_->post(std::forward<Func>(f));
+    }
+
+    static_assert(colite::executor::Executor<UringExecutor>, "uring executor");
+}// namespace colite::io
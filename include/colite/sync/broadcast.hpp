@@ -0,0 +1,352 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Contains data and functions to create an asynchronous broadcast channel
+ *
+ * A broadcast channel delivers every sent value to every receiver. Values are stored once in a fixed-size ring
+ * shared by all receivers, and each receiver keeps its own cursor into that ring. Sending a value is therefore O(1)
+ * regardless of the number of receivers, and receivers get a `std::shared_ptr<const T>` to the single stored value
+ * instead of a copy.
+ *
+ * Senders never wait for slow receivers. If a receiver falls so far behind that the values it has not yet read
+ * are overwritten, its next receive returns `Lagged` and the cursor is moved to the oldest value still stored.
+ *
+ * A channel is closed for senders when all receivers are destroyed, and closed for receivers once all senders are
+ * destroyed and the receiver has read all stored values.
+ */
+
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <colite/executor/executor.hpp>
+#include <colite/expected.hpp>
+#include <colite/trace/trace.hpp>
+
+namespace colite::broadcast {
+
+    enum class TryReceiveError : std::uint8_t
+    {
+        Empty,
+        Closed,
+        Lagged,
+    };
+
+    enum class ReceiveError : std::uint8_t
+    {
+        Closed,
+        Lagged,
+    };
+
+    enum class SendError : std::uint8_t
+    {
+        Closed
+    };
+
+    template<class T>
+    struct Channel;
+
+    namespace detail {
+        template<class T>
+        struct slot_t {
+            std::shared_ptr<const T> value_;
+        };
+
+        template<class T>
+        struct waiting_receiver_t {
+            std::coroutine_handle<> waiting_coro_;
+            // A copy of the receiver's cursor, advanced by the wakeup handler and copied back when the receive resumes.
+            // The handler runs on the receiver's executor and must not touch the `Receiver` itself.
+            std::uint64_t next_ = 0;
+            std::optional<colite::Expected<std::shared_ptr<const T>, TryReceiveError>> result_;
+            colite::executor::AnyExecutor exec_{colite::executor::ImmediateExecutor{}};
+        };
+
+        template<class T>
+        struct state_t {
+            std::mutex mutex_;
+            std::vector<slot_t<T>> ring_;
+            // Position of the next value to be written, counting from the creation of the channel.
+            std::uint64_t tail_ = 0;
+            std::vector<std::weak_ptr<waiting_receiver_t<T>>> waiting_receivers_;
+
+            std::weak_ptr<void> sender_ticket_;
+            std::weak_ptr<void> receiver_ticket_;
+
+            explicit state_t(std::size_t capacity) : ring_(capacity) {}
+
+            colite::Expected<std::shared_ptr<const T>, TryReceiveError> try_read(const std::unique_lock<std::mutex> &, std::uint64_t &next) {
+                if (next == tail_) {
+                    if (sender_ticket_.expired()) {
+                        return colite::Unexpected(TryReceiveError::Closed);
+                    }
+                    return colite::Unexpected(TryReceiveError::Empty);
+                }
+                const std::uint64_t oldest = tail_ > ring_.size() ? tail_ - ring_.size() : 0;
+                if (next < oldest) {
+                    next = oldest;
+                    return colite::Unexpected(TryReceiveError::Lagged);
+                }
+                return ring_[next++ % ring_.size()].value_;
+            }
+
+            std::shared_ptr<void> get_receiver_ticket(const std::unique_lock<std::mutex> &) {
+                auto ticket = receiver_ticket_.lock();
+                if (!ticket) {
+                    ticket = std::make_shared<char>(0);
+                    receiver_ticket_ = ticket;
+                }
+                return ticket;
+            }
+        };
+
+        template<class T>
+        void wakeup_waiting_receivers(const std::shared_ptr<state_t<T>> &state, std::vector<std::weak_ptr<waiting_receiver_t<T>>> waiting_receivers) {
+            // Same strategy as the mpmc channel: every parked receiver is probed on its own Executor
+            // and re-parks itself if there turns out to be nothing new to read.
+            for (auto weak_receiver : waiting_receivers) {
+                if (auto receiver = weak_receiver.lock()) {
+                    auto exec = receiver->exec_;
+
+                    auto handler = [weak_receiver, state] {
+                        if (auto receiver = weak_receiver.lock()) {
+                            std::unique_lock lock{state->mutex_};
+                            auto result = state->try_read(lock, receiver->next_);
+                            if (!result && result.error() == TryReceiveError::Empty) {
+                                state->waiting_receivers_.push_back(receiver);
+                                trace::emit(trace::Phase::Suspend, "broadcast", state.get(), receiver->waiting_coro_);
+                                return;
+                            }
+                            lock.unlock();
+                            receiver->result_ = std::move(result);
+                            trace::emit(trace::Phase::Resume, "broadcast", state.get(), receiver->waiting_coro_);
+                            receiver->waiting_coro_.resume();
+                        }
+                    };
+                    trace::emit(trace::Phase::Schedule, "broadcast", state.get(), receiver->waiting_coro_);
+                    receiver.reset();
+                    colite::executor::execute(exec, std::move(handler));
+                }
+            }
+        }
+    }// namespace detail
+
+    template<class T>
+    class Receiver;
+
+    template<class T>
+    class Sender {
+        using state_t = detail::state_t<T>;
+
+        template<class U>
+        friend Channel<U> channel(std::size_t);
+
+        std::shared_ptr<state_t> state_;
+        std::shared_ptr<void> ticket_;
+
+        Sender(std::shared_ptr<state_t> state, std::shared_ptr<void> ticket) noexcept
+            : state_(std::move(state)), ticket_(std::move(ticket)) {
+        }
+
+    public:
+        Sender(const Sender &) = default;
+        Sender(Sender &&) noexcept = default;
+        ~Sender() {
+            if (state_) {
+                std::unique_lock lock(state_->mutex_);
+                if (ticket_.use_count() == 1) {
+                    ticket_.reset();
+                    // Last sender, wake everyone up so they can observe the closed channel.
+                    auto waiting_receivers = std::exchange(state_->waiting_receivers_, {});
+                    lock.unlock();
+                    detail::wakeup_waiting_receivers(state_, std::move(waiting_receivers));
+                }
+            }
+        }
+
+        Sender &operator=(const Sender &) = default;
+        Sender &operator=(Sender &&) noexcept = default;
+
+        /**
+         * @brief Send a value to all receivers.
+         * @param value The value to send.
+         * @return The number of receivers alive when the value was stored, or `SendError::Closed` if there are none.
+         *
+         * Sending never waits, if the ring is full the oldest value is overwritten and receivers that have not
+         * yet read it will observe `Lagged`.
+         */
+        colite::Expected<std::size_t, SendError> send(T value) {
+            auto shared_value = std::make_shared<const T>(std::move(value));
+            std::unique_lock lock{state_->mutex_};
+            auto receivers = static_cast<std::size_t>(state_->receiver_ticket_.use_count());
+            if (receivers == 0) {
+                return colite::Unexpected(SendError::Closed);
+            }
+            auto &slot = state_->ring_[state_->tail_ % state_->ring_.size()];
+            // Swap out the overwritten value so that it is released outside of the lock.
+            std::swap(slot.value_, shared_value);
+            state_->tail_++;
+            auto waiting_receivers = std::exchange(state_->waiting_receivers_, {});
+            lock.unlock();
+            detail::wakeup_waiting_receivers(state_, std::move(waiting_receivers));
+            return receivers;
+        }
+
+        /**
+         * @brief Create a new receiver that will see all values sent after this call.
+         */
+        [[nodiscard]] Receiver<T> subscribe() {
+            std::unique_lock lock{state_->mutex_};
+            auto ticket = state_->get_receiver_ticket(lock);
+            return Receiver<T>(state_, std::move(ticket), state_->tail_);
+        }
+    };
+
+    template<class T>
+    class Receiver {
+        using state_t = detail::state_t<T>;
+        using waiting_receiver_t = detail::waiting_receiver_t<T>;
+
+        template<class U>
+        friend Channel<U> channel(std::size_t);
+        template<class U>
+        friend class Sender;
+
+        std::shared_ptr<state_t> state_;
+        std::shared_ptr<void> ticket_;
+        // The cursor is shared with a pending receive, which writes it back when it completes even if the receiver
+        // was moved in the meantime.
+        std::shared_ptr<std::uint64_t> next_;
+
+        Receiver(std::shared_ptr<state_t> state, std::shared_ptr<void> ticket, std::uint64_t next)
+            : state_(std::move(state)), ticket_(std::move(ticket)), next_(std::make_shared<std::uint64_t>(next)) {
+        }
+
+    public:
+        // A copy starts out at the same position and then reads on its own.
+        Receiver(const Receiver &other)
+            : state_(other.state_), ticket_(other.ticket_), next_(std::make_shared<std::uint64_t>(*other.next_)) {
+        }
+        Receiver(Receiver &&) noexcept = default;
+
+        Receiver &operator=(const Receiver &other) {
+            Receiver copy(other);
+            std::swap(*this, copy);
+            return *this;
+        }
+        Receiver &operator=(Receiver &&) noexcept = default;
+
+        /**
+         * @brief Get the number of values this receiver has not yet read.
+         * @return
+         *
+         * @note This is a snapshot in time, it may not be accurate when used later. The value can be larger
+         * than the channel capacity if the receiver has lagged behind.
+         */
+        [[nodiscard]] std::size_t available() const noexcept {
+            std::scoped_lock lock{state_->mutex_};
+            return static_cast<std::size_t>(state_->tail_ - *next_);
+        }
+
+        /**
+         * @brief Asynchronously receive the next value from the channel.
+         * @param exec The Executor to resume on
+         * @return An `AWAITABLE<Expected<std::shared_ptr<const T>, ReceiveError>>`.
+         *
+         * `ReceiveError::Lagged` is returned if values were overwritten before this receiver read them. The
+         * receiver then continues from the oldest value still held by the channel. `ReceiveError::Closed` is
+         * returned once all senders are destroyed and all values have been read.
+         *
+         * The receiver may be moved or destroyed while the receive is pending. Only one receive per receiver may be
+         * pending at a time, and `try_receive` must not be called on it until the receive completes.
+         */
+        [[nodiscard]] auto receive(colite::executor::Executor auto exec) {
+            struct awaitable {
+                std::shared_ptr<state_t> state_;
+                std::shared_ptr<waiting_receiver_t> waiting_receiver_;
+                std::shared_ptr<std::uint64_t> next_;
+
+                static constexpr bool await_ready() noexcept {
+                    return false;
+                }
+
+                bool await_suspend(std::coroutine_handle<> to_suspend) {
+                    std::unique_lock lock{state_->mutex_};
+                    waiting_receiver_->next_ = *next_;
+                    auto result = state_->try_read(lock, waiting_receiver_->next_);
+                    if (!result && result.error() == TryReceiveError::Empty) {
+                        waiting_receiver_->waiting_coro_ = to_suspend;
+                        state_->waiting_receivers_.push_back(waiting_receiver_);
+                        trace::emit(trace::Phase::Suspend, "broadcast", state_.get(), to_suspend);
+                        return true;
+                    }
+                    waiting_receiver_->result_ = std::move(result);
+                    return false;
+                }
+
+                colite::Expected<std::shared_ptr<const T>, ReceiveError> await_resume() {
+                    *next_ = waiting_receiver_->next_;
+                    auto &result = *waiting_receiver_->result_;
+                    if (result.has_value()) {
+                        return std::move(*result);
+                    }
+                    if (result.error() == TryReceiveError::Lagged) {
+                        return colite::Unexpected(ReceiveError::Lagged);
+                    }
+                    return colite::Unexpected(ReceiveError::Closed);
+                }
+            };
+            auto waiting_receiver = std::make_shared<waiting_receiver_t>();
+            waiting_receiver->exec_ = std::move(exec);
+            return awaitable{state_, std::move(waiting_receiver), next_};
+        }
+
+        /**
+         * @brief Try to receive the next value without blocking.
+         * @return The next value, or an error indicating if the channel is empty, closed or if the receiver lagged.
+         */
+        [[nodiscard]] colite::Expected<std::shared_ptr<const T>, TryReceiveError> try_receive() {
+            std::unique_lock lock{state_->mutex_};
+            return state_->try_read(lock, *next_);
+        }
+    };
+
+    /**
+     * @brief Return-type for `channel<T>(capacity)`.
+     * @tparam T The type transported inside the channel.
+     */
+    template<class T>
+    struct Channel {
+        Sender<T> sender;
+        Receiver<T> receiver;
+    };
+
+    /**
+     * @brief Create a new broadcast channel
+     * @tparam T The type transported with the channel
+     * @param capacity The number of values kept for receivers that have not yet read them. Must be greater than 0.
+     * @return The sender and receiver of the new channel. More receivers are created with `Sender::subscribe` or by
+     * copying a receiver.
+     * @throws std::invalid_argument if `capacity` is 0.
+     */
+    template<class T>
+    Channel<T> channel(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("broadcast::channel: capacity must be greater than 0");
+        }
+        auto state = std::make_shared<detail::state_t<T>>(capacity);
+        auto sender_ticket = std::make_shared<char>(0);
+        auto receiver_ticket = std::make_shared<char>(0);
+        state->sender_ticket_ = sender_ticket;
+        state->receiver_ticket_ = receiver_ticket;
+        Sender<T> sender(state, std::move(sender_ticket));
+        Receiver<T> receiver(std::move(state), std::move(receiver_ticket), 0);
+        return Channel<T>{std::move(sender), std::move(receiver)};
+    }
+}// namespace colite::broadcast
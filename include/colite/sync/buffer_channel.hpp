@@ -0,0 +1,302 @@
+#pragma once
+
+/**
+ * @file
+ * @brief A channel of pooled, reference counted byte buffers.
+ *
+ * Large payloads sent as `std::vector<char>` allocate a new buffer for every message and free it once the receiver is
+ * done. A `BufferChannel` instead hands out buffers from a `BufferPool` owned by the channel. The producer fills a
+ * `Buffer` and sends it, the receiver gets a `BufferView` of the very same memory, and when the last view is dropped
+ * the buffer goes back to the pool for the next message. Once the pool is warm, sending allocates and copies nothing.
+ *
+ * The pool keeps its free buffers in a lock-free ring, so producers and consumers on different threads never contend
+ * on a lock to take or return a buffer.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * auto channel = colite::mpmc::buffer_channel(64 * 1024);
+ *
+ * task producer(colite::mpmc::BufferPool pool, colite::mpmc::Sender<colite::mpmc::BufferView> sender) {
+ *     for (;;) {
+ *         auto buffer = pool.acquire();
+ *         auto read = ::read(fd, buffer.data().data(), buffer.capacity());
+ *         buffer.resize(read);
+ *         co_await sender.send(exec, std::move(buffer));
+ *     }
+ * }
+ *
+ * task consumer(colite::mpmc::Receiver<colite::mpmc::BufferView> receiver) {
+ *     while (auto view = co_await receiver.receive(exec)) {
+ *         process(view->data());
+ *     } // The buffer is back in the pool here.
+ * }
+ * ```
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <utility>
+
+#include <colite/detail/bounded_queue.hpp>
+#include <colite/sync/channel.hpp>
+
+namespace colite::mpmc {
+    namespace detail {
+        class buffer_pool;
+
+        // The header of a pooled buffer, the bytes follow right after it in the same allocation.
+        struct alignas(std::max_align_t) buffer_block {
+            std::atomic<std::uint32_t> refs_{1};
+            std::size_t size_;
+            std::size_t capacity_;
+            buffer_pool *pool_;
+
+            buffer_block(buffer_pool *pool, std::size_t capacity) noexcept : size_(capacity), capacity_(capacity), pool_(pool) {}
+
+            std::byte *data() noexcept {
+                return reinterpret_cast<std::byte *>(this + 1);
+            }
+
+            static buffer_block *create(buffer_pool *pool, std::size_t capacity) {
+                auto *memory = ::operator new(sizeof(buffer_block) + capacity);
+                return ::new (memory) buffer_block(pool, capacity);
+            }
+
+            static void destroy(buffer_block *block) noexcept {
+                block->~buffer_block();
+                ::operator delete(block);
+            }
+        };
+
+        // Owned by every `BufferPool` handle and every buffer taken from it, the last one deletes it.
+        class buffer_pool {
+            std::atomic<std::size_t> refs_{1};
+            std::size_t buffer_size_;
+            std::atomic<std::size_t> allocated_{0};
+            colite::detail::bounded_queue<buffer_block *> free_;
+
+        public:
+            buffer_pool(std::size_t buffer_size, std::size_t max_pooled) : buffer_size_(buffer_size), free_(max_pooled) {}
+
+            ~buffer_pool() {
+                while (auto block = free_.try_pop()) {
+                    buffer_block::destroy(*block);
+                }
+            }
+
+            void ref() noexcept {
+                refs_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void unref() noexcept {
+                if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    delete this;
+                }
+            }
+
+            buffer_block *acquire() {
+                buffer_block *block;
+                if (auto pooled = free_.try_pop()) {
+                    block = *pooled;
+                    block->refs_.store(1, std::memory_order_relaxed);
+                    block->size_ = block->capacity_;
+                } else {
+                    block = buffer_block::create(this, buffer_size_);
+                    allocated_.fetch_add(1, std::memory_order_relaxed);
+                }
+                ref();
+                return block;
+            }
+
+            // Called when the last reference to `block` is dropped.
+            void release(buffer_block *block) noexcept {
+                if (!free_.try_push(block)) {
+                    buffer_block::destroy(block);
+                    allocated_.fetch_sub(1, std::memory_order_relaxed);
+                }
+                unref();
+            }
+
+            [[nodiscard]] std::size_t buffer_size() const noexcept {
+                return buffer_size_;
+            }
+
+            [[nodiscard]] std::size_t allocated() const noexcept {
+                return allocated_.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] std::size_t pooled() const noexcept {
+                return free_.depth();
+            }
+        };
+
+        inline void unref(buffer_block *block) noexcept {
+            if (block && block->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                block->pool_->release(block);
+            }
+        }
+    }// namespace detail
+
+    class BufferView;
+
+    /**
+     * @brief A buffer from a `BufferPool` that is being filled. Move-only.
+     *
+     * A new buffer spans its whole capacity, `resize` it to the number of bytes actually written before it is sent.
+     * Dropping it returns it to its pool.
+     */
+    class Buffer {
+        friend class BufferPool;
+        friend class BufferView;
+        detail::buffer_block *block_;
+
+        explicit Buffer(detail::buffer_block *block) noexcept : block_(block) {}
+
+    public:
+        Buffer(Buffer &&rhs) noexcept : block_(std::exchange(rhs.block_, nullptr)) {}
+        Buffer &operator=(Buffer &&rhs) noexcept {
+            if (this != &rhs) {
+                detail::unref(std::exchange(block_, std::exchange(rhs.block_, nullptr)));
+            }
+            return *this;
+        }
+        ~Buffer() {
+            detail::unref(block_);
+        }
+
+        [[nodiscard]] std::span<std::byte> data() noexcept {
+            return {block_->data(), block_->size_};
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return block_->size_;
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return block_->capacity_;
+        }
+
+        /**
+         * @brief Set the size to `size` bytes, which is capped at `capacity()`. The contents are left as they are.
+         */
+        void resize(std::size_t size) noexcept {
+            block_->size_ = size < block_->capacity_ ? size : block_->capacity_;
+        }
+    };
+
+    /**
+     * @brief A read-only, reference counted view of a sent `Buffer`.
+     *
+     * Copying a view only bumps the reference count, so it can also be passed on through a broadcast channel. The
+     * buffer returns to its pool when the last view is dropped.
+     */
+    class BufferView {
+        detail::buffer_block *block_;
+
+    public:
+        BufferView(Buffer &&buffer) noexcept : block_(std::exchange(buffer.block_, nullptr)) {}
+
+        BufferView(const BufferView &rhs) noexcept : block_(rhs.block_) {
+            if (block_) {
+                block_->refs_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        BufferView(BufferView &&rhs) noexcept : block_(std::exchange(rhs.block_, nullptr)) {}
+        BufferView &operator=(BufferView rhs) noexcept {
+            std::swap(block_, rhs.block_);
+            return *this;
+        }
+        ~BufferView() {
+            detail::unref(block_);
+        }
+
+        [[nodiscard]] std::span<const std::byte> data() const noexcept {
+            return {block_->data(), block_->size_};
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return block_->size_;
+        }
+    };
+
+    /**
+     * @brief A pool of equally sized buffers. Copies refer to the same pool, and all members are thread-safe.
+     *
+     * The pool stays alive as long as a handle or any of its buffers do.
+     */
+    class BufferPool {
+        detail::buffer_pool *pool_;
+
+    public:
+        /**
+         * @brief Create a pool of `buffer_size` byte buffers, keeping at most `max_pooled` (rounded up to a power of two)
+         * of them around for reuse.
+         *
+         * Buffers released while the pool is full are freed.
+         */
+        explicit BufferPool(std::size_t buffer_size, std::size_t max_pooled = 64) : pool_(new detail::buffer_pool(buffer_size, max_pooled)) {}
+
+        BufferPool(const BufferPool &rhs) noexcept : pool_(rhs.pool_) {
+            pool_->ref();
+        }
+        BufferPool &operator=(const BufferPool &rhs) noexcept {
+            rhs.pool_->ref();
+            pool_->unref();
+            pool_ = rhs.pool_;
+            return *this;
+        }
+        ~BufferPool() {
+            pool_->unref();
+        }
+
+        /**
+         * @brief Take a buffer from the pool, allocating a new one if the pool is empty.
+         */
+        [[nodiscard]] Buffer acquire() {
+            return Buffer(pool_->acquire());
+        }
+
+        [[nodiscard]] std::size_t buffer_size() const noexcept {
+            return pool_->buffer_size();
+        }
+
+        /**
+         * @brief The number of buffers the pool has allocated and not freed, whether they are in use or pooled.
+         */
+        [[nodiscard]] std::size_t allocated() const noexcept {
+            return pool_->allocated();
+        }
+
+        /**
+         * @brief The number of buffers waiting in the pool.
+         */
+        [[nodiscard]] std::size_t pooled() const noexcept {
+            return pool_->pooled();
+        }
+    };
+
+    /**
+     * @brief A channel of `BufferView`s together with the pool its buffers come from.
+     */
+    template<class Backend = Unbounded>
+    struct BufferChannel {
+        BufferPool pool;
+        Sender<BufferView, Backend> sender;
+        Receiver<BufferView, Backend> receiver;
+    };
+
+    /**
+     * @brief Create a `BufferChannel` with a pool of `buffer_size` byte buffers.
+     * @param max_pooled The most released buffers kept for reuse, rounded up to a power of two.
+     * @param args Passed to `channel`, for instance the capacity of a `LockFree` channel.
+     */
+    template<class Backend = Unbounded, class... Args>
+    BufferChannel<Backend> buffer_channel(std::size_t buffer_size, std::size_t max_pooled = 64, Args &&...args) {
+        auto [sender, receiver] = channel<BufferView, Backend>(std::forward<Args>(args)...);
+        return BufferChannel<Backend>{BufferPool(buffer_size, max_pooled), std::move(sender), std::move(receiver)};
+    }
+}// namespace colite::mpmc
@@ -9,146 +9,971 @@
  *
  * A sender can only be used to send data on a channel, while a receiver can only be used to receive data on a channel.
  * The number of senders and receivers alive for each channel is tracked, and a channel is closed when either all senders
- * or all receivers are destroyed.
+ * or all receivers are destroyed. Either end can also close the channel explicitly with `close()`.
  *
  * When a channel is closed, senders will not be able to send new data on the channel. Receivers will be able to read
  * all enqueued data, but will after that be notified that the channel is closed.
+ *
+ * The queue of a channel is picked with its `Backend`:
+ *
+ *   * `Unbounded`, the default, queues values in a deque guarded by the channel lock. Sending never waits.
+ *   * `LockFree` queues values in a fixed capacity lock-free ring. Values are sent and received without taking the
+ *     channel lock, which is only used to park receivers while the channel is empty and senders while it is full.
  */
 
+#include <atomic>
+#include <concepts>
 #include <coroutine>
+#include <cstdint>
 #include <deque>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <stop_token>
+#include <utility>
+#include <vector>
 
+#include <colite/detail/bounded_queue.hpp>
+#include <colite/detail/cache_line.hpp>
+#include <colite/detail/intrusive_list.hpp>
 #include <colite/executor/executor.hpp>
 #include <colite/expected.hpp>
+#include <colite/instrument.hpp>
+#include <colite/timer/timer.hpp>
+#include <colite/trace/trace.hpp>
+
+namespace colite::detail {
+    template<class Exec, bool Cancellable, class... Ts>
+    struct select_awaitable;
+}
 
 namespace colite::mpmc {
 
-    enum class TryReceiveError
+    enum class TryReceiveError : std::uint8_t
     {
         Empty,
         Closed,
     };
 
-    enum class ReceiveError
+    enum class ReceiveError : std::uint8_t
     {
-        Closed
+        Closed,
+        Cancelled,
+        TimedOut,
     };
 
-    enum class SendError
+    enum class SendError : std::uint8_t
     {
-        Closed
+        Closed,
+        // Only returned by `try_send` on a `LockFree` channel.
+        Full,
     };
 
-    template<class T>
+    /**
+     * @brief A point in time view of the metrics of a channel.
+     *
+     * See `Receiver::metrics()`.
+     */
+    struct ChannelMetrics
+    {
+        // Values currently queued in the channel.
+        std::size_t depth = 0;
+        // The largest depth the channel has had. Only tracked for `LockFree` channels when `COLITE_INSTRUMENT` is defined.
+        std::size_t high_water_mark = 0;
+        std::uint64_t sent = 0;
+        std::uint64_t received = 0;
+        std::size_t parked_receivers = 0;
+        // Senders waiting for room in a full `LockFree` channel.
+        std::size_t parked_senders = 0;
+        bool closed = false;
+        // Time values spent in the channel, only recorded when `COLITE_INSTRUMENT` is defined.
+        instrument::Histogram time_in_queue{};
+    };
+
+    struct Unbounded;
+    struct LockFree;
+
+    template<class T, class Backend = Unbounded>
     struct Channel;
 
     namespace detail {
+        enum class waiter_state
+        {
+            idle,
+            queued,
+            in_flight,
+            done,
+            abandoned,
+        };
+
+        template<class T>
+        struct waiting_receiver_t: colite::detail::intrusive_list_hook<waiting_receiver_t<T>>,
+                                   std::enable_shared_from_this<waiting_receiver_t<T>> {
+            std::coroutine_handle<> waiting_coro_;
+            std::optional<T> value_;
+            colite::executor::AnyExecutor exec_;
+            // Written with the channel lock held. `done` is final, which lets the destructor skip the lock.
+            std::atomic<waiter_state> state_ = waiter_state::idle;
+            std::optional<ReceiveError> error_;
+
+            explicit waiting_receiver_t(colite::executor::AnyExecutor exec) : exec_(std::move(exec)) {}
+            virtual ~waiting_receiver_t() = default;
+
+            // Called with the channel lock held when data is available or the channel is closed.
+            // A receiver that returns false is dropped from the channel without consuming anything.
+            virtual bool claim() noexcept {
+                return true;
+            }
+
+            // Called without the channel lock held once value_ has been set.
+            virtual void complete() {
+                waiting_coro_.resume();
+            }
+        };
+
+        // A sender waiting for room in a full `LockFree` channel.
         template<class T>
-        struct waiting_receiver_t {
+        struct waiting_sender_t: colite::detail::intrusive_list_hook<waiting_sender_t<T>>,
+                                 std::enable_shared_from_this<waiting_sender_t<T>> {
             std::coroutine_handle<> waiting_coro_;
+            // The value still to be pushed, empty once it has been.
             std::optional<T> value_;
-            colite::executor::AnyExecutor exec_{colite::executor::ImmediateExecutor{}};
+            colite::executor::AnyExecutor exec_;
+            // Written with the channel lock held, `done` is final.
+            std::atomic<waiter_state> state_ = waiter_state::idle;
+            bool closed_ = false;
+
+            explicit waiting_sender_t(colite::executor::AnyExecutor exec) : exec_(std::move(exec)) {}
         };
 
+        // A coroutine waiting for the channel to become empty, see `Sender::drain`.
+        struct waiting_drain_t: colite::detail::intrusive_list_hook<waiting_drain_t>,
+                                std::enable_shared_from_this<waiting_drain_t> {
+            std::coroutine_handle<> waiting_coro_;
+            colite::executor::AnyExecutor exec_;
+            // Written with the channel lock held, `done` is final.
+            std::atomic<waiter_state> state_ = waiter_state::idle;
+            // Set if all receivers were gone while values were still queued.
+            bool undelivered_ = false;
+
+            explicit waiting_drain_t(colite::executor::AnyExecutor exec) : exec_(std::move(exec)) {}
+        };
+
+        // The queue of the `Unbounded` backend. It does no synchronization of its own, everything except the metric
+        // getters must be called with the channel lock held.
         template<class T>
-        struct state_t {
-            std::mutex mutex_;
-            std::deque<T> data_;
-            std::vector<std::weak_ptr<waiting_receiver_t<T>>> waiting_receivers_;
+        class unbounded_queue {
+            struct entry {
+                T value_;
+                [[no_unique_address]] instrument::Stopwatch enqueued_;
+            };
+
+            // The allocator counts the blocks the deque allocates as it grows on the channel's counters.
+            std::deque<entry, instrument::CountingAllocator<entry>> data_;
+
+            // Metrics are only written with the channel lock held, which lets them be read without it. Keeping them off
+            // the lock's cache line means polling them doesn't slow down senders and receivers.
+            // Written by senders.
+            alignas(colite::detail::cache_line_size) std::atomic<std::uint64_t> sent_{0};
+            std::atomic<std::size_t> depth_{0};
+            std::atomic<std::size_t> high_water_mark_{0};
+            // Written by receivers.
+            alignas(colite::detail::cache_line_size) std::atomic<std::uint64_t> received_{0};
+            [[no_unique_address]] instrument::HistogramCounters time_in_queue_;
+
+        public:
+            static constexpr bool lock_free = false;
 
-            std::weak_ptr<void> sender_ticket_;
-            std::weak_ptr<void> receiver_ticket_;
+            explicit unbounded_queue(instrument::Counters &counters)
+                : data_(instrument::CountingAllocator<entry>(counters)) {}
 
-            std::optional<T> pop_value(const std::unique_lock<std::mutex> &) {
+            void push(T value) {
+                data_.push_back(entry{std::move(value), {}});
+                data_.back().enqueued_.start();
+                auto depth = data_.size();
+                depth_.store(depth, std::memory_order_relaxed);
+                if (depth > high_water_mark_.load(std::memory_order_relaxed)) {
+                    high_water_mark_.store(depth, std::memory_order_relaxed);
+                }
+                sent_.store(sent_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+
+            // Never full, only here to match the interface of the lock-free queue.
+            bool try_push(T &value) {
+                push(std::move(value));
+                return true;
+            }
+
+            std::optional<T> try_pop() {
                 if (data_.empty()) {
                     return std::nullopt;
                 }
-                auto retval = std::move(data_.front());
+                auto retval = std::move(data_.front().value_);
+                time_in_queue_.record(data_.front().enqueued_.elapsed_ns());
                 data_.pop_front();
+                depth_.store(data_.size(), std::memory_order_relaxed);
+                received_.store(received_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
                 return retval;
             }
+
+            [[nodiscard]] bool empty() const noexcept {
+                return data_.empty();
+            }
+
+            [[nodiscard]] std::size_t depth() const noexcept {
+                return depth_.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] std::uint64_t sent() const noexcept {
+                return sent_.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] std::uint64_t received() const noexcept {
+                return received_.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] std::size_t high_water_mark() const noexcept {
+                return high_water_mark_.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] instrument::Histogram time_in_queue() const noexcept {
+                return time_in_queue_.snapshot();
+            }
         };
     }// namespace detail
 
-    template<class T>
-    class Sender {
-        using state_t = detail::state_t<T>;
-        using waiting_receiver_t = detail::waiting_receiver_t<T>;
+    /**
+     * @brief Channel backend that queues values in an unbounded deque guarded by the channel lock.
+     *
+     * This is the default backend. Sending never waits, and it is the only backend that supports `colite::select`.
+     */
+    struct Unbounded {
+        template<class T>
+        using queue = detail::unbounded_queue<T>;
+    };
+
+    /**
+     * @brief Channel backend with a fixed capacity lock-free queue.
+     *
+     * Values are sent and received without taking the channel lock, so producers and consumers only contend on the
+     * queue positions. The capacity is rounded up to a power of two. Sending to a full channel suspends the sender
+     * until a receiver makes room, and `try_send` fails with `SendError::Full`.
+     *
+     * `T` must be nothrow move constructible.
+     */
+    struct LockFree {
+        template<class T>
+        using queue = colite::detail::bounded_queue<T>;
+    };
+
+    namespace detail {
+        template<class T, class Backend = Unbounded>
+        struct state_t {
+            using queue_t = typename Backend::template queue<T>;
+            using waiting_receiver_t = detail::waiting_receiver_t<T>;
+            using waiting_sender_t = detail::waiting_sender_t<T>;
 
-        template<class U>
-        friend Channel<U> channel();
+            // The fields are grouped by who writes them, and each group starts on its own cache line.
 
-        std::shared_ptr<state_t> state_;
-        std::shared_ptr<void> ticket_;
+            // Guarded by mutex_. Every send and receive on an unbounded channel takes it, a lock-free channel only
+            // takes it to park and wake up waiters.
+            alignas(colite::detail::cache_line_size) std::mutex mutex_;
+            colite::detail::intrusive_list<waiting_receiver_t> waiting_receivers_;
+            colite::detail::intrusive_list<waiting_sender_t> waiting_senders_;
+            colite::detail::intrusive_list<waiting_drain_t> waiting_drains_;
+            // Written with mutex_ held. Senders and receivers read them after every push and pop to decide if anyone
+            // needs a wakeup.
+            std::atomic<std::size_t> parked_receivers_{0};
+            std::atomic<std::size_t> parked_senders_{0};
+            std::atomic<std::size_t> parked_drains_{0};
+
+            // Control data, read-mostly. The counts are only written when ends are copied or destroyed.
+            alignas(colite::detail::cache_line_size) std::atomic<std::size_t> senders_{1};
+            std::atomic<std::size_t> receivers_{1};
+            // Set with mutex_ held once all senders or all receivers are gone. It never goes back to false, so checking
+            // it without the lock is only ever too optimistic.
+            std::atomic<bool> closed_{false};
+            // Comes before queue_, which counts its allocations on it from its constructor on.
+            [[no_unique_address]] instrument::Counters counters_;
+
+            // Starts on its own cache line, and keeps its sender and receiver side apart.
+            queue_t queue_;
+
+            template<class... Args>
+            explicit state_t(Args &&...args) : queue_(std::forward<Args>(args)...) {}
+
+            template<class... Args> requires std::constructible_from<queue_t, instrument::Counters &, Args...>
+            explicit state_t(Args &&...args) : queue_(counters_, std::forward<Args>(args)...) {}
+
+            [[nodiscard]] bool closed() const noexcept {
+                return closed_.load(std::memory_order_relaxed);
+            }
+
+            void push_value(const std::unique_lock<std::mutex> &, T value) {
+                queue_.push(std::move(value));
+            }
+
+            // Pops the oldest value, or reports if the channel is empty or closed.
+            colite::Expected<T, TryReceiveError> take_value(const std::unique_lock<std::mutex> &) {
+                if (auto value = queue_.try_pop()) {
+                    return std::move(*value);
+                }
+                if (!closed()) {
+                    return colite::Unexpected(TryReceiveError::Empty);
+                }
+                if constexpr (queue_t::lock_free) {
+                    // Lock-free senders push without the lock, the last one may have pushed right before leaving.
+                    if (auto value = queue_.try_pop()) {
+                        return std::move(*value);
+                    }
+                }
+                return colite::Unexpected(TryReceiveError::Closed);
+            }
+
+            // Returns true if the receiver was parked. A lock-free channel may instead complete the receiver with a
+            // value that was pushed while it was being parked.
+            bool park(const std::unique_lock<std::mutex> &lock, waiting_receiver_t &receiver) {
+                receiver.state_ = waiter_state::queued;
+                waiting_receivers_.push_back(receiver);
+                parked_receivers_.store(waiting_receivers_.size(), std::memory_order_relaxed);
+                if constexpr (queue_t::lock_free) {
+                    // Pairs with the fence in notify_waiting_receivers: either the sender sees this receiver parked,
+                    // or the retry below sees its value.
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (auto value = queue_.try_pop()) {
+                        unpark(lock, receiver);
+                        receiver.value_ = std::move(value);
+                        receiver.state_ = waiter_state::done;
+                        return false;
+                    }
+                }
+                trace::emit(trace::Phase::Suspend, "mpmc::channel", this, receiver.waiting_coro_);
+                return true;
+            }
+
+            void unpark(const std::unique_lock<std::mutex> &, waiting_receiver_t &receiver) noexcept {
+                waiting_receivers_.erase(receiver);
+                parked_receivers_.store(waiting_receivers_.size(), std::memory_order_relaxed);
+            }
+
+            // Returns true if the sender was parked, otherwise its value has been pushed.
+            bool park(const std::unique_lock<std::mutex> &lock, waiting_sender_t &sender) {
+                sender.state_ = waiter_state::queued;
+                waiting_senders_.push_back(sender);
+                parked_senders_.store(waiting_senders_.size(), std::memory_order_relaxed);
+                // Pairs with the fence in notify_waiting_senders: either the receiver sees this sender parked,
+                // or the retry below sees the room it made.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (queue_.try_push(*sender.value_)) {
+                    unpark(lock, sender);
+                    sender.value_.reset();
+                    sender.state_ = waiter_state::done;
+                    return false;
+                }
+                trace::emit(trace::Phase::Suspend, "mpmc::send", this, sender.waiting_coro_);
+                return true;
+            }
+
+            void unpark(const std::unique_lock<std::mutex> &, waiting_sender_t &sender) noexcept {
+                waiting_senders_.erase(sender);
+                parked_senders_.store(waiting_senders_.size(), std::memory_order_relaxed);
+            }
+
+            // A drain is done once the channel is empty, or once no receiver is left to empty it.
+            bool drained(const std::unique_lock<std::mutex> &, waiting_drain_t &drain) const noexcept {
+                if (queue_.depth() == 0) {
+                    return true;
+                }
+                if (receivers_.load(std::memory_order_acquire) == 0) {
+                    drain.undelivered_ = true;
+                    return true;
+                }
+                return false;
+            }
+
+            // Completes the drain right away if the channel is already drained, otherwise parks it.
+            // Returns true if the drain was parked.
+            bool drain_or_park(const std::unique_lock<std::mutex> &lock, waiting_drain_t &drain, std::coroutine_handle<> to_suspend) {
+                if (drained(lock, drain)) {
+                    drain.state_ = waiter_state::done;
+                    return false;
+                }
+                drain.waiting_coro_ = to_suspend;
+                drain.state_ = waiter_state::queued;
+                waiting_drains_.push_back(drain);
+                parked_drains_.store(waiting_drains_.size(), std::memory_order_relaxed);
+                if constexpr (queue_t::lock_free) {
+                    // Pairs with the fence in notify_waiting_drains, lock-free receivers pop without the lock.
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (drained(lock, drain)) {
+                        unpark(lock, drain);
+                        drain.state_ = waiter_state::done;
+                        return false;
+                    }
+                }
+                trace::emit(trace::Phase::Suspend, "mpmc::drain", this, to_suspend);
+                return true;
+            }
+
+            void unpark(const std::unique_lock<std::mutex> &, waiting_drain_t &drain) noexcept {
+                waiting_drains_.erase(drain);
+                parked_drains_.store(waiting_drains_.size(), std::memory_order_relaxed);
+            }
+
+            std::vector<std::shared_ptr<waiting_receiver_t>> take_waiting_receivers(const std::unique_lock<std::mutex> &) {
+                std::vector<std::shared_ptr<waiting_receiver_t>> retval;
+                retval.reserve(waiting_receivers_.size());
+                while (auto *receiver = waiting_receivers_.pop_front()) {
+                    receiver->state_ = waiter_state::in_flight;
+                    retval.push_back(receiver->shared_from_this());
+                }
+                parked_receivers_.store(0, std::memory_order_relaxed);
+                if (retval.capacity() != 0) {
+                    counters_.allocation();
+                }
+                return retval;
+            }
+
+            // A lock-free push makes a single value available, so only one receiver at a time is woken up for it.
+            // Receivers that no longer want a value are dropped on the way.
+            std::shared_ptr<waiting_receiver_t> take_waiting_receiver(const std::unique_lock<std::mutex> &) {
+                while (auto *receiver = waiting_receivers_.pop_front()) {
+                    parked_receivers_.store(waiting_receivers_.size(), std::memory_order_relaxed);
+                    if (!receiver->claim()) {
+                        counters_.spurious_wakeup();
+                        receiver->state_ = waiter_state::done;
+                        continue;
+                    }
+                    receiver->state_ = waiter_state::in_flight;
+                    return receiver->shared_from_this();
+                }
+                return nullptr;
+            }
+
+            // A pop makes room for a single value, so only one sender at a time is woken up for it.
+            std::shared_ptr<waiting_sender_t> take_waiting_sender(const std::unique_lock<std::mutex> &) {
+                auto *sender = waiting_senders_.pop_front();
+                if (!sender) {
+                    return nullptr;
+                }
+                sender->state_ = waiter_state::in_flight;
+                parked_senders_.store(waiting_senders_.size(), std::memory_order_relaxed);
+                return sender->shared_from_this();
+            }
+
+            std::vector<std::shared_ptr<waiting_sender_t>> take_waiting_senders(const std::unique_lock<std::mutex> &) {
+                std::vector<std::shared_ptr<waiting_sender_t>> retval;
+                retval.reserve(waiting_senders_.size());
+                while (auto *sender = waiting_senders_.pop_front()) {
+                    sender->state_ = waiter_state::in_flight;
+                    retval.push_back(sender->shared_from_this());
+                }
+                parked_senders_.store(0, std::memory_order_relaxed);
+                if (retval.capacity() != 0) {
+                    counters_.allocation();
+                }
+                return retval;
+            }
+
+            std::vector<std::shared_ptr<waiting_drain_t>> take_waiting_drains(const std::unique_lock<std::mutex> &) {
+                std::vector<std::shared_ptr<waiting_drain_t>> retval;
+                retval.reserve(waiting_drains_.size());
+                while (auto *drain = waiting_drains_.pop_front()) {
+                    drain->state_ = waiter_state::in_flight;
+                    retval.push_back(drain->shared_from_this());
+                }
+                parked_drains_.store(0, std::memory_order_relaxed);
+                if (retval.capacity() != 0) {
+                    counters_.allocation();
+                }
+                return retval;
+            }
+
+            // Completes the receiver right away if there is data or the channel is closed, otherwise parks it.
+            // Returns true if the receiver was parked.
+            bool receive_or_park(waiting_receiver_t &receiver, std::coroutine_handle<> to_suspend) {
+                if constexpr (queue_t::lock_free) {
+                    if (auto value = queue_.try_pop()) {
+                        receiver.value_ = std::move(value);
+                        receiver.state_ = waiter_state::done;
+                        return false;
+                    }
+                }
+                std::unique_lock lock{mutex_};
+                if (!receiver.error_) {
+                    auto value = take_value(lock);
+                    if (!value.has_value() && value.error() == TryReceiveError::Empty) {
+                        receiver.waiting_coro_ = to_suspend;
+                        return park(lock, receiver);
+                    }
+                    if (value.has_value()) {
+                        receiver.value_ = std::move(*value);
+                    }
+                }
+                receiver.state_ = waiter_state::done;
+                return false;
+            }
+
+            bool try_receive_now(waiting_receiver_t &receiver) {
+                std::unique_lock lock{mutex_};
+                auto value = take_value(lock);
+                if (!value.has_value() && value.error() == TryReceiveError::Empty) {
+                    return false;
+                }
+                if (value.has_value()) {
+                    receiver.value_ = std::move(*value);
+                }
+                receiver.state_ = waiter_state::done;
+                return true;
+            }
+
+            // Called with the lock held by a receiver that has been woken up. Returns true if the receiver is done and
+            // should be resumed, false if it was parked again or dropped.
+            bool retry_receive(const std::unique_lock<std::mutex> &lock, waiting_receiver_t &receiver) {
+                if (receiver.error_) {
+                    // Cancelled while the wakeup was in flight.
+                    receiver.state_ = waiter_state::done;
+                    return true;
+                }
+                if constexpr (queue_t::lock_free) {
+                    auto value = take_value(lock);
+                    if (!value.has_value() && value.error() == TryReceiveError::Empty) {
+                        if (park(lock, receiver)) {
+                            counters_.spurious_wakeup();
+                            counters_.requeue();
+                            return false;
+                        }
+                        return true;
+                    }
+                    if (value.has_value()) {
+                        receiver.value_ = std::move(*value);
+                    }
+                } else {
+                    if (queue_.empty() && !closed()) {
+                        // No data and senders are still alive, re-add to list of waiting receivers
+                        // to be woken up again in the future.
+                        counters_.spurious_wakeup();
+                        counters_.requeue();
+                        park(lock, receiver);
+                        return false;
+                    }
+                    // Only unbounded channels can be selected on, and the queue can't change while the lock is held,
+                    // so a receiver is only asked to claim when there is something to take.
+                    if (!receiver.claim()) {
+                        counters_.spurious_wakeup();
+                        receiver.state_ = waiter_state::done;
+                        return false;
+                    }
+                    receiver.value_ = queue_.try_pop();
+                }
+                receiver.state_ = waiter_state::done;
+                return true;
+            }
 
-        Sender(std::shared_ptr<detail::state_t<T>> state, std::shared_ptr<void> ticket) noexcept
-            : state_(std::move(state)), ticket_(std::move(ticket)) {
+            // Pushes the value of a sender of a lock-free channel, or parks the sender while the channel is full.
+            // Returns true if the sender was parked.
+            bool send_or_park(const std::unique_lock<std::mutex> &lock, waiting_sender_t &sender, std::coroutine_handle<> to_suspend) {
+                if (closed()) {
+                    sender.closed_ = true;
+                    sender.state_ = waiter_state::done;
+                    return false;
+                }
+                sender.waiting_coro_ = to_suspend;
+                return park(lock, sender);
+            }
+
+            // Called when an awaitable is destroyed, removes the waiter from its waiting list right away.
+            template<class Waiter>
+            void abandon(Waiter &waiter) noexcept {
+                if (waiter.state_.load(std::memory_order_acquire) == waiter_state::done) {
+                    return;
+                }
+                std::unique_lock lock{mutex_};
+                if (waiter.state_ == waiter_state::queued) {
+                    unpark(lock, waiter);
+                }
+                if (waiter.state_ != waiter_state::done) {
+                    waiter.state_ = waiter_state::abandoned;
+                }
+            }
+
+            ChannelMetrics metrics() const noexcept {
+                ChannelMetrics retval;
+                retval.depth = queue_.depth();
+                retval.high_water_mark = queue_.high_water_mark();
+                retval.sent = queue_.sent();
+                retval.received = queue_.received();
+                retval.parked_receivers = parked_receivers_.load(std::memory_order_relaxed);
+                retval.parked_senders = parked_senders_.load(std::memory_order_relaxed);
+                retval.closed = closed();
+                retval.time_in_queue = queue_.time_in_queue();
+                return retval;
+            }
+        };
+
+        template<class State>
+        void notify_waiting_senders(const std::shared_ptr<State> &state);
+
+        template<class State>
+        void after_pop(const std::shared_ptr<State> &state);
+
+        template<class State>
+        void notify_waiting_receivers(const std::shared_ptr<State> &state);
+
+        // A lock-free channel wakes a single receiver per value. If that receiver is gone by the time it runs, the
+        // value is still queued and the next parked receiver has to be woken for it instead.
+        template<class State>
+        void pass_on_wakeup(const std::shared_ptr<State> &state) {
+            if constexpr (State::queue_t::lock_free) {
+                notify_waiting_receivers(state);
+            }
         }
 
-        void wakeup_waiting_receivers(std::vector<std::weak_ptr<waiting_receiver_t>> waiting_receivers) {
+        template<class State>
+        void wakeup_waiting_receiver(const std::shared_ptr<State> &state, std::shared_ptr<typename State::waiting_receiver_t> receiver) {
+            std::weak_ptr<typename State::waiting_receiver_t> weak_receiver = receiver;
+            auto exec = receiver->exec_;
+
+            auto handler = [weak_receiver, state] {
+                if (auto receiver = weak_receiver.lock()) {
+                    // If the lock fails the receiver is actually destroyed.
+                    std::unique_lock lock{state->mutex_};
+                    if (receiver->state_ == waiter_state::abandoned) {
+                        state->counters_.spurious_wakeup();
+                        lock.unlock();
+                        pass_on_wakeup(state);
+                        return;
+                    }
+                    if (!state->retry_receive(lock, *receiver)) {
+                        return;
+                    }
+                    lock.unlock();
+                    if (receiver->error_) {
+                        // Cancelled instead of taking the value it was woken for.
+                        pass_on_wakeup(state);
+                    }
+                    after_pop(state);
+                    trace::emit(trace::Phase::Resume, "mpmc::channel", state.get(), receiver->waiting_coro_);
+                    receiver->complete();
+                } else {
+                    pass_on_wakeup(state);
+                }
+            };
+            trace::emit(trace::Phase::Schedule, "mpmc::channel", state.get(), receiver->waiting_coro_);
+            // Reset the receiver before executing the handler
+            // to ensure we don't accidentally keep it alive when
+            // handler is running.
+            receiver.reset();
+            // Copying the executor allocates, and so does wrapping a handler that doesn't fit std::function's buffer.
+            state->counters_.allocation(1 + colite::executor::detail::execute_allocations<decltype(exec), decltype(handler)>);
+            state->counters_.executor_post();
+            colite::executor::execute(exec, std::move(handler));
+        }
+
+        template<class State>
+        void wakeup_waiting_receivers(const std::shared_ptr<State> &state, std::vector<std::shared_ptr<typename State::waiting_receiver_t>> waiting_receivers) {
             // We execute a function on each receivers associated Executor.
             // This function, yet again, checks if data is available and if not
             // re-queues the receiver for wakeup again (unless the receiver is actually destroyed, then we do nothing).
             //
-            // The alternative is to not probe all waiting receivers, but only the first
-            // that we can lock on to. There might be a race where that
-            // coroutine could potentially be destroyed between this function being enqueued for execution
-            // and the execution actually taking place. If that happens then we enter a state where we
-            // might have other readers waiting for data (maybe even all of them) and data is available,
-            // but they haven't been woken up. To fix that we could potentially wakeup the next receiver
-            // if our receiver is destroyed (and there is data available), but for now the approach to wakeup all receivers
-            // is taken.
-            for (auto weak_receiver : waiting_receivers) {
-                if (auto receiver = weak_receiver.lock()) {
-                    auto exec = receiver->exec_;
-
-                    auto handler = [weak_receiver, state = this->state_] {
-                        if (auto receiver = weak_receiver.lock()) {
-                            // If the lock fails the receiver is actually destroyed.
-                            std::unique_lock lock{state->mutex_};
-                            auto maybe_value = state->pop_value(lock);
-                            auto sender_ticket = state->sender_ticket_.lock();
-                            if (maybe_value || !sender_ticket) {
-                                lock.unlock();
-                                receiver->value_ = std::move(maybe_value);
-                                receiver->waiting_coro_.resume();
-                            } else {
-                                // No data and senders are still alive, re-add to list of waiting receivers
-                                // to be woken up again in the future.
-                                state->waiting_receivers_.push_back(receiver);
-                            }
+            // Used by unbounded channels and on close. Lock-free channels wake a single receiver per value instead,
+            // see notify_waiting_receivers.
+            for (auto &receiver : waiting_receivers) {
+                wakeup_waiting_receiver(state, std::move(receiver));
+            }
+        }
+
+        // Called by lock-free senders after a push, without the lock held.
+        template<class State>
+        void notify_waiting_receivers(const std::shared_ptr<State> &state) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (state->parked_receivers_.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            std::unique_lock lock{state->mutex_};
+            auto waiting_receiver = state->take_waiting_receiver(lock);
+            lock.unlock();
+            if (waiting_receiver) {
+                wakeup_waiting_receiver(state, std::move(waiting_receiver));
+            }
+        }
+
+        template<class State>
+        void wakeup_waiting_sender(const std::shared_ptr<State> &state, std::shared_ptr<typename State::waiting_sender_t> sender) {
+            std::weak_ptr<typename State::waiting_sender_t> weak_sender = sender;
+            auto exec = sender->exec_;
+
+            auto handler = [weak_sender, state] {
+                auto sender = weak_sender.lock();
+                std::unique_lock lock{state->mutex_};
+                if (!sender || sender->state_ == waiter_state::abandoned) {
+                    // The room this sender was woken for is still there, pass it on to the next one.
+                    state->counters_.spurious_wakeup();
+                    lock.unlock();
+                    notify_waiting_senders(state);
+                    return;
+                }
+                if (state->send_or_park(lock, *sender, sender->waiting_coro_)) {
+                    // A sender that didn't have to park took the room first.
+                    state->counters_.spurious_wakeup();
+                    state->counters_.requeue();
+                    return;
+                }
+                lock.unlock();
+                if (!sender->closed_) {
+                    notify_waiting_receivers(state);
+                }
+                trace::emit(trace::Phase::Resume, "mpmc::send", state.get(), sender->waiting_coro_);
+                sender->waiting_coro_.resume();
+            };
+            trace::emit(trace::Phase::Schedule, "mpmc::send", state.get(), sender->waiting_coro_);
+            sender.reset();
+            state->counters_.allocation(1 + colite::executor::detail::execute_allocations<decltype(exec), decltype(handler)>);
+            state->counters_.executor_post();
+            colite::executor::execute(exec, std::move(handler));
+        }
+
+        template<class State>
+        void wakeup_waiting_senders(const std::shared_ptr<State> &state, std::vector<std::shared_ptr<typename State::waiting_sender_t>> waiting_senders) {
+            for (auto &sender : waiting_senders) {
+                wakeup_waiting_sender(state, std::move(sender));
+            }
+        }
+
+        // Called after a pop without the lock held. Only lock-free channels can have parked senders.
+        template<class State>
+        void notify_waiting_senders(const std::shared_ptr<State> &state) {
+            if constexpr (State::queue_t::lock_free) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (state->parked_senders_.load(std::memory_order_relaxed) == 0) {
+                    return;
+                }
+                std::unique_lock lock{state->mutex_};
+                auto waiting_sender = state->take_waiting_sender(lock);
+                lock.unlock();
+                if (waiting_sender) {
+                    wakeup_waiting_sender(state, std::move(waiting_sender));
+                }
+            }
+        }
+
+        template<class State>
+        void wakeup_waiting_drain(const std::shared_ptr<State> &state, std::shared_ptr<waiting_drain_t> drain) {
+            std::weak_ptr<waiting_drain_t> weak_drain = drain;
+            auto exec = drain->exec_;
+
+            auto handler = [weak_drain, state] {
+                if (auto drain = weak_drain.lock()) {
+                    std::unique_lock lock{state->mutex_};
+                    if (drain->state_ == waiter_state::abandoned) {
+                        state->counters_.spurious_wakeup();
+                        return;
+                    }
+                    if (state->drain_or_park(lock, *drain, drain->waiting_coro_)) {
+                        // Values were sent again before the drain got to run.
+                        state->counters_.spurious_wakeup();
+                        state->counters_.requeue();
+                        return;
+                    }
+                    lock.unlock();
+                    trace::emit(trace::Phase::Resume, "mpmc::drain", state.get(), drain->waiting_coro_);
+                    drain->waiting_coro_.resume();
+                }
+            };
+            trace::emit(trace::Phase::Schedule, "mpmc::drain", state.get(), drain->waiting_coro_);
+            drain.reset();
+            state->counters_.allocation(1 + colite::executor::detail::execute_allocations<decltype(exec), decltype(handler)>);
+            state->counters_.executor_post();
+            colite::executor::execute(exec, std::move(handler));
+        }
+
+        template<class State>
+        void wakeup_waiting_drains(const std::shared_ptr<State> &state, std::vector<std::shared_ptr<waiting_drain_t>> waiting_drains) {
+            for (auto &drain : waiting_drains) {
+                wakeup_waiting_drain(state, std::move(drain));
+            }
+        }
+
+        // Called after a pop without the lock held, wakes up the drains if the channel is empty now.
+        template<class State>
+        void notify_waiting_drains(const std::shared_ptr<State> &state) {
+            if constexpr (State::queue_t::lock_free) {
+                // Pairs with the fence in drain_or_park.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            // An unbounded channel pops with the lock held, which orders this read after any drain parked before it.
+            if (state->parked_drains_.load(std::memory_order_relaxed) == 0 || state->queue_.depth() != 0) {
+                return;
+            }
+            std::unique_lock lock{state->mutex_};
+            auto waiting_drains = state->take_waiting_drains(lock);
+            lock.unlock();
+            wakeup_waiting_drains(state, std::move(waiting_drains));
+        }
+
+        // Called by receivers after taking a value, without the lock held.
+        template<class State>
+        void after_pop(const std::shared_ptr<State> &state) {
+            notify_waiting_senders(state);
+            notify_waiting_drains(state);
+        }
+
+        // Marks the channel closed and wakes up everyone parked on it in one batch, they see the closed state once
+        // they run. Closing again is harmless, and lets drains see that the last receiver is gone.
+        template<class State>
+        void close_channel(const std::shared_ptr<State> &state) {
+            std::unique_lock lock{state->mutex_};
+            state->closed_.store(true, std::memory_order_relaxed);
+            auto waiting_receivers = state->take_waiting_receivers(lock);
+            auto waiting_senders = state->take_waiting_senders(lock);
+            auto waiting_drains = state->take_waiting_drains(lock);
+            lock.unlock();
+            wakeup_waiting_receivers(state, std::move(waiting_receivers));
+            wakeup_waiting_senders(state, std::move(waiting_senders));
+            wakeup_waiting_drains(state, std::move(waiting_drains));
+        }
+
+        template<class State>
+        void cancel_waiting_receiver(const std::shared_ptr<State> &state, typename State::waiting_receiver_t &receiver, ReceiveError error) {
+            std::unique_lock lock{state->mutex_};
+            switch (receiver.state_.load()) {
+            case waiter_state::idle:
+                // Not parked yet, the awaitable will notice the error and not suspend at all.
+                receiver.error_ = error;
+                break;
+            case waiter_state::queued:
+                state->unpark(lock, receiver);
+                receiver.state_ = waiter_state::in_flight;
+                receiver.error_ = error;
+                lock.unlock();
+                wakeup_waiting_receiver(state, receiver.shared_from_this());
+                break;
+            case waiter_state::in_flight:
+                receiver.error_ = error;
+                break;
+            case waiter_state::done:
+            case waiter_state::abandoned:
+                break;
+            }
+        }
+    }// namespace detail
+
+    template<class T, class Backend = Unbounded>
+    class Sender {
+        using state_t = detail::state_t<T, Backend>;
+        using waiting_sender_t = detail::waiting_sender_t<T>;
+
+        template<class U, class B, class... Args>
+        friend Channel<U, B> channel(Args &&...args);
+
+        std::shared_ptr<state_t> state_;
+
+        explicit Sender(std::shared_ptr<state_t> state) noexcept : state_(std::move(state)) {}
+
+        template<class Exec>
+        auto send_or_park(Exec exec, T value) {
+            struct awaitable {
+                std::shared_ptr<state_t> state_;
+                std::shared_ptr<waiting_sender_t> waiting_sender_;
+
+                awaitable(std::shared_ptr<state_t> state, std::shared_ptr<waiting_sender_t> waiting_sender)
+                    : state_(std::move(state)), waiting_sender_(std::move(waiting_sender)) {}
+                awaitable(awaitable &&) noexcept = default;
+                ~awaitable() {
+                    if (waiting_sender_) {
+                        state_->abandon(*waiting_sender_);
+                    }
+                }
+
+                static constexpr bool await_ready() noexcept {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> to_suspend) {
+                    if (waiting_sender_->state_ == detail::waiter_state::idle) {
+                        std::unique_lock lock{state_->mutex_};
+                        if (state_->send_or_park(lock, *waiting_sender_, to_suspend)) {
+                            return;
+                        }
+                        lock.unlock();
+                        if (!waiting_sender_->closed_) {
+                            detail::notify_waiting_receivers(state_);
+                        }
+                    }
+                    // Sent or closed without waiting, resume on the executor all the same.
+                    std::weak_ptr<waiting_sender_t> alive_ = waiting_sender_;
+                    auto resume = [to_suspend, alive_, channel = state_.get()] {
+                        if (auto alive = alive_.lock()) {
+                            trace::emit(trace::Phase::Resume, "mpmc::send", channel, to_suspend);
+                            to_suspend.resume();
                         }
                     };
-                    // Reset the receiver before executing the handler
-                    // to ensure we don't accidentally keep it alive when
-                    // handler is running.
-                    receiver.reset();
-                    colite::executor::execute(exec, std::move(handler));
+                    state_->counters_.allocation(colite::executor::detail::execute_allocations<decltype(waiting_sender_->exec_), decltype(resume)>);
+                    state_->counters_.executor_post();
+                    trace::emit(trace::Phase::Suspend, "mpmc::send", state_.get(), to_suspend);
+                    trace::emit(trace::Phase::Schedule, "mpmc::send", state_.get(), to_suspend);
+                    colite::executor::execute(waiting_sender_->exec_, std::move(resume));
                 }
+
+                colite::Expected<void, SendError> await_resume() const noexcept {
+                    if (waiting_sender_->closed_) {
+                        return colite::Unexpected(SendError::Closed);
+                    }
+                    return {};
+                }
+            };
+            // The waiting sender, and its executor unless that is an AnyExecutor already.
+            state_->counters_.allocation(1 + colite::executor::detail::any_executor_allocations<Exec>);
+            auto waiting_sender = std::make_shared<waiting_sender_t>(std::move(exec));
+            if (state_->closed()) {
+                waiting_sender->closed_ = true;
+                waiting_sender->state_ = detail::waiter_state::done;
+            } else if (state_->queue_.try_push(value)) {
+                waiting_sender->state_ = detail::waiter_state::done;
+                detail::notify_waiting_receivers(state_);
+            } else {
+                // Full, the sender parks when awaited.
+                waiting_sender->value_ = std::move(value);
             }
+            return awaitable{state_, std::move(waiting_sender)};
         }
 
     public:
-        Sender(const Sender &) = default;
+        Sender(const Sender &other) noexcept : state_(other.state_) {
+            if (state_) {
+                state_->senders_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
         Sender(Sender &&) noexcept = default;
         ~Sender() {
-            if(state_) {
-                std::unique_lock lock(state_->mutex_);
-                if (ticket_.use_count() == 1) {
-                    ticket_.reset();
-                    // This class is the last holder of a ticket!
-                    auto waiting_receivers = std::exchange(state_->waiting_receivers_, decltype(state_->waiting_receivers_){});
-                    lock.unlock();
-                    wakeup_waiting_receivers(std::move(waiting_receivers));
-                }
+            if (state_ && state_->senders_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                // This was the last sender.
+                detail::close_channel(state_);
             }
         }
 
-        Sender &operator=(const Sender &) = default;
-        Sender &operator=(Sender &&) noexcept = default;
+        Sender &operator=(const Sender &other) noexcept {
+            Sender copy(other);
+            std::swap(state_, copy.state_);
+            return *this;
+        }
+        Sender &operator=(Sender &&other) noexcept {
+            Sender moved(std::move(other));
+            std::swap(state_, moved.state_);
+            return *this;
+        }
+
+        /**
+         * @brief Read the instrumentation counters of the channel.
+         * @return A snapshot of the counters, all zero unless `COLITE_INSTRUMENT` is defined.
+         *
+         * The counters are shared by all senders and receivers of the channel.
+         */
+        [[nodiscard]] instrument::Snapshot instrumentation() const noexcept {
+            return state_->counters_.snapshot();
+        }
 
         /**
          * @brief Asynchronously send data on the channel
@@ -160,84 +985,323 @@ namespace colite::mpmc {
          * and the data was successfully enqueued. A closed channel will never accept new data again since all
          * readers are destroyed.
          *
+         * On a `LockFree` channel that is full the sender is suspended until a receiver makes room for the value.
          */
         [[nodiscard]] auto send(colite::executor::Executor auto exec, T value) {
-            using exec_t = decltype(exec);
+            if constexpr (state_t::queue_t::lock_free) {
+                return send_or_park(std::move(exec), std::move(value));
+            } else {
+                using exec_t = decltype(exec);
+                struct awaitable {
+                    // Resumes the sender on exec_, unless the awaitable is gone by then.
+                    struct resume_fn {
+                        std::coroutine_handle<> to_suspend_;
+                        std::weak_ptr<void> alive_;
+                        const void *channel_;
+
+                        void operator()() const {
+                            if(auto alive = alive_.lock()) {
+                                trace::emit(trace::Phase::Resume, "mpmc::send", channel_, to_suspend_);
+                                to_suspend_.resume();
+                            }
+                        }
+                    };
+
+                    exec_t exec_;
+                    bool closed_ = false;
+                    const void *channel_ = nullptr;
+                    std::shared_ptr<void> alive_check_ = std::make_shared<char>(0);
+                    static constexpr bool await_ready() noexcept {
+                        return false;
+                    }
+
+                    void await_suspend(std::coroutine_handle<> to_suspend) noexcept {
+                        trace::emit(trace::Phase::Suspend, "mpmc::send", channel_, to_suspend);
+                        trace::emit(trace::Phase::Schedule, "mpmc::send", channel_, to_suspend);
+                        colite::executor::execute(exec_, resume_fn{to_suspend, alive_check_, channel_});
+                    }
+
+                    colite::Expected<void, SendError> await_resume() const noexcept {
+                        if(closed_) {
+                            return colite::Unexpected(SendError::Closed);
+                        }
+                        return {};
+                    }
+                };
+
+                // The alive check of the awaitable, the handler if the executor type-erases it, and the post that
+                // resumes the sender.
+                state_->counters_.allocation(1 + colite::executor::detail::execute_allocations<exec_t, typename awaitable::resume_fn>);
+                state_->counters_.executor_post();
+
+                if (state_->closed()) {
+                    return awaitable{std::move(exec), true, state_.get()};
+                }
+
+                auto push_and_steal_waiting_receivers = [&] {
+                    std::unique_lock lock{state_->mutex_};
+                    state_->push_value(lock, std::move(value));
+                    return state_->take_waiting_receivers(lock);
+                };
+
+                detail::wakeup_waiting_receivers(state_, push_and_steal_waiting_receivers());
+
+                return awaitable{std::move(exec), false, state_.get()};
+            }
+        }
+
+        /**
+         * @brief Send data without waiting.
+         *
+         * Fails with `SendError::Closed` if all receivers are destroyed, and on a `LockFree` channel with
+         * `SendError::Full` if there is no room for the value.
+         */
+        colite::Expected<void, SendError> try_send(T value) {
+            if constexpr (state_t::queue_t::lock_free) {
+                if (state_->closed()) {
+                    return Unexpected(SendError::Closed);
+                }
+                if (!state_->queue_.try_push(value)) {
+                    return Unexpected(SendError::Full);
+                }
+                detail::notify_waiting_receivers(state_);
+                return {};
+            } else {
+                if (state_->closed()) {
+                    return Unexpected(SendError::Closed);
+                }
+
+                auto push_and_steal_waiting_receivers = [&] {
+                  std::unique_lock lock{state_->mutex_};
+                  state_->push_value(lock, std::move(value));
+                  return state_->take_waiting_receivers(lock);
+                };
+
+                detail::wakeup_waiting_receivers(state_, push_and_steal_waiting_receivers());
+
+                return {};
+            }
+        }
+
+        /**
+         * @brief Close the channel without waiting for all senders to be destroyed.
+         *
+         * All parked receivers and senders are woken up right away. Sending fails with `SendError::Closed` from now
+         * on, while receivers still get all values that were queued before the channel was closed. Closing an already
+         * closed channel does nothing.
+         */
+        void close() {
+            detail::close_channel(state_);
+        }
+
+        /**
+         * @brief Asynchronously wait until every queued value has been received.
+         * @param exec The Executor to resume on once the channel is empty.
+         * @return An `Awaitable<Expected<void, SendError>>`.
+         *
+         * The channel doesn't have to be closed, but nothing stops other senders from filling it up again. To shut a
+         * pipeline down call `close()` first and then `co_await sender.drain(exec)`.
+         *
+         * Fails with `SendError::Closed` if all receivers are destroyed while values are still queued, those values
+         * will never be received.
+         */
+        [[nodiscard]] auto drain(colite::executor::Executor auto exec) {
             struct awaitable {
-                exec_t exec_;
-                bool closed_ = false;
-                std::shared_ptr<void> alive_check_ = std::make_shared<char>(0);
+                std::shared_ptr<state_t> state_;
+                std::shared_ptr<detail::waiting_drain_t> waiting_drain_;
+
+                awaitable(std::shared_ptr<state_t> state, std::shared_ptr<detail::waiting_drain_t> waiting_drain)
+                    : state_(std::move(state)), waiting_drain_(std::move(waiting_drain)) {}
+                awaitable(awaitable &&) noexcept = default;
+                ~awaitable() {
+                    if (waiting_drain_) {
+                        state_->abandon(*waiting_drain_);
+                    }
+                }
+
                 static constexpr bool await_ready() noexcept {
                     return false;
                 }
 
-                void await_suspend(std::coroutine_handle<> to_suspend) noexcept {
-                    std::weak_ptr<void> alive_ = alive_check_;
-                    colite::executor::execute(exec_, [to_suspend, alive_] {
-                        if(auto alive = alive_.lock()) {
-                            to_suspend.resume();
-                        }
-                    });
+                bool await_suspend(std::coroutine_handle<> to_suspend) {
+                    std::unique_lock lock{state_->mutex_};
+                    return state_->drain_or_park(lock, *waiting_drain_, to_suspend);
                 }
 
                 colite::Expected<void, SendError> await_resume() const noexcept {
-                    if(closed_) {
+                    if (waiting_drain_->undelivered_) {
                         return colite::Unexpected(SendError::Closed);
                     }
                     return {};
                 }
             };
+            // The waiting drain, and its executor unless that is an AnyExecutor already.
+            state_->counters_.allocation(1 + colite::executor::detail::any_executor_allocations<decltype(exec)>);
+            auto waiting_drain = std::make_shared<detail::waiting_drain_t>(std::move(exec));
+            return awaitable{state_, std::move(waiting_drain)};
+        }
+    };
 
-            auto receiver_ticket = state_->receiver_ticket_.lock();
-            if (!receiver_ticket) {
-                return awaitable{std::move(exec), true};
-            }
-
-            auto push_and_steal_waiting_receivers = [&] {
-                std::scoped_lock lock{state_->mutex_};
-                state_->data_.push_back(std::move(value));
-                return std::exchange(state_->waiting_receivers_, decltype(state_->waiting_receivers_){});
-            };
-
-            wakeup_waiting_receivers(push_and_steal_waiting_receivers());
+    template<class T, class Backend>
+    class Receiver;
 
-            return awaitable{std::move(exec)};
-        }
+    namespace detail {
+        template<class T, class Backend, class Fn>
+        class for_each_awaitable;
+    }
 
-        colite::Expected<void, SendError> try_send(T value) {
-            auto receiver_ticket = state_->receiver_ticket_.lock();
-            if (!receiver_ticket) {
-                return Unexpected(SendError::Closed);
-            }
+    /**
+     * @brief A pending receive operation on a channel, used with `colite::select`.
+     * @tparam T The type transported inside the channel.
+     *
+     * A `ReceiveOp` doesn't do anything on its own, it only identifies the channel to receive from.
+     */
+    template<class T>
+    class ReceiveOp {
+        template<class U, class B>
+        friend class Receiver;
+        template<class Exec, bool Cancellable, class... Ts>
+        friend struct ::colite::detail::select_awaitable;
 
-            auto push_and_steal_waiting_receivers = [&] {
-              std::scoped_lock lock{state_->mutex_};
-              state_->data_.push_back(std::move(value));
-              return std::exchange(state_->waiting_receivers_, decltype(state_->waiting_receivers_){});
-            };
+        std::shared_ptr<detail::state_t<T>> state_;
 
-            wakeup_waiting_receivers(push_and_steal_waiting_receivers());
+        explicit ReceiveOp(std::shared_ptr<detail::state_t<T>> state) noexcept : state_(std::move(state)) {}
 
-            return {};
-        }
+    public:
+        using value_type = T;
     };
 
-    template<class T>
+    template<class T, class Backend = Unbounded>
     class Receiver {
-        using state_t = detail::state_t<T>;
+        using state_t = detail::state_t<T, Backend>;
         using waiting_receiver_t = detail::waiting_receiver_t<T>;
 
-        template<class U>
-        friend Channel<U> channel();
+        template<class U, class B, class... Args>
+        friend Channel<U, B> channel(Args &&...args);
+        template<class U, class B, class Fn>
+        friend class detail::for_each_awaitable;
 
         std::shared_ptr<state_t> state_;
-        std::shared_ptr<void> ticket_;
 
-        Receiver(std::shared_ptr<state_t> state, std::shared_ptr<void> ticket) noexcept
-            : state_(std::move(state)), ticket_(std::move(ticket)) {
+        explicit Receiver(std::shared_ptr<state_t> state) noexcept : state_(std::move(state)) {}
+
+        struct stop_fn {
+            std::shared_ptr<state_t> *state_;
+            waiting_receiver_t *receiver_;
+            void operator()() const {
+                detail::cancel_waiting_receiver(*state_, *receiver_, ReceiveError::Cancelled);
+            }
+        };
+
+        struct timeout_node final : timer::detail::timer_node {
+            std::shared_ptr<state_t> state_;
+            std::weak_ptr<waiting_receiver_t> receiver_;
+
+            timeout_node(std::shared_ptr<state_t> state, std::weak_ptr<waiting_receiver_t> receiver)
+                : state_(std::move(state)), receiver_(std::move(receiver)) {}
+
+            void fire() override {
+                if (auto receiver = receiver_.lock()) {
+                    detail::cancel_waiting_receiver(state_, *receiver, ReceiveError::TimedOut);
+                }
+            }
+        };
+
+        template<class Exec>
+        auto receive_impl(Exec exec, std::stop_token token, timer::TimerService *timers, timer::clock::time_point deadline) {
+            struct awaitable {
+                std::shared_ptr<state_t> state_;
+                std::shared_ptr<waiting_receiver_t> waiting_receiver_;
+                std::stop_token token_;
+                timer::TimerService *timers_;
+                timer::clock::time_point deadline_;
+                std::shared_ptr<timeout_node> timeout_{};
+                std::optional<std::stop_callback<stop_fn>> stop_callback_{};
+
+                ~awaitable() {
+                    stop_callback_.reset();
+                    if (timeout_) {
+                        timers_->cancel(*timeout_);
+                    }
+                    if (waiting_receiver_) {
+                        state_->abandon(*waiting_receiver_);
+                    }
+                }
+
+                static constexpr bool await_ready() noexcept {
+                    return false;
+                }
+
+                bool await_suspend(std::coroutine_handle<> to_suspend) {
+                    if (state_->try_receive_now(*waiting_receiver_)) {
+                        detail::after_pop(state_);
+                        return false;
+                    }
+                    // Register the cancellation sources before the receiver is visible to senders.
+                    // If one of them triggers right away the receiver is marked with an error and never parked.
+                    if (token_.stop_possible()) {
+                        stop_callback_.emplace(token_, stop_fn{&state_, waiting_receiver_.get()});
+                    }
+                    if (timers_) {
+                        state_->counters_.allocation();
+                        timeout_ = std::make_shared<timeout_node>(state_, waiting_receiver_);
+                        timers_->schedule(timeout_, deadline_);
+                    }
+                    if (state_->receive_or_park(*waiting_receiver_, to_suspend)) {
+                        return true;
+                    }
+                    detail::after_pop(state_);
+                    return false;
+                }
+
+                colite::Expected<T, ReceiveError> await_resume() {
+                    if (waiting_receiver_->value_.has_value()) {
+                        return std::move(*waiting_receiver_->value_);
+                    }
+                    return colite::Unexpected(waiting_receiver_->error_.value_or(ReceiveError::Closed));
+                }
+            };
+            // The waiting receiver, and its executor unless that is an AnyExecutor already.
+            state_->counters_.allocation(1 + colite::executor::detail::any_executor_allocations<Exec>);
+            auto waiting_receiver = std::make_shared<waiting_receiver_t>(std::move(exec));
+            return awaitable{state_, std::move(waiting_receiver), std::move(token), timers, deadline};
         }
 
     public:
+        Receiver(const Receiver &other) noexcept : state_(other.state_) {
+            if (state_) {
+                state_->receivers_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        Receiver(Receiver &&) noexcept = default;
+        ~Receiver() {
+            if (state_ && state_->receivers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                // The last receiver is gone, nothing sent from now on would ever be received.
+                detail::close_channel(state_);
+            }
+        }
+
+        Receiver &operator=(const Receiver &other) noexcept {
+            Receiver copy(other);
+            std::swap(state_, copy.state_);
+            return *this;
+        }
+        Receiver &operator=(Receiver &&other) noexcept {
+            Receiver moved(std::move(other));
+            std::swap(state_, moved.state_);
+            return *this;
+        }
+
+        /**
+         * @brief Read the instrumentation counters of the channel.
+         * @return A snapshot of the counters, all zero unless `COLITE_INSTRUMENT` is defined.
+         *
+         * The counters are shared by all senders and receivers of the channel.
+         */
+        [[nodiscard]] instrument::Snapshot instrumentation() const noexcept {
+            return state_->counters_.snapshot();
+        }
+
         /**
          * @brief Get the available number of data to read from the channel.
          * @return
@@ -245,8 +1309,17 @@ namespace colite::mpmc {
          * @note This is a snapshot in time, it may not be accurate when used later.
          */
         [[nodiscard]] std::size_t available() const noexcept {
-            std::scoped_lock lock{state_->mutex_};
-            return state_->data_.size();
+            return state_->queue_.depth();
+        }
+
+        /**
+         * @brief Read the metrics of the channel without taking the channel lock.
+         * @return A snapshot of the channel metrics.
+         *
+         * Every field is read on its own, so fields may be from slightly different points in time.
+         */
+        [[nodiscard]] ChannelMetrics metrics() const noexcept {
+            return state_->metrics();
         }
 
         /**
@@ -263,24 +1336,24 @@ namespace colite::mpmc {
                 std::shared_ptr<state_t> state_;
                 std::shared_ptr<waiting_receiver_t> waiting_receiver_;
 
+                awaitable(std::shared_ptr<state_t> state, std::shared_ptr<waiting_receiver_t> waiting_receiver)
+                    : state_(std::move(state)), waiting_receiver_(std::move(waiting_receiver)) {}
+                awaitable(awaitable &&) noexcept = default;
+                ~awaitable() {
+                    if (waiting_receiver_) {
+                        state_->abandon(*waiting_receiver_);
+                    }
+                }
+
                 static constexpr bool await_ready() noexcept {
                     return false;
                 }
 
                 bool await_suspend(std::coroutine_handle<> to_suspend) {
-                    std::unique_lock lock{state_->mutex_};
-                    auto sender_ticket = state_->sender_ticket_.lock();
-                    if (state_->data_.empty()) {
-                        if (!sender_ticket) {
-                            waiting_receiver_->value_ = std::nullopt;
-                            return false;
-                        }
-                        waiting_receiver_->waiting_coro_ = to_suspend;
-                        state_->waiting_receivers_.push_back(waiting_receiver_);
+                    if (state_->receive_or_park(*waiting_receiver_, to_suspend)) {
                         return true;
                     }
-                    waiting_receiver_->value_ = std::move(state_->data_.front());
-                    state_->data_.pop_front();
+                    detail::after_pop(state_);
                     return false;
                 }
 
@@ -292,11 +1365,71 @@ namespace colite::mpmc {
                     return colite::Unexpected(ReceiveError::Closed);
                 }
             };
-            auto waiting_receiver = std::make_shared<waiting_receiver_t>();
-            waiting_receiver->exec_ = std::move(exec);
+            // The waiting receiver, and its executor unless that is an AnyExecutor already.
+            state_->counters_.allocation(1 + colite::executor::detail::any_executor_allocations<decltype(exec)>);
+            auto waiting_receiver = std::make_shared<waiting_receiver_t>(std::move(exec));
             return awaitable{state_, std::move(waiting_receiver)};
         }
 
+        /**
+         * @brief Asynchronously receive data from the channel, giving up if `token` is stopped first.
+         * @param exec The Executor to resume on
+         * @param token Stop token used to cancel the receive.
+         * @return An `AWAITABLE<Expected<T, ReceiveError>>`.
+         *
+         * A cancelled receiver is removed from the channel immediately and resumed on `exec` with
+         * `ReceiveError::Cancelled`. No data is consumed by a cancelled receive.
+         */
+        [[nodiscard]] auto receive(colite::executor::Executor auto exec, std::stop_token token) {
+            return receive_impl(std::move(exec), std::move(token), nullptr, {});
+        }
+
+        /**
+         * @brief Asynchronously receive data from the channel, giving up once `deadline` has passed.
+         * @param timers The timer service that tracks the deadline.
+         * @param exec The Executor to resume on
+         * @param deadline The point in time to give up at.
+         * @param token Optional stop token used to cancel the receive.
+         * @return An `AWAITABLE<Expected<T, ReceiveError>>`.
+         *
+         * If the deadline passes first the receiver is removed from the channel and resumed with `ReceiveError::TimedOut`.
+         */
+        [[nodiscard]] auto receive_until(timer::TimerService &timers, colite::executor::Executor auto exec, timer::clock::time_point deadline, std::stop_token token = {}) {
+            return receive_impl(std::move(exec), std::move(token), &timers, deadline);
+        }
+
+        /**
+         * @brief Asynchronously receive data from the channel, giving up after `timeout`.
+         *
+         * See `receive_until`.
+         */
+        [[nodiscard]] auto receive_for(timer::TimerService &timers, colite::executor::Executor auto exec, timer::clock::duration timeout, std::stop_token token = {}) {
+            return receive_until(timers, std::move(exec), timer::clock::now() + timeout, std::move(token));
+        }
+
+        /**
+         * @brief `receive_until` using `TimerService::default_service()`.
+         */
+        [[nodiscard]] auto receive_until(colite::executor::Executor auto exec, timer::clock::time_point deadline, std::stop_token token = {}) {
+            return receive_until(timer::TimerService::default_service(), std::move(exec), deadline, std::move(token));
+        }
+
+        /**
+         * @brief `receive_for` using `TimerService::default_service()`.
+         */
+        [[nodiscard]] auto receive_for(colite::executor::Executor auto exec, timer::clock::duration timeout, std::stop_token token = {}) {
+            return receive_for(timer::TimerService::default_service(), std::move(exec), timeout, std::move(token));
+        }
+
+        /**
+         * @brief Create a receive operation to use with `colite::select`.
+         *
+         * Only `Unbounded` channels can be selected on.
+         */
+        [[nodiscard]] ReceiveOp<T> receive_op() const requires std::same_as<Backend, Unbounded> {
+            return ReceiveOp<T>(state_);
+        }
+
         /**
          * @brief Try to receive a value without blocking.
          * @return The oldest value from the channel, or an error indicating if its closed or not.
@@ -308,43 +1441,195 @@ namespace colite::mpmc {
          * (one for disconnection, one for an empty buffer).
          */
         [[nodiscard]] colite::Expected<T, TryReceiveError> try_receive() {
-            std::unique_lock lock(state_->mutex_);
-            auto maybe_value = state_->pop_value(lock);
-            if(maybe_value.has_value()) {
-                return std::move(*maybe_value);
+            if constexpr (state_t::queue_t::lock_free) {
+                if (auto value = state_->queue_.try_pop()) {
+                    detail::after_pop(state_);
+                    return std::move(*value);
+                }
             }
-            if(auto _l = state_->sender_ticket_.lock())
-            {
-                return colite::Unexpected(TryReceiveError::Empty);
+            std::unique_lock lock(state_->mutex_);
+            auto retval = state_->take_value(lock);
+            lock.unlock();
+            if (retval.has_value()) {
+                detail::after_pop(state_);
             }
-            return colite::Unexpected(TryReceiveError::Closed);
+            return retval;
+        }
+
+        /**
+         * @brief Close the channel without waiting for all receivers to be destroyed.
+         *
+         * All parked receivers and senders are woken up right away. Sending fails with `SendError::Closed` from now
+         * on, and receivers get the values that are still queued before they are told that the channel is closed.
+         */
+        void close() {
+            detail::close_channel(state_);
         }
     };
 
+    namespace detail {
+        // The one receiver of a `for_each` loop. It is parked and woken up like any other receiver, but instead of
+        // resuming the coroutine on every wakeup it hands everything that is queued to the function and parks again.
+        template<class T, class Backend, class Fn>
+        struct for_each_receiver_t final: waiting_receiver_t<T> {
+            std::shared_ptr<state_t<T, Backend>> channel_;
+            Fn fn_;
+            // Values taken from an unbounded channel in one go, kept to reuse its capacity.
+            std::vector<T, instrument::CountingAllocator<T>> batch_;
+            std::exception_ptr exception_;
+
+            for_each_receiver_t(colite::executor::AnyExecutor exec, std::shared_ptr<state_t<T, Backend>> channel, Fn fn)
+                : waiting_receiver_t<T>(std::move(exec)), channel_(std::move(channel)), fn_(std::move(fn)),
+                  batch_(instrument::CountingAllocator<T>(channel_->counters_)) {}
+
+            // Calls fn_ with every value that is queued, then parks. Returns true if the receiver was parked, false
+            // once the channel is closed and empty or fn_ has thrown.
+            bool run(std::coroutine_handle<> to_suspend) {
+                try {
+                    for (;;) {
+                        if (this->value_) {
+                            auto value = std::move(*this->value_);
+                            this->value_.reset();
+                            std::invoke(fn_, std::move(value));
+                        }
+                        drain_queue();
+                        if (channel_->receive_or_park(*this, to_suspend)) {
+                            return true;
+                        }
+                        if (!this->value_) {
+                            return false;
+                        }
+                        after_pop(channel_);
+                    }
+                } catch (...) {
+                    exception_ = std::current_exception();
+                    return false;
+                }
+            }
+
+            void drain_queue() {
+                if constexpr (state_t<T, Backend>::queue_t::lock_free) {
+                    while (auto value = channel_->queue_.try_pop()) {
+                        after_pop(channel_);
+                        std::invoke(fn_, std::move(*value));
+                    }
+                } else {
+                    // Take everything under a single lock, fn_ is called without it.
+                    {
+                        std::unique_lock lock{channel_->mutex_};
+                        while (auto value = channel_->queue_.try_pop()) {
+                            batch_.push_back(std::move(*value));
+                        }
+                    }
+                    if (batch_.empty()) {
+                        return;
+                    }
+                    after_pop(channel_);
+                    for (auto &value : batch_) {
+                        std::invoke(fn_, std::move(value));
+                    }
+                    batch_.clear();
+                }
+            }
+
+            void complete() override {
+                if (!run(this->waiting_coro_)) {
+                    this->waiting_coro_.resume();
+                }
+            }
+        };
+
+        template<class T, class Backend, class Fn>
+        class for_each_awaitable {
+            // Keeps the channel open from the receiving side for as long as the loop runs.
+            Receiver<T, Backend> receiver_;
+            std::shared_ptr<for_each_receiver_t<T, Backend, Fn>> waiting_receiver_;
+
+        public:
+            template<class Exec>
+            for_each_awaitable(Exec exec, Receiver<T, Backend> receiver, Fn fn)
+                : receiver_(std::move(receiver)) {
+                // The receiver and its executor unless that is an AnyExecutor already, allocated once for the whole loop.
+                receiver_.state_->counters_.allocation(1 + colite::executor::detail::any_executor_allocations<Exec>);
+                waiting_receiver_ = std::make_shared<for_each_receiver_t<T, Backend, Fn>>(std::move(exec), receiver_.state_, std::move(fn));
+            }
+            for_each_awaitable(for_each_awaitable &&) noexcept = default;
+            ~for_each_awaitable() {
+                if (waiting_receiver_) {
+                    receiver_.state_->abandon(*waiting_receiver_);
+                }
+            }
+
+            static constexpr bool await_ready() noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> to_suspend) {
+                return waiting_receiver_->run(to_suspend);
+            }
+
+            void await_resume() {
+                if (waiting_receiver_->exception_) {
+                    std::rethrow_exception(waiting_receiver_->exception_);
+                }
+            }
+        };
+    }// namespace detail
+
+    /**
+     * @brief Asynchronously call `fn` with every value received on a channel, until it is closed.
+     * @param exec The Executor to call `fn` and resume on.
+     * @param receiver The receiving end to iterate, kept alive until the loop is done.
+     * @param fn Function called with every value, as `fn(T&&)`.
+     * @return An `AWAITABLE<void>`, that completes once the channel is closed and all values have been handed to `fn`.
+     *
+     * Compared to calling `receive` in a loop the whole iteration uses a single parked receiver, and every wakeup
+     * hands all queued values to `fn` before parking again. `fn` runs on `exec` while the awaiting coroutine stays
+     * suspended.
+     *
+     * If `fn` throws the loop stops and the exception is rethrown from `co_await`. On an `Unbounded` channel the rest
+     * of the values taken in the same batch are dropped.
+     *
+     * ```cpp
+     * co_await colite::mpmc::for_each(exec, receiver, [&](int value) { sum += value; });
+     * ```
+     */
+    template<class T, class Backend, class Fn>
+        requires std::invocable<Fn &, T &&>
+    [[nodiscard]] auto for_each(colite::executor::Executor auto exec, Receiver<T, Backend> receiver, Fn fn) {
+        return detail::for_each_awaitable<T, Backend, Fn>(std::move(exec), std::move(receiver), std::move(fn));
+    }
+
     /**
      * @brief Return-type for `channel<T>()`.
      * @tparam T The type transported inside the channel.
+     * @tparam Backend The queue backend of the channel.
      */
-    template<class T>
+    template<class T, class Backend>
     struct Channel {
-        Sender<T> sender;
-        Receiver<T> receiver;
+        Sender<T, Backend> sender;
+        Receiver<T, Backend> receiver;
     };
 
     /**
      * @brief Create a new channel to send the specified type
      * @tparam T The type transported with the channel
+     * @tparam Backend The queue backend, `Unbounded` or `LockFree`.
+     * @param args Arguments for the backend queue, the capacity for `LockFree`.
      * @return The sender and receiver of the new channel.
+     *
+     * ```cpp
+     * auto [sender, receiver] = colite::mpmc::channel<int>();
+     * auto [lf_sender, lf_receiver] = colite::mpmc::channel<int, colite::mpmc::LockFree>(1024);
+     * ```
      */
-    template<class T>
-    Channel<T> channel() {
-        auto state = std::make_shared<detail::state_t<T>>();
-        auto sender_ticket = std::make_shared<char>(0);
-        auto receiver_ticket = std::make_shared<char>(0);
-        state->sender_ticket_ = sender_ticket;
-        state->receiver_ticket_ = receiver_ticket;
-        Sender<T> sender(state, std::move(sender_ticket));
-        Receiver<T> receiver(std::move(state), std::move(receiver_ticket));
-        return Channel<T>{std::move(sender), std::move(receiver)};
+    template<class T, class Backend = Unbounded, class... Args>
+    Channel<T, Backend> channel(Args &&...args) {
+        auto state = std::make_shared<detail::state_t<T, Backend>>(std::forward<Args>(args)...);
+        // The state, and the buffer of a lock-free queue. An unbounded queue counts its own allocations.
+        state->counters_.allocation(detail::state_t<T, Backend>::queue_t::lock_free ? 2 : 1);
+        Sender<T, Backend> sender(state);
+        Receiver<T, Backend> receiver(std::move(state));
+        return Channel<T, Backend>{std::move(sender), std::move(receiver)};
     }
-}// namespace colite::sync::mpmc
\ No newline at end of file
+}// namespace colite::sync::mpmc
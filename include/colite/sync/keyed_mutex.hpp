@@ -0,0 +1,309 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Async locks per key, striped over a fixed number of Mutexes
+ *
+ * A `Mutex<T>` per key is expensive when there are many keys: every one carries a `std::mutex`, a waiter queue and its
+ * value. A `StripedMutex<Stripes>` instead hashes keys onto a fixed array of `Stripes` Mutexes, each on its own cache
+ * lines so that tasks locking different stripes from different threads do not slow each other down through false
+ * sharing. Keys that hash onto the same stripe share a lock, which is safe but serializes them, so pick `Stripes`
+ * well above the number of keys expected to be locked at the same time.
+ *
+ * `KeyedMutex<K>` does the hashing with `std::hash<K>` (or a custom hasher) and is what most code wants.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * task transfer(colite::sync::KeyedMutex<std::string>& accounts, std::string from, std::string to) {
+ *     // Locks both accounts, in an order that can't deadlock with another transfer locking them the other way round.
+ *     auto guards = co_await accounts.lock_many(my_exec, std::array{from, to});
+ *     // ...
+ * }
+ * ```
+ */
+
+#include <algorithm>
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <colite/detail/cache_line.hpp>
+#include <colite/executor/executor.hpp>
+#include <colite/sync/mutex.hpp>
+
+namespace colite::sync
+{
+    namespace detail {
+        // The awaitable returned by `lock_many`. It wraps a coroutine that takes the stripes one after the other and
+        // transfers back to the awaiting coroutine once it has them all. Destroying it before it finished releases the
+        // stripes taken so far and abandons the one being waited for.
+        template<class Result>
+        class lock_many_op {
+        public:
+            struct promise_type {
+                std::optional<Result> result_;
+                std::exception_ptr exception_;
+                std::coroutine_handle<> continuation_;
+
+                lock_many_op get_return_object() noexcept {
+                    return lock_many_op{std::coroutine_handle<promise_type>::from_promise(*this)};
+                }
+
+                static std::suspend_always initial_suspend() noexcept {
+                    return {};
+                }
+
+                auto final_suspend() noexcept {
+                    struct final_awaiter {
+                        static bool await_ready() noexcept {
+                            return false;
+                        }
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+                            return self.promise().continuation_;
+                        }
+                        void await_resume() noexcept {}
+                    };
+                    return final_awaiter{};
+                }
+
+                void return_value(Result result) {
+                    result_.emplace(std::move(result));
+                }
+
+                void unhandled_exception() noexcept {
+                    exception_ = std::current_exception();
+                }
+            };
+
+            lock_many_op(lock_many_op && rhs) noexcept: handle_(std::exchange(rhs.handle_, nullptr)) {}
+            lock_many_op & operator=(lock_many_op &&) = delete;
+
+            ~lock_many_op() {
+                if(handle_) {
+                    handle_.destroy();
+                }
+            }
+
+            static bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> to_suspend) noexcept {
+                handle_.promise().continuation_ = to_suspend;
+                return handle_;
+            }
+
+            Result await_resume() {
+                auto & promise = handle_.promise();
+                if(promise.exception_) {
+                    std::rethrow_exception(promise.exception_);
+                }
+                return std::move(*promise.result_);
+            }
+        private:
+            std::coroutine_handle<promise_type> handle_;
+
+            explicit lock_many_op(std::coroutine_handle<promise_type> handle): handle_(handle) {}
+        };
+    }// namespace detail
+
+    template<class K, std::size_t Stripes, class Hash, class Policy>
+    class KeyedMutex;
+
+    /**
+     * @brief A fixed array of `Stripes` async locks, selected by hash.
+     * @tparam Stripes The number of locks.
+     * @tparam Policy The lock policy of every stripe, see `Mutex`.
+     */
+    template<std::size_t Stripes, class Policy = Fair>
+    class StripedMutex {
+        static_assert(Stripes > 0, "A StripedMutex needs at least one stripe");
+
+        template<class, std::size_t, class, class>
+        friend class KeyedMutex;
+
+        struct empty {};
+
+        struct alignas(colite::detail::cache_line_size) stripe_t {
+            Mutex<empty, Policy> mutex_{empty{}};
+        };
+
+        std::array<stripe_t, Stripes> stripes_;
+    public:
+        /**
+         * @brief Holds one stripe locked, unlocks it on destruction.
+         */
+        using Guard = MutexGuard<empty, Policy>;
+
+        /**
+         * @brief Holds every stripe taken by `lock_many` locked, unlocks them on destruction.
+         *
+         * Like `MutexGuard` it is movable but not copyable.
+         */
+        class Guards {
+            friend class StripedMutex;
+
+            std::vector<Guard> guards_;
+        public:
+            Guards() = default;
+
+            /**
+             * @brief Unlock all stripes before destruction, does nothing if they are unlocked already.
+             */
+            void unlock() {
+                while(!guards_.empty()) {
+                    guards_.pop_back();
+                }
+            }
+
+            /**
+             * @brief The number of distinct stripes held, keys sharing a stripe are only locked once.
+             */
+            [[nodiscard]] std::size_t size() const noexcept {
+                return guards_.size();
+            }
+        };
+
+        /**
+         * @brief The stripe a hash value maps to.
+         *
+         * `std::hash` of an integer is the integer itself on the common standard libraries, so the hash is mixed first
+         * to keep keys that only differ in their high bits, or are all multiples of `Stripes`, from sharing a stripe.
+         */
+        [[nodiscard]] static constexpr std::size_t stripe(std::size_t hash) noexcept {
+            auto mixed = static_cast<std::uint64_t>(hash);
+            mixed ^= mixed >> 33;
+            mixed *= 0xff51afd7ed558ccdULL;
+            mixed ^= mixed >> 33;
+            return static_cast<std::size_t>(mixed % Stripes);
+        }
+
+        /**
+         * @brief The number of stripes.
+         */
+        [[nodiscard]] static constexpr std::size_t size() noexcept {
+            return Stripes;
+        }
+
+        /**
+         * @brief Attempt to lock the stripe of `hash` without waiting.
+         * @return A Guard if the stripe was free, an empty optional otherwise.
+         */
+        std::optional<Guard> try_lock(std::size_t hash) & noexcept {
+            return stripes_[stripe(hash)].mutex_.try_lock();
+        }
+
+        /**
+         * @brief Asynchronously lock the stripe of `hash`.
+         * @param exec The Executor associated with the coroutine
+         * @param hash The hash value of the key to lock.
+         * @return An awaitable producing a `Guard`.
+         */
+        auto lock(colite::executor::Executor auto exec, std::size_t hash) & {
+            return stripes_[stripe(hash)].mutex_.lock(std::move(exec));
+        }
+
+        /**
+         * @brief Asynchronously lock the stripes of all `hashes`.
+         * @param exec The Executor associated with the coroutine
+         * @param hashes A range of the hash values of the keys to lock.
+         * @return An awaitable producing `Guards`.
+         *
+         * The stripes are locked one at a time in ascending order, so two tasks locking overlapping sets of keys can't
+         * deadlock, whatever order they list the keys in. A stripe shared by several keys is locked once.
+         */
+        template<colite::executor::Executor Exec, class R>
+        auto lock_many(Exec exec, R && hashes) & {
+            std::vector<std::size_t> stripes;
+            for(std::size_t hash : hashes) {
+                stripes.push_back(stripe(hash));
+            }
+            return lock_stripes(*this, std::move(exec), std::move(stripes));
+        }
+    private:
+        template<class Exec>
+        static detail::lock_many_op<Guards> lock_stripes(StripedMutex & self, Exec exec, std::vector<std::size_t> stripes) {
+            std::sort(stripes.begin(), stripes.end());
+            stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+            Guards guards;
+            guards.guards_.reserve(stripes.size());
+            for(auto index : stripes) {
+                guards.guards_.push_back(co_await self.stripes_[index].mutex_.lock(exec));
+            }
+            co_return guards;
+        }
+    };
+
+    /**
+     * @brief Async locks per key of type `K`, striped over `Stripes` Mutexes.
+     * @tparam K The key type.
+     * @tparam Stripes The number of locks keys are hashed onto.
+     * @tparam Hash The hasher for `K`.
+     * @tparam Policy The lock policy of every stripe, see `Mutex`.
+     *
+     * Locking a key only excludes tasks locking a key on the same stripe. The Mutex does not hold any values, keep
+     * the data guarded by a key wherever it belongs.
+     */
+    template<class K, std::size_t Stripes = 64, class Hash = std::hash<K>, class Policy = Fair>
+    class KeyedMutex {
+        using striped_t = StripedMutex<Stripes, Policy>;
+
+        striped_t striped_;
+        [[no_unique_address]] Hash hash_;
+    public:
+        using Guard = typename striped_t::Guard;
+        using Guards = typename striped_t::Guards;
+
+        KeyedMutex() = default;
+        explicit KeyedMutex(Hash hash): hash_(std::move(hash)) {}
+
+        /**
+         * @brief The stripe `key` maps to, keys on the same stripe share a lock.
+         */
+        [[nodiscard]] std::size_t stripe(const K & key) const {
+            return striped_t::stripe(hash_(key));
+        }
+
+        /**
+         * @brief Attempt to lock `key` without waiting.
+         * @return A Guard if the key's stripe was free, an empty optional otherwise.
+         */
+        std::optional<Guard> try_lock(const K & key) & {
+            return striped_.try_lock(hash_(key));
+        }
+
+        /**
+         * @brief Asynchronously lock `key`.
+         * @param exec The Executor associated with the coroutine
+         * @param key The key to lock.
+         * @return An awaitable producing a `Guard`.
+         */
+        auto lock(colite::executor::Executor auto exec, const K & key) & {
+            return striped_.lock(std::move(exec), hash_(key));
+        }
+
+        /**
+         * @brief Asynchronously lock all `keys`, in an order that can't deadlock.
+         * @param exec The Executor associated with the coroutine
+         * @param keys A range of the keys to lock, in any order and possibly with duplicates.
+         * @return An awaitable producing `Guards`.
+         *
+         * See `StripedMutex::lock_many`.
+         */
+        template<colite::executor::Executor Exec, class R>
+        auto lock_many(Exec exec, R && keys) & {
+            std::vector<std::size_t> stripes;
+            for(const K & key : keys) {
+                stripes.push_back(stripe(key));
+            }
+            return striped_t::lock_stripes(striped_, std::move(exec), std::move(stripes));
+        }
+    };
+}// namespace colite::sync
@@ -20,19 +20,67 @@
  *     // value.unlock(); Not necessary, done automatically at the end of scope.
  * }
  * ```
+ *
+ * Waiters are queued by priority, see `lock(exec, priority)`, and in the order they started waiting within a priority.
+ * What happens on unlock is chosen by the `Policy` parameter:
+ *
+ *  * `Fair` hands the Mutex directly to the first waiter. Nobody can take it in between, but every hand-off waits for
+ *    the woken waiter to be scheduled on its executor.
+ *  * `Barging` unlocks the Mutex and wakes the first waiter, which then has to lock it again. A task calling `lock` or
+ *    `try_lock` in the meantime takes it first, which keeps the Mutex busy at the cost of fairness.
+ *  * `Adaptive<StarvationUs>` barges until a woken waiter has been waiting for more than `StarvationUs` microseconds,
+ *    then hands off like `Fair` until every starving waiter has had the Mutex.
  */
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
 #include <coroutine>
+#include <cstdint>
 #include <mutex>
 #include <memory>
 #include <optional>
+#include <stop_token>
 
+#include <colite/detail/cpu_relax.hpp>
+#include <colite/detail/intrusive_list.hpp>
 #include <colite/executor/executor.hpp>
+#include <colite/expected.hpp>
+#include <colite/instrument.hpp>
+#include <colite/timer/timer.hpp>
+#include <colite/trace/trace.hpp>
 
 namespace colite::sync
 {
-    template<class T>
+    /**
+     * @brief The reason a cancellable lock attempt gave up.
+     */
+    enum class LockError : std::uint8_t
+    {
+        Cancelled,
+        TimedOut,
+    };
+
+    /**
+     * @brief Unlocking hands the Mutex directly to the first waiter.
+     */
+    struct Fair {};
+
+    /**
+     * @brief Unlocking frees the Mutex and wakes the first waiter, anyone can take the Mutex before it runs.
+     */
+    struct Barging {};
+
+    /**
+     * @brief `Barging` until a waiter has waited longer than `StarvationUs` microseconds, then `Fair` until it got the lock.
+     */
+    template<std::uint32_t StarvationUs = 1000>
+    struct Adaptive {
+        static constexpr std::chrono::microseconds starvation_threshold{StarvationUs};
+    };
+
+    template<class T, class Policy = Fair>
     class Mutex;
 
     /**
@@ -43,14 +91,14 @@ namespace colite::sync
      *
      * A guard is not copy constructible/assignable. It is however movable.
      */
-    template<class T>
+    template<class T, class Policy = Fair>
     class MutexGuard {
-        template<class>
+        template<class, class>
         friend class Mutex;
 
-        Mutex<T>* mutex_ = nullptr;
+        Mutex<T, Policy>* mutex_ = nullptr;
 
-        MutexGuard(Mutex<T>& mutex_): mutex_(&mutex_) {}
+        MutexGuard(Mutex<T, Policy>& mutex_): mutex_(&mutex_) {}
 
         void unlock_impl();
     public:
@@ -79,82 +127,454 @@ namespace colite::sync
         const T* operator->() const noexcept;
     };
 
-    template<class T>
+    template<class T, class Policy>
     class Mutex {
-        template<class>
+        template<class, class>
         friend class MutexGuard;
 
-        struct waiter_t
+        static constexpr bool fair = std::same_as<Policy, Fair>;
+        static constexpr bool adaptive = requires { Policy::starvation_threshold; };
+        static_assert(fair || adaptive || std::same_as<Policy, Barging>, "Policy must be Fair, Barging or Adaptive");
+
+        enum class waiter_state
+        {
+            idle,
+            queued,
+            in_flight,
+            done,
+            abandoned,
+        };
+
+        struct waiter_t: colite::detail::intrusive_list_hook<waiter_t>, std::enable_shared_from_this<waiter_t>
         {
             Mutex * mutex_;
             std::coroutine_handle<> coroutine_;
             executor::AnyExecutor exec_;
+            // Written with mutex_->mut_ held. `done` is final, which lets the destructor skip the lock.
+            std::atomic<waiter_state> state_ = waiter_state::idle;
+            std::optional<LockError> error_;
+            int priority_;
+            // Set with mutex_->mut_ held when unlock hands the lock to this waiter. The waiter owns the lock from then on.
+            bool handed_off_ = false;
+            // Adaptive only, written with mutex_->mut_ held.
+            bool starving_ = false;
+            timer::clock::time_point queued_since_{};
+            [[no_unique_address]] instrument::Stopwatch wait_timer_;
+
+            waiter_t(Mutex * m, executor::Executor auto exec, int priority = 0): mutex_(m), exec_(std::move(exec)), priority_(priority) {}
+        };
 
-            waiter_t(Mutex * m, executor::Executor auto exec): mutex_(m), exec_(std::move(exec)) {}
+        struct stop_fn
+        {
+            waiter_t * waiter_;
+            void operator()() const {
+                waiter_->mutex_->cancel_waiter(*waiter_, LockError::Cancelled);
+            }
+        };
+
+        struct timeout_node final: timer::detail::timer_node
+        {
+            std::weak_ptr<waiter_t> waiter_;
+            explicit timeout_node(std::weak_ptr<waiter_t> waiter): waiter_(std::move(waiter)) {}
+
+            void fire() override {
+                if(auto waiter = waiter_.lock()) {
+                    waiter->mutex_->cancel_waiter(*waiter, LockError::TimedOut);
+                }
+            }
         };
 
         std::mutex mut_;
-        bool locked_ = false;
+        // Written with mut_ held, read without it while spinning.
+        std::atomic<bool> locked_ = false;
         T value_;
-        std::vector<std::weak_ptr<waiter_t>> waiters_;
+        colite::detail::intrusive_list<waiter_t> waiters_;
+        // Adaptive only, the number of queued or woken waiters marked as starving. Unlock hands off while it's not 0.
+        std::size_t starving_waiters_ = 0;
+        [[no_unique_address]] instrument::Counters counters_;
+        [[no_unique_address]] instrument::LockCounters lock_counters_;
+        // Started whenever the lock is taken, written with mut_ held.
+        [[no_unique_address]] instrument::Stopwatch hold_timer_;
+
+        // See `Mutex(value, max_spin)`, spinning is off while this is zero.
+        timer::clock::duration max_spin_{};
+        // Moving average of how long the lock is held, kept only when spinning. Written with mut_ held, read without it.
+        std::atomic<timer::clock::rep> average_hold_ = 0;
+        timer::clock::time_point acquired_at_{};
+
+        // Called with mut_ held whenever locked_ is set.
+        void acquired() noexcept {
+            lock_counters_.acquired();
+            hold_timer_.start();
+            if(max_spin_ != timer::clock::duration::zero()) {
+                acquired_at_ = timer::clock::now();
+            }
+        }
+        void acquired_after_wait(const waiter_t & waiter) noexcept {
+            lock_counters_.acquired_after_wait(waiter.wait_timer_.elapsed_ns());
+            hold_timer_.start();
+            if(max_spin_ != timer::clock::duration::zero()) {
+                acquired_at_ = timer::clock::now();
+            }
+        }
+        // Keeps the queue ordered by priority. New waiters go behind waiters of the same priority, requeued waiters
+        // that lost the lock to a barging task go in front of them.
+        //
+        // The queue is a plain list searched linearly, from the back for new waiters. That is O(1) while everyone uses
+        // the same priority, but a waiter with a higher priority than all queued ones walks the whole queue, O(n).
+        void enqueue(waiter_t & waiter, bool requeue = false) {
+            waiter.state_ = waiter_state::queued;
+            waiter_t * before = nullptr;
+            if(requeue) {
+                before = waiters_.front();
+                while(before && before->priority_ > waiter.priority_) {
+                    before = before->next_;
+                }
+            }
+            else {
+                for(auto * queued = waiters_.back(); queued && queued->priority_ < waiter.priority_; queued = queued->prev_) {
+                    before = queued;
+                }
+            }
+            waiters_.insert_before(before, waiter);
+            lock_counters_.queue_depth(waiters_.size());
+            trace::emit(trace::Phase::Suspend, "mutex", this, waiter.coroutine_);
+        }
 
         void wakeup_waiter(std::shared_ptr<waiter_t> waiter) {
             std::weak_ptr<waiter_t> weak_waiter = waiter;
-            // Handler is posted to the waiters Executor, where a life-time check of the associated awaitable is done
+            // Handler is posted to the waiters Executor, where a life-time check of the associated awaitable is done.
             //
-            // Then a lock attempt is made, if unsuccessful then the associated waiter is added to the list
-            // of waiters.
+            // The waiter either owns the lock already, handed to it by `hand_off`, was cancelled and is resumed with its
+            // error, or was woken by `wake_first` and tries to take the lock, going back to the queue if a barging task
+            // got it first. An awaitable that was destroyed while the handler was in flight has passed the lock or the
+            // wakeup on in `abandon_waiter`.
             auto handler = [weak_waiter] {
               if(auto waiter = weak_waiter.lock()) {
-                  std::unique_lock lock(waiter->mutex_->mut_);
-                  if(!waiter->mutex_->locked_) {
-                      waiter->mutex_->locked_ = true;
-                      lock.unlock();
-                      waiter->coroutine_.resume();
+                  auto * mutex = waiter->mutex_;
+                  std::unique_lock lock(mutex->mut_);
+                  if(waiter->state_ == waiter_state::abandoned) {
+                      mutex->counters_.spurious_wakeup();
+                      return;
+                  }
+                  std::shared_ptr<waiter_t> next;
+                  if(waiter->handed_off_) {
+                      mutex->acquired_after_wait(*waiter);
+                  }
+                  else if(waiter->error_) {
+                      // This waiter may have been woken for a free lock, pass the wakeup on.
+                      next = mutex->wake_first();
+                  }
+                  else if(!mutex->locked_.load(std::memory_order_relaxed)) {
+                      mutex->locked_.store(true, std::memory_order_relaxed);
+                      mutex->acquired_after_wait(*waiter);
                   }
                   else {
-                      waiter->mutex_->waiters_.push_back(waiter);
+                      mutex->counters_.spurious_wakeup();
+                      mutex->counters_.requeue();
+                      mutex->starve(*waiter);
+                      mutex->enqueue(*waiter, true);
+                      return;
                   }
+                  waiter->state_ = waiter_state::done;
+                  mutex->unstarve(*waiter);
+                  lock.unlock();
+                  if(next) {
+                      mutex->wakeup_waiter(std::move(next));
+                  }
+                  trace::emit(trace::Phase::Resume, "mutex", mutex, waiter->coroutine_);
+                  waiter->coroutine_.resume();
               }
             };
             auto exec = waiter->exec_;
+            trace::emit(trace::Phase::Schedule, "mutex", this, waiter->coroutine_);
             waiter.reset();
+            // Copying the executor allocates, and so does wrapping a handler that doesn't fit std::function's buffer.
+            counters_.allocation(1 + executor::detail::execute_allocations<decltype(exec), decltype(handler)>);
+            counters_.executor_post();
             executor::execute(std::move(exec), handler);
         }
-        void wakeup_waiters() {
-            std::vector<std::weak_ptr<waiter_t>> waiters = [&] {
-              std::scoped_lock lock{mut_};
-              return std::exchange(waiters_, std::vector<std::weak_ptr<waiter_t>>{});
-            }();
-            // Wakeup all waiters to "poll" on the Mutex. Let them race to attempt to lock it again
-            // Any unsuccessful lock-attempts will cause the waiters to be re-added to the list of
-            // active waiters.
-            for(auto weak_waiter: waiters) {
-                if(auto waiter = weak_waiter.lock()) {
-                    wakeup_waiter(std::move(waiter));
+
+        // Called with mut_ held by the owner of the lock. Gives the lock to the first waiter in the queue, or unlocks
+        // the Mutex if there is none. The returned waiter must be woken with `wakeup_waiter` once mut_ is released.
+        std::shared_ptr<waiter_t> hand_off() {
+            if(auto * waiter = waiters_.pop_front()) {
+                waiter->state_ = waiter_state::in_flight;
+                waiter->handed_off_ = true;
+                return waiter->shared_from_this();
+            }
+            locked_.store(false, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // Called with mut_ held while the lock is free. Wakes the first waiter to race for it, unless the policy is
+        // `Fair`, where a free lock means there is nobody to wake.
+        std::shared_ptr<waiter_t> wake_first() {
+            if constexpr(!fair) {
+                if(!locked_.load(std::memory_order_relaxed)) {
+                    if(auto * waiter = waiters_.pop_front()) {
+                        waiter->state_ = waiter_state::in_flight;
+                        return waiter->shared_from_this();
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        // Called with mut_ held when a woken waiter lost the lock to a barging task.
+        void starve(waiter_t & waiter) noexcept {
+            if constexpr(adaptive) {
+                if(!waiter.starving_ && timer::clock::now() - waiter.queued_since_ >= Policy::starvation_threshold) {
+                    waiter.starving_ = true;
+                    starving_waiters_++;
+                }
+            }
+        }
+
+        // Called with mut_ held when a waiter leaves for good.
+        void unstarve(waiter_t & waiter) noexcept {
+            if(waiter.starving_) {
+                waiter.starving_ = false;
+                starving_waiters_--;
+            }
+        }
+
+        void release() {
+            std::shared_ptr<waiter_t> next;
+            {
+                std::scoped_lock lock(mut_);
+                lock_counters_.released(hold_timer_.elapsed_ns());
+                if(max_spin_ != timer::clock::duration::zero()) {
+                    // Roughly the average of the last 8 hold times.
+                    auto average = average_hold_.load(std::memory_order_relaxed);
+                    auto held = (timer::clock::now() - acquired_at_).count();
+                    average_hold_.store(average + (held - average) / 8, std::memory_order_relaxed);
+                }
+                if(fair || starving_waiters_ > 0) {
+                    next = hand_off();
+                }
+                else {
+                    locked_.store(false, std::memory_order_relaxed);
+                    next = wake_first();
+                }
+            }
+            if(next) {
+                wakeup_waiter(std::move(next));
+            }
+        }
+
+        void cancel_waiter(waiter_t & waiter, LockError error) {
+            std::unique_lock lock(mut_);
+            switch(waiter.state_.load()) {
+            case waiter_state::idle:
+                // Not parked yet, await_suspend will notice the error and not suspend at all.
+                waiter.error_ = error;
+                break;
+            case waiter_state::queued:
+                waiters_.erase(waiter);
+                waiter.state_ = waiter_state::in_flight;
+                waiter.error_ = error;
+                lock.unlock();
+                wakeup_waiter(waiter.shared_from_this());
+                break;
+            case waiter_state::in_flight:
+                // A waiter that was handed the lock already owns it, any other is resumed with the error.
+                if(!waiter.handed_off_) {
+                    waiter.error_ = error;
+                }
+                break;
+            case waiter_state::done:
+            case waiter_state::abandoned:
+                break;
+            }
+        }
+
+        // Called when an awaitable is destroyed, removes the waiter from the queue right away.
+        void abandon_waiter(waiter_t & waiter) noexcept {
+            if(waiter.state_.load(std::memory_order_acquire) == waiter_state::done) {
+                return;
+            }
+            std::shared_ptr<waiter_t> next;
+            {
+                std::scoped_lock lock(mut_);
+                if(waiter.state_ == waiter_state::queued) {
+                    waiters_.erase(waiter);
+                }
+                else if(waiter.state_ == waiter_state::in_flight) {
+                    // The lock, or a wakeup to race for it, was given to this waiter but it will never use it.
+                    next = waiter.handed_off_ ? hand_off() : wake_first();
+                }
+                if(waiter.state_ != waiter_state::done) {
+                    unstarve(waiter);
+                    waiter.state_ = waiter_state::abandoned;
+                }
+            }
+            if(next) {
+                wakeup_waiter(std::move(next));
+            }
+        }
+
+        // Either takes the lock or parks the waiter. Returns true if the waiter was parked.
+        bool lock_or_park(waiter_t & waiter, std::coroutine_handle<> to_suspend) {
+            std::scoped_lock lock(mut_);
+            waiter.coroutine_ = to_suspend;
+            if(waiter.error_ || !locked_.load(std::memory_order_relaxed)) {
+                if(!waiter.error_) {
+                    locked_.store(true, std::memory_order_relaxed);
+                    acquired();
                 }
+                waiter.state_ = waiter_state::done;
+                return false;
+            }
+            waiter.wait_timer_.start();
+            if constexpr(adaptive) {
+                waiter.queued_since_ = timer::clock::now();
+            }
+            enqueue(waiter);
+            return true;
+        }
+
+        bool try_lock_impl() noexcept {
+            std::scoped_lock lock(mut_);
+            if(!locked_.load(std::memory_order_relaxed)) {
+                locked_.store(true, std::memory_order_relaxed);
+                acquired();
+                return true;
             }
+            return false;
+        }
+
+        // Like try_lock_impl, but spins for a while first if the lock is usually released soon enough. Parking costs an
+        // allocation and a round trip through the executor, more than waiting out a short critical section.
+        bool try_lock_spinning() noexcept {
+            if(try_lock_impl()) {
+                return true;
+            }
+            auto average = timer::clock::duration(average_hold_.load(std::memory_order_relaxed));
+            if(max_spin_ == timer::clock::duration::zero() || average > max_spin_) {
+                return false;
+            }
+            // Twice the average hold time covers most critical sections without burning the whole budget on long ones.
+            auto deadline = timer::clock::now() + std::min(max_spin_, 2 * average + std::chrono::microseconds(1));
+            do {
+                for(int i = 0; i < 16 && locked_.load(std::memory_order_relaxed); i++) {
+                    colite::detail::cpu_relax();
+                }
+                if(!locked_.load(std::memory_order_relaxed) && try_lock_impl()) {
+                    lock_counters_.spun();
+                    return true;
+                }
+            } while(timer::clock::now() < deadline);
+            return false;
+        }
+
+        template<class Exec>
+        auto lock_impl(Exec exec, std::stop_token token, timer::TimerService * timers, timer::clock::time_point deadline, int priority) {
+            struct awaitable {
+                std::shared_ptr<waiter_t> waiter_;
+                std::stop_token token_;
+                timer::TimerService * timers_;
+                timer::clock::time_point deadline_;
+                std::shared_ptr<timeout_node> timeout_{};
+                std::optional<std::stop_callback<stop_fn>> stop_callback_{};
+
+                ~awaitable() {
+                    stop_callback_.reset();
+                    if(timeout_) {
+                        timers_->cancel(*timeout_);
+                    }
+                    if(waiter_) {
+                        waiter_->mutex_->abandon_waiter(*waiter_);
+                    }
+                }
+
+                static bool await_ready() noexcept {
+                    return false;
+                }
+
+                bool await_suspend(std::coroutine_handle<> to_suspend) {
+                    auto & waiter = *waiter_;
+                    if(waiter.mutex_->try_lock_spinning()) {
+                        waiter.state_ = waiter_state::done;
+                        return false;
+                    }
+                    // Register the cancellation sources before the waiter is visible to other threads.
+                    // If one of them triggers right away the waiter is marked with an error and never parked.
+                    if(token_.stop_possible()) {
+                        stop_callback_.emplace(token_, stop_fn{&waiter});
+                    }
+                    if(timers_) {
+                        waiter.mutex_->counters_.allocation();
+                        timeout_ = std::make_shared<timeout_node>(waiter_);
+                        timers_->schedule(timeout_, deadline_);
+                    }
+                    return waiter.mutex_->lock_or_park(waiter, to_suspend);
+                }
+
+                colite::Expected<MutexGuard<T, Policy>, LockError> await_resume() {
+                    if(waiter_->error_) {
+                        return colite::Unexpected(*waiter_->error_);
+                    }
+                    return MutexGuard<T, Policy>(*waiter_->mutex_);
+                }
+            };
+
+            // The waiter, and its executor unless that is an AnyExecutor already.
+            counters_.allocation(1 + executor::detail::any_executor_allocations<Exec>);
+            return awaitable{std::make_shared<waiter_t>(this, std::move(exec), priority), std::move(token), timers, deadline};
         }
     public:
         explicit Mutex(T value): value_(std::move(value)) {}
 
+        /**
+         * @brief Create a Mutex that spins for up to `max_spin` before parking a waiter.
+         * @param value The initial value.
+         * @param max_spin Upper bound for the spin phase of `lock`, zero disables spinning.
+         *
+         * Parking a waiter allocates it and later resumes it through its executor. When the Mutex is only held for
+         * short critical sections by tasks on other threads it is cheaper to spin until it is released. The spin limit
+         * adapts to a moving average of recent hold times: `lock` spins for about twice the average and does not spin
+         * at all while the average exceeds `max_spin`. Spinning blocks the calling thread, so only use it when the
+         * Mutex is shared between executors running on different threads.
+         */
+        Mutex(T value, std::chrono::nanoseconds max_spin): value_(std::move(value)), max_spin_(std::chrono::duration_cast<timer::clock::duration>(max_spin)) {}
+
         /**
          * @brief Attempt to lock the Mutex.
          * @return An optional MutexGuard.
          *
          * This attempts to lock the Mutex in a synchronous non-blocking manner.
          *
-         * Returns an empty optional if lock was unsuccessful, otherwise it holds a MutexGuard<T>.
+         * Returns an empty optional if lock was unsuccessful, otherwise it holds a MutexGuard.
          */
-        std::optional<MutexGuard<T>> try_lock() & noexcept {
-            std::scoped_lock lock(mut_);
-            if(!locked_) {
-                locked_ = true;
-                return MutexGuard<T>(*this);
+        std::optional<MutexGuard<T, Policy>> try_lock() & noexcept {
+            if(try_lock_impl()) {
+                return MutexGuard<T, Policy>(*this);
             }
             return std::nullopt;
         }
 
+        /**
+         * @brief Read the instrumentation counters of this Mutex.
+         * @return A snapshot of the counters, all zero unless `COLITE_INSTRUMENT` is defined.
+         */
+        [[nodiscard]] instrument::Snapshot instrumentation() const noexcept {
+            return counters_.snapshot();
+        }
+
+        /**
+         * @brief Read the contention statistics of this Mutex.
+         * @return A snapshot of the statistics, all zero unless `COLITE_INSTRUMENT` is defined.
+         *
+         * The statistics are kept in relaxed atomics, so this is cheap enough to poll from a metrics exporter.
+         * Wait times are measured from when a waiter is first queued until it holds the lock.
+         */
+        [[nodiscard]] instrument::LockStatistics statistics() const noexcept {
+            auto retval = lock_counters_.snapshot();
+            retval.spurious_wakeups = counters_.snapshot().spurious_wakeups;
+            return retval;
+        }
+
         /**
          * @brief Asynchronously lock the Mutex.
          * @param exec The Executor associated with the coroutine
@@ -165,65 +585,134 @@ namespace colite::sync
          * be used to read and modify the value associated with the Mutex.
          */
         auto lock(colite::executor::Executor auto exec) & {
+            return lock(std::move(exec), 0);
+        }
+
+        /**
+         * @brief Asynchronously lock the Mutex, ahead of waiters with a lower priority.
+         * @param exec The Executor associated with the coroutine
+         * @param priority Waiters with a higher priority are handed the Mutex first. `lock(exec)` uses priority 0.
+         * @return An awaitable object producing a `MutexGuard<T>`.
+         *
+         * Waiters with the same priority are handed the Mutex in the order they started waiting. Priorities only order
+         * the waiters, a waiter is never preempted once it holds the lock.
+         */
+        template<colite::executor::Executor Exec>
+        auto lock(Exec exec, int priority) & {
             struct awaitable {
+                Mutex * mutex_;
+                Exec exec_;
+                int priority_;
+                // Only allocated once the lock is found taken.
                 std::shared_ptr<waiter_t> waiter_;
-                static bool await_ready() noexcept {
-                    return false;
+
+                awaitable(Mutex * mutex, Exec exec, int priority): mutex_(mutex), exec_(std::move(exec)), priority_(priority) {}
+                awaitable(awaitable &&) noexcept = default;
+                ~awaitable() {
+                    if(waiter_) {
+                        mutex_->abandon_waiter(*waiter_);
+                    }
+                }
+
+                bool await_ready() noexcept {
+                    return mutex_->try_lock_spinning();
                 }
 
                 bool await_suspend(std::coroutine_handle<> to_suspend) {
-                    std::scoped_lock lock(waiter_->mutex_->mut_);
-                    waiter_->coroutine_ = to_suspend;
-                    if(!waiter_->mutex_->locked_) {
-                        waiter_->mutex_->locked_ = true;
-                        return false;
-                    }
-                    waiter_->mutex_->waiters_.push_back(waiter_);
-                    return true;
+                    // The waiter, and its executor unless that is an AnyExecutor already.
+                    mutex_->counters_.allocation(1 + executor::detail::any_executor_allocations<Exec>);
+                    waiter_ = std::make_shared<waiter_t>(mutex_, std::move(exec_), priority_);
+                    return mutex_->lock_or_park(*waiter_, to_suspend);
                 }
 
-                MutexGuard<T> await_resume() {
-                    return {*waiter_->mutex_};
+                MutexGuard<T, Policy> await_resume() {
+                    return {*mutex_};
                 }
             };
 
-            return awaitable{std::make_shared<waiter_t>(this, std::move(exec))};
+            return awaitable{this, std::move(exec), priority};
+        }
+
+        /**
+         * @brief Asynchronously lock the Mutex, giving up if `token` is stopped first.
+         * @param exec The Executor associated with the coroutine
+         * @param token Stop token used to cancel the lock attempt.
+         * @param priority Queues the waiter by priority like `lock(exec, priority)`.
+         * @return An `AWAITABLE<Expected<MutexGuard<T>, LockError>>`.
+         *
+         * A cancelled waiter is removed from the queue immediately and resumed on `exec` with `LockError::Cancelled`.
+         */
+        auto lock(colite::executor::Executor auto exec, std::stop_token token, int priority = 0) & {
+            return lock_impl(std::move(exec), std::move(token), nullptr, {}, priority);
+        }
+
+        /**
+         * @brief Asynchronously lock the Mutex, giving up once `deadline` has passed.
+         * @param timers The timer service that tracks the deadline.
+         * @param exec The Executor associated with the coroutine
+         * @param deadline The point in time to give up at.
+         * @param token Optional stop token used to cancel the lock attempt.
+         * @param priority Queues the waiter by priority like `lock(exec, priority)`.
+         * @return An `AWAITABLE<Expected<MutexGuard<T>, LockError>>`.
+         *
+         * If the deadline passes first the waiter is removed from the queue and resumed with `LockError::TimedOut`.
+         */
+        auto lock_until(timer::TimerService & timers, colite::executor::Executor auto exec, timer::clock::time_point deadline, std::stop_token token = {}, int priority = 0) & {
+            return lock_impl(std::move(exec), std::move(token), &timers, deadline, priority);
+        }
+
+        /**
+         * @brief Asynchronously lock the Mutex, giving up after `timeout`.
+         *
+         * See `lock_until`.
+         */
+        auto lock_for(timer::TimerService & timers, colite::executor::Executor auto exec, timer::clock::duration timeout, std::stop_token token = {}, int priority = 0) & {
+            return lock_until(timers, std::move(exec), timer::clock::now() + timeout, std::move(token), priority);
+        }
+
+        /**
+         * @brief `lock_until` using `TimerService::default_service()`.
+         */
+        auto lock_until(colite::executor::Executor auto exec, timer::clock::time_point deadline, std::stop_token token = {}, int priority = 0) & {
+            return lock_until(timer::TimerService::default_service(), std::move(exec), deadline, std::move(token), priority);
+        }
+
+        /**
+         * @brief `lock_for` using `TimerService::default_service()`.
+         */
+        auto lock_for(colite::executor::Executor auto exec, timer::clock::duration timeout, std::stop_token token = {}, int priority = 0) & {
+            return lock_for(timer::TimerService::default_service(), std::move(exec), timeout, std::move(token), priority);
         }
     };
 
-    template<class T>
-    MutexGuard<T>::~MutexGuard() {
+    template<class T, class Policy>
+    MutexGuard<T, Policy>::~MutexGuard() {
         unlock_impl();
     }
-    template<class T>
-    T &MutexGuard<T>::operator*() noexcept {
+    template<class T, class Policy>
+    T &MutexGuard<T, Policy>::operator*() noexcept {
         return mutex_->value_;
     }
-    template<class T>
-    const T &MutexGuard<T>::operator*() const noexcept {
+    template<class T, class Policy>
+    const T &MutexGuard<T, Policy>::operator*() const noexcept {
         return mutex_->value_;
     }
-    template<class T>
-    T *MutexGuard<T>::operator->() noexcept {
+    template<class T, class Policy>
+    T *MutexGuard<T, Policy>::operator->() noexcept {
         return &mutex_->value_;
     }
-    template<class T>
-    const T *MutexGuard<T>::operator->() const noexcept {
+    template<class T, class Policy>
+    const T *MutexGuard<T, Policy>::operator->() const noexcept {
         return &mutex_->value_;
     }
-    template<class T>
-    void MutexGuard<T>::unlock_impl() {
+    template<class T, class Policy>
+    void MutexGuard<T, Policy>::unlock_impl() {
         if(mutex_) {
-            {
-                std::scoped_lock lock(mutex_->mut_);
-                mutex_->locked_ = false;
-            }
-            mutex_->wakeup_waiters();
-            mutex_ = nullptr;
+            std::exchange(mutex_, nullptr)->release();
         }
     }
-    template<class T>
-    MutexGuard<T> &MutexGuard<T>::operator=(MutexGuard &&rhs) noexcept {
+    template<class T, class Policy>
+    MutexGuard<T, Policy> &MutexGuard<T, Policy>::operator=(MutexGuard &&rhs) noexcept {
         if(this != &rhs) {
             unlock_impl();
             mutex_ = std::exchange(rhs.mutex_, nullptr);
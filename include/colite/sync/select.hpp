@@ -0,0 +1,375 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Wait for the first of several channel receive operations to complete.
+ *
+ * `co_await colite::select(exec, rx1.receive_op(), rx2.receive_op(), ...)` suspends until any of the channels
+ * has data or is closed, and produces a `std::variant` where the active alternative tells which channel won.
+ * Alternative `I` holds the `Expected<T, ReceiveError>` of the `I`:th receive operation.
+ *
+ * Only the winning channel has a value removed, the other channels are left untouched.
+ *
+ * `select_until`/`select_for` also give up at a deadline and `select(exec, token, ...)` when a stop is requested. They
+ * produce an `Expected` holding the same `std::variant`, or `ReceiveError::TimedOut`/`ReceiveError::Cancelled` if no
+ * channel was ready in time. A select that gives up consumes nothing from any of its channels.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * auto result = co_await colite::select(exec, prices.receive_op(), orders.receive_op());
+ * if (result.index() == 0) {
+ *     auto price = std::get<0>(result); // colite::Expected<Price, colite::mpmc::ReceiveError>
+ * } else {
+ *     auto order = std::get<1>(result);
+ * }
+ * ```
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+#include <colite/executor/executor.hpp>
+#include <colite/sync/channel.hpp>
+#include <colite/timer/timer.hpp>
+
+namespace colite {
+
+    namespace detail {
+        enum class select_phase : std::uint8_t
+        {
+            arming,
+            parked,
+            cancelled,
+        };
+
+        struct select_shared_t {
+            std::atomic<bool> claimed_{false};
+            std::size_t winner_ = 0;
+            std::coroutine_handle<> waiting_coro_;
+            // Only used by selects with a deadline or stop token. Set by whoever claims the select to give up, see
+            // `cancel_select`.
+            std::optional<mpmc::ReceiveError> error_;
+            std::atomic<select_phase> phase_{select_phase::arming};
+        };
+
+        /**
+         * One arm of a select, registered as a waiting receiver on a single channel. All arms share
+         * one `select_shared_t` and only the first one to claim it gets to take a value.
+         */
+        template<class T>
+        struct select_arm_t final : mpmc::detail::waiting_receiver_t<T> {
+            std::shared_ptr<select_shared_t> shared_;
+            std::size_t index_;
+            // The channel the arm is parked on, its counters are updated when the arm gives up.
+            std::shared_ptr<mpmc::detail::state_t<T>> channel_;
+
+            select_arm_t(std::shared_ptr<select_shared_t> shared, std::size_t index, std::shared_ptr<mpmc::detail::state_t<T>> channel,
+                         colite::executor::AnyExecutor exec)
+                : mpmc::detail::waiting_receiver_t<T>(std::move(exec)), shared_(std::move(shared)), index_(index),
+                  channel_(std::move(channel)) {}
+
+            bool claim() noexcept override {
+                if (shared_->claimed_.exchange(true, std::memory_order_acq_rel)) {
+                    return false;
+                }
+                shared_->winner_ = index_;
+                return true;
+            }
+
+            void complete() override {
+                shared_->waiting_coro_.resume();
+            }
+        };
+
+        // Gives up on a select unless one of its channels already won. `arm` is the first arm, its executor resumes
+        // the select. A select that isn't parked yet notices the error itself before it suspends.
+        template<class T>
+        void cancel_select(select_arm_t<T> &arm, mpmc::ReceiveError error) {
+            auto &shared = *arm.shared_;
+            if (shared.claimed_.exchange(true, std::memory_order_acq_rel)) {
+                return;
+            }
+            shared.error_ = error;
+            if (shared.phase_.exchange(select_phase::cancelled, std::memory_order_acq_rel) != select_phase::parked) {
+                return;
+            }
+            std::weak_ptr<select_shared_t> weak_shared = arm.shared_;
+            auto resume = [weak_shared] {
+                // The lock fails if the select was destroyed while this was in flight.
+                if (auto shared = weak_shared.lock()) {
+                    shared->waiting_coro_.resume();
+                }
+            };
+            arm.channel_->counters_.allocation(colite::executor::detail::execute_allocations<decltype(arm.exec_), decltype(resume)>);
+            arm.channel_->counters_.executor_post();
+            colite::executor::execute(arm.exec_, std::move(resume));
+        }
+
+        template<class T>
+        struct select_stop_fn {
+            select_arm_t<T> *arm_;
+            void operator()() const {
+                cancel_select(*arm_, mpmc::ReceiveError::Cancelled);
+            }
+        };
+
+        template<class T>
+        struct select_timeout_node final : timer::detail::timer_node {
+            std::weak_ptr<select_arm_t<T>> arm_;
+            explicit select_timeout_node(std::weak_ptr<select_arm_t<T>> arm) : arm_(std::move(arm)) {}
+
+            void fire() override {
+                if (auto arm = arm_.lock()) {
+                    cancel_select(*arm, mpmc::ReceiveError::TimedOut);
+                }
+            }
+        };
+
+        // `Cancellable` selects give up at a deadline or when a stop is requested and produce an `Expected`.
+        template<class Exec, bool Cancellable, class... Ts>
+        struct select_awaitable {
+            using result_type = std::variant<colite::Expected<Ts, mpmc::ReceiveError>...>;
+            using first_t = std::tuple_element_t<0, std::tuple<Ts...>>;
+
+            std::tuple<mpmc::ReceiveOp<Ts>...> ops_;
+            std::shared_ptr<select_shared_t> shared_;
+            std::tuple<std::shared_ptr<select_arm_t<Ts>>...> arms_;
+            std::stop_token token_;
+            timer::TimerService *timers_ = nullptr;
+            timer::clock::time_point deadline_{};
+            std::shared_ptr<select_timeout_node<first_t>> timeout_;
+            std::optional<std::stop_callback<select_stop_fn<first_t>>> stop_callback_;
+
+            select_awaitable(Exec exec, mpmc::ReceiveOp<Ts>... ops)
+                : ops_(std::move(ops)...), shared_(std::make_shared<select_shared_t>()),
+                  arms_(make_arms(exec, std::index_sequence_for<Ts...>{})) {
+            }
+
+            select_awaitable(Exec exec, std::stop_token token, timer::TimerService *timers, timer::clock::time_point deadline, mpmc::ReceiveOp<Ts>... ops)
+                : select_awaitable(std::move(exec), std::move(ops)...) {
+                token_ = std::move(token);
+                timers_ = timers;
+                deadline_ = deadline;
+            }
+
+            ~select_awaitable() {
+                stop_callback_.reset();
+                if (timeout_) {
+                    timers_->cancel(*timeout_);
+                }
+                deregister(std::index_sequence_for<Ts...>{});
+            }
+
+            static constexpr bool await_ready() noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> to_suspend) {
+                // Holding all channel locks at once makes the check-then-park below atomic with respect to
+                // senders, so no arm can be woken until all arms are registered.
+                auto locks = std::apply([](auto &...ops) {
+                    return std::tuple{std::unique_lock{ops.state_->mutex_, std::defer_lock}...};
+                }, ops_);
+                if constexpr (sizeof...(Ts) == 1) {
+                    std::get<0>(locks).lock();
+                } else {
+                    std::apply([](auto &...lock) { std::lock(lock...); }, locks);
+                }
+                if (try_complete_now(locks, std::index_sequence_for<Ts...>{})) {
+                    std::apply([](auto &...lock) { (lock.unlock(), ...); }, locks);
+                    after_pop(std::index_sequence_for<Ts...>{});
+                    return false;
+                }
+                shared_->waiting_coro_ = to_suspend;
+                std::apply([&](auto &...arms) { ((arms->waiting_coro_ = to_suspend), ...); }, arms_);
+                if constexpr (Cancellable) {
+                    // Registered only now so that a select that is ready right away never times out. The cancellation
+                    // sources don't take the channel locks, and may fire right here on this thread.
+                    auto &first_arm = std::get<0>(arms_);
+                    if (token_.stop_possible()) {
+                        stop_callback_.emplace(token_, select_stop_fn<first_t>{first_arm.get()});
+                    }
+                    if (timers_) {
+                        std::get<0>(ops_).state_->counters_.allocation();
+                        timeout_ = std::make_shared<select_timeout_node<first_t>>(first_arm);
+                        timers_->schedule(timeout_, deadline_);
+                    }
+                }
+                park(locks, std::index_sequence_for<Ts...>{});
+                if constexpr (Cancellable) {
+                    if (shared_->phase_.exchange(select_phase::parked, std::memory_order_acq_rel) == select_phase::cancelled) {
+                        // Gave up before it was parked, nobody is going to resume it.
+                        unpark(locks, std::index_sequence_for<Ts...>{});
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            auto await_resume() {
+                // Remove the losing arms right away instead of waiting for the awaitable to be destroyed.
+                deregister(std::index_sequence_for<Ts...>{});
+                if constexpr (Cancellable) {
+                    using expected_type = colite::Expected<result_type, mpmc::ReceiveError>;
+                    if (shared_->error_) {
+                        return expected_type(colite::Unexpected(*shared_->error_));
+                    }
+                    return expected_type(take_result(std::index_sequence_for<Ts...>{}));
+                } else {
+                    return take_result(std::index_sequence_for<Ts...>{});
+                }
+            }
+
+        private:
+            template<std::size_t... Is>
+            std::tuple<std::shared_ptr<select_arm_t<Ts>>...> make_arms(const Exec &exec, std::index_sequence<Is...>) {
+                // Each arm and its copy of the executor count towards the channel it is parked on, the shared state
+                // towards the first one.
+                std::get<0>(ops_).state_->counters_.allocation();
+                (std::get<Is>(ops_).state_->counters_.allocation(1 + colite::executor::detail::any_executor_allocations<const Exec &>), ...);
+                return {std::make_shared<select_arm_t<Ts>>(shared_, Is, std::get<Is>(ops_).state_, colite::executor::AnyExecutor(exec))...};
+            }
+
+            template<std::size_t I, class Locks>
+            bool try_complete_arm(const Locks &locks) {
+                auto value = std::get<I>(ops_).state_->take_value(std::get<I>(locks));
+                if (!value.has_value() && value.error() == mpmc::TryReceiveError::Empty) {
+                    return false;
+                }
+                auto &arm = *std::get<I>(arms_);
+                if (value.has_value()) {
+                    arm.value_ = std::move(*value);
+                }
+                arm.state_ = mpmc::detail::waiter_state::done;
+                shared_->claimed_.store(true, std::memory_order_relaxed);
+                shared_->winner_ = I;
+                return true;
+            }
+
+            template<class Locks, std::size_t... Is>
+            bool try_complete_now(const Locks &locks, std::index_sequence<Is...>) {
+                return (try_complete_arm<Is>(locks) || ...);
+            }
+
+            // Lets drains of the winning channel know if it was emptied.
+            template<std::size_t... Is>
+            void after_pop(std::index_sequence<Is...>) {
+                ((Is == shared_->winner_ ? mpmc::detail::after_pop(std::get<Is>(ops_).state_) : void()), ...);
+            }
+
+            template<class Locks, std::size_t... Is>
+            void park(const Locks &locks, std::index_sequence<Is...>) {
+                (std::get<Is>(ops_).state_->park(std::get<Is>(locks), *std::get<Is>(arms_)), ...);
+            }
+
+            template<class Locks, std::size_t... Is>
+            void unpark(const Locks &locks, std::index_sequence<Is...>) {
+                ((std::get<Is>(ops_).state_->unpark(std::get<Is>(locks), *std::get<Is>(arms_)),
+                  std::get<Is>(arms_)->state_ = mpmc::detail::waiter_state::done), ...);
+            }
+
+            template<std::size_t... Is>
+            void deregister(std::index_sequence<Is...>) {
+                // Unlinking is O(1) per channel, and a no-op for arms that are already done.
+                (std::get<Is>(ops_).state_->abandon(*std::get<Is>(arms_)), ...);
+            }
+
+            template<std::size_t I>
+            result_type take_result_at() {
+                auto &value = std::get<I>(arms_)->value_;
+                if (value.has_value()) {
+                    return result_type(std::in_place_index<I>, std::move(*value));
+                }
+                return result_type(std::in_place_index<I>, colite::Unexpected(mpmc::ReceiveError::Closed));
+            }
+
+            template<std::size_t... Is>
+            result_type take_result(std::index_sequence<Is...>) {
+                using take_fn = result_type (select_awaitable::*)();
+                static constexpr take_fn table[] = {&select_awaitable::take_result_at<Is>...};
+                return (this->*table[shared_->winner_])();
+            }
+        };
+    }// namespace detail
+
+    /**
+     * @brief Asynchronously receive from whichever channel first has data or is closed.
+     * @param exec The Executor to resume on
+     * @param ops The receive operations, created with `Receiver::receive_op()`.
+     * @return An `AWAITABLE<std::variant<Expected<Ts, mpmc::ReceiveError>...>>`.
+     *
+     * If several channels are ready when the awaitable is first awaited the one that comes first in the argument
+     * list wins. Each channel may only appear once.
+     */
+    template<colite::executor::Executor Exec, class... Ts>
+    [[nodiscard]] auto select(Exec exec, mpmc::ReceiveOp<Ts>... ops) {
+        static_assert(sizeof...(Ts) > 0, "select needs at least one receive operation");
+        return detail::select_awaitable<Exec, false, Ts...>(std::move(exec), std::move(ops)...);
+    }
+
+    /**
+     * @brief `select`, giving up if `token` is stopped first.
+     * @param exec The Executor to resume on
+     * @param token Stop token used to cancel the select.
+     * @param ops The receive operations, created with `Receiver::receive_op()`.
+     * @return An `AWAITABLE<Expected<std::variant<Expected<Ts, mpmc::ReceiveError>...>, mpmc::ReceiveError>>`.
+     *
+     * A cancelled select is removed from all channels and resumed on `exec` with `ReceiveError::Cancelled`, without
+     * consuming anything.
+     */
+    template<colite::executor::Executor Exec, class... Ts>
+    [[nodiscard]] auto select(Exec exec, std::stop_token token, mpmc::ReceiveOp<Ts>... ops) {
+        static_assert(sizeof...(Ts) > 0, "select needs at least one receive operation");
+        return detail::select_awaitable<Exec, true, Ts...>(std::move(exec), std::move(token), nullptr, {}, std::move(ops)...);
+    }
+
+    /**
+     * @brief `select`, giving up once `deadline` has passed.
+     * @param timers The timer service that tracks the deadline.
+     * @param exec The Executor to resume on
+     * @param deadline The point in time to give up at.
+     * @param ops The receive operations, created with `Receiver::receive_op()`.
+     * @return An `AWAITABLE<Expected<std::variant<Expected<Ts, mpmc::ReceiveError>...>, mpmc::ReceiveError>>`.
+     *
+     * If the deadline passes first the select is removed from all channels and resumed on `exec` with
+     * `ReceiveError::TimedOut`, without consuming anything.
+     */
+    template<colite::executor::Executor Exec, class... Ts>
+    [[nodiscard]] auto select_until(timer::TimerService &timers, Exec exec, timer::clock::time_point deadline, mpmc::ReceiveOp<Ts>... ops) {
+        static_assert(sizeof...(Ts) > 0, "select needs at least one receive operation");
+        return detail::select_awaitable<Exec, true, Ts...>(std::move(exec), std::stop_token{}, &timers, deadline, std::move(ops)...);
+    }
+
+    /**
+     * @brief `select`, giving up after `timeout`. See `select_until`.
+     */
+    template<colite::executor::Executor Exec, class... Ts>
+    [[nodiscard]] auto select_for(timer::TimerService &timers, Exec exec, timer::clock::duration timeout, mpmc::ReceiveOp<Ts>... ops) {
+        return select_until(timers, std::move(exec), timer::clock::now() + timeout, std::move(ops)...);
+    }
+
+    /**
+     * @brief `select_until` using `TimerService::default_service()`.
+     */
+    template<colite::executor::Executor Exec, class... Ts>
+    [[nodiscard]] auto select_until(Exec exec, timer::clock::time_point deadline, mpmc::ReceiveOp<Ts>... ops) {
+        return select_until(timer::TimerService::default_service(), std::move(exec), deadline, std::move(ops)...);
+    }
+
+    /**
+     * @brief `select_for` using `TimerService::default_service()`.
+     */
+    template<colite::executor::Executor Exec, class... Ts>
+    [[nodiscard]] auto select_for(Exec exec, timer::clock::duration timeout, mpmc::ReceiveOp<Ts>... ops) {
+        return select_for(timer::TimerService::default_service(), std::move(exec), timeout, std::move(ops)...);
+    }
+}// namespace colite
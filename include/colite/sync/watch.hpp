@@ -0,0 +1,416 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Contains data and functions to create a watch channel that only keeps the latest value
+ *
+ * A watch channel holds a single value. Sending overwrites that value and bumps a version number, receivers
+ * wait for the version to change with `co_await receiver.changed(exec)` and then read the current value with
+ * `receiver.borrow()`. Intermediate values that no receiver had time to look at are simply lost, which makes
+ * the channel a good fit for distributing configuration or metrics where only the newest value matters.
+ *
+ * Trivially copyable values are stored in a sequence lock, so reading them never blocks the sender. Other values
+ * are protected by a reader/writer lock that is held for as long as the borrow is alive.
+ *
+ * The channel is closed for receivers once all senders are destroyed. `send` reports `Closed` when no receivers
+ * are alive, but the value is still stored and will be seen by receivers created later with `Sender::subscribe`.
+ */
+
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <vector>
+
+#include <colite/executor/executor.hpp>
+#include <colite/expected.hpp>
+#include <colite/trace/trace.hpp>
+
+namespace colite::watch {
+
+    enum class ReceiveError : std::uint8_t
+    {
+        Closed
+    };
+
+    enum class SendError : std::uint8_t
+    {
+        Closed
+    };
+
+    template<class T>
+    struct Channel;
+
+    template<class T>
+    class Receiver;
+
+    namespace detail {
+        template<class T>
+        inline constexpr bool use_seqlock = std::is_trivially_copyable_v<T>;
+
+        /**
+         * Storage for trivially copyable values. Writers are serialized by the channel mutex and readers retry
+         * until they have copied the value without a write happening at the same time.
+         */
+        template<class T>
+        struct seqlock_value_t {
+            std::atomic<std::uint64_t> sequence_{0};
+            T value_;
+
+            explicit seqlock_value_t(T value) : value_(std::move(value)) {}
+
+            std::uint64_t version() const noexcept {
+                return sequence_.load(std::memory_order_acquire) / 2;
+            }
+
+            void store(const T &value) noexcept {
+                auto sequence = sequence_.load(std::memory_order_relaxed);
+                sequence_.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                std::memcpy(static_cast<void *>(&value_), &value, sizeof(T));
+                sequence_.store(sequence + 2, std::memory_order_release);
+            }
+
+            T load() const noexcept {
+                alignas(T) unsigned char buffer[sizeof(T)];
+                for (;;) {
+                    auto before = sequence_.load(std::memory_order_acquire);
+                    if (before & 1) {
+                        continue;
+                    }
+                    std::memcpy(buffer, static_cast<const void *>(&value_), sizeof(T));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence_.load(std::memory_order_relaxed) == before) {
+                        break;
+                    }
+                }
+                return std::bit_cast<T>(buffer);
+            }
+        };
+
+        template<class T>
+        struct locked_value_t {
+            mutable std::shared_mutex mutex_;
+            std::atomic<std::uint64_t> version_{0};
+            T value_;
+
+            explicit locked_value_t(T value) : value_(std::move(value)) {}
+
+            std::uint64_t version() const noexcept {
+                return version_.load(std::memory_order_acquire);
+            }
+
+            void store(T value) {
+                std::unique_lock lock{mutex_};
+                value_ = std::move(value);
+                version_.fetch_add(1, std::memory_order_release);
+            }
+        };
+
+        template<class T>
+        using value_storage_t = std::conditional_t<use_seqlock<T>, seqlock_value_t<T>, locked_value_t<T>>;
+
+        struct no_lock_t {};
+
+        struct waiting_receiver_t {
+            std::coroutine_handle<> waiting_coro_;
+            // A copy of the receiver's seen version, updated by the wakeup handler and copied back when the wait resumes.
+            // The handler runs on the receiver's executor and must not touch the `Receiver` itself.
+            std::uint64_t seen_version_ = 0;
+            bool closed_ = false;
+            colite::executor::AnyExecutor exec_{colite::executor::ImmediateExecutor{}};
+        };
+
+        template<class T>
+        struct state_t {
+            std::mutex mutex_;
+            value_storage_t<T> value_;
+            std::vector<std::weak_ptr<waiting_receiver_t>> waiting_receivers_;
+
+            std::weak_ptr<void> sender_ticket_;
+            std::weak_ptr<void> receiver_ticket_;
+
+            explicit state_t(T value) : value_(std::move(value)) {}
+
+            // Returns true if the receiver has something to observe, either a new version or a closed channel.
+            bool poll(const std::unique_lock<std::mutex> &, waiting_receiver_t &receiver) {
+                auto version = value_.version();
+                if (version != receiver.seen_version_) {
+                    receiver.seen_version_ = version;
+                    return true;
+                }
+                if (sender_ticket_.expired()) {
+                    receiver.closed_ = true;
+                    return true;
+                }
+                return false;
+            }
+        };
+
+        template<class T>
+        void wakeup_waiting_receivers(const std::shared_ptr<state_t<T>> &state, std::vector<std::weak_ptr<waiting_receiver_t>> waiting_receivers) {
+            for (auto weak_receiver : waiting_receivers) {
+                if (auto receiver = weak_receiver.lock()) {
+                    auto exec = receiver->exec_;
+
+                    auto handler = [weak_receiver, state] {
+                        if (auto receiver = weak_receiver.lock()) {
+                            std::unique_lock lock{state->mutex_};
+                            if (!state->poll(lock, *receiver)) {
+                                state->waiting_receivers_.push_back(receiver);
+                                trace::emit(trace::Phase::Suspend, "watch", state.get(), receiver->waiting_coro_);
+                                return;
+                            }
+                            lock.unlock();
+                            trace::emit(trace::Phase::Resume, "watch", state.get(), receiver->waiting_coro_);
+                            receiver->waiting_coro_.resume();
+                        }
+                    };
+                    trace::emit(trace::Phase::Schedule, "watch", state.get(), receiver->waiting_coro_);
+                    receiver.reset();
+                    colite::executor::execute(exec, std::move(handler));
+                }
+            }
+        }
+    }// namespace detail
+
+    /**
+     * @brief A read-only view of the current value of a watch channel.
+     * @tparam T The value type of the channel.
+     *
+     * For trivially copyable types this holds a consistent snapshot of the value. For other types it holds a
+     * shared lock on the value, which blocks senders until the `Ref` is destroyed, so it should be kept short-lived.
+     */
+    template<class T>
+    class Ref {
+        template<class>
+        friend class Receiver;
+
+        using storage_t = std::conditional_t<detail::use_seqlock<T>, T, const T *>;
+
+        [[no_unique_address]] std::conditional_t<detail::use_seqlock<T>, detail::no_lock_t, std::shared_lock<std::shared_mutex>> lock_;
+        storage_t value_;
+
+        Ref(storage_t value) requires detail::use_seqlock<T> : lock_(), value_(value) {}
+        Ref(std::shared_lock<std::shared_mutex> lock, const T *value) requires (!detail::use_seqlock<T>)
+            : lock_(std::move(lock)), value_(value) {}
+
+    public:
+        const T &operator*() const noexcept {
+            if constexpr (detail::use_seqlock<T>) {
+                return value_;
+            } else {
+                return *value_;
+            }
+        }
+
+        const T *operator->() const noexcept {
+            return &**this;
+        }
+    };
+
+    template<class T>
+    class Sender {
+        using state_t = detail::state_t<T>;
+
+        template<class U>
+        friend Channel<U> channel(U);
+
+        std::shared_ptr<state_t> state_;
+        std::shared_ptr<void> ticket_;
+
+        Sender(std::shared_ptr<state_t> state, std::shared_ptr<void> ticket) noexcept
+            : state_(std::move(state)), ticket_(std::move(ticket)) {
+        }
+
+    public:
+        Sender(const Sender &) = default;
+        Sender(Sender &&) noexcept = default;
+        ~Sender() {
+            if (state_) {
+                std::unique_lock lock(state_->mutex_);
+                if (ticket_.use_count() == 1) {
+                    ticket_.reset();
+                    auto waiting_receivers = std::exchange(state_->waiting_receivers_, {});
+                    lock.unlock();
+                    detail::wakeup_waiting_receivers(state_, std::move(waiting_receivers));
+                }
+            }
+        }
+
+        Sender &operator=(const Sender &) = default;
+        Sender &operator=(Sender &&) noexcept = default;
+
+        /**
+         * @brief Replace the value held by the channel and notify all receivers.
+         * @param value The new value.
+         * @return `SendError::Closed` if there are no receivers. The value is stored even in that case.
+         */
+        colite::Expected<void, SendError> send(T value) {
+            std::unique_lock lock{state_->mutex_};
+            state_->value_.store(std::move(value));
+            auto has_receivers = !state_->receiver_ticket_.expired();
+            auto waiting_receivers = std::exchange(state_->waiting_receivers_, {});
+            lock.unlock();
+            detail::wakeup_waiting_receivers(state_, std::move(waiting_receivers));
+            if (!has_receivers) {
+                return colite::Unexpected(SendError::Closed);
+            }
+            return {};
+        }
+
+        /**
+         * @brief Create a new receiver that considers the current value as already seen.
+         */
+        [[nodiscard]] Receiver<T> subscribe() {
+            std::scoped_lock lock{state_->mutex_};
+            auto ticket = state_->receiver_ticket_.lock();
+            if (!ticket) {
+                ticket = std::make_shared<char>(0);
+                state_->receiver_ticket_ = ticket;
+            }
+            return Receiver<T>(state_, std::move(ticket), state_->value_.version());
+        }
+    };
+
+    template<class T>
+    class Receiver {
+        using state_t = detail::state_t<T>;
+        using waiting_receiver_t = detail::waiting_receiver_t;
+
+        template<class U>
+        friend Channel<U> channel(U);
+        template<class U>
+        friend class Sender;
+
+        std::shared_ptr<state_t> state_;
+        std::shared_ptr<void> ticket_;
+        std::uint64_t seen_version_;
+
+        Receiver(std::shared_ptr<state_t> state, std::shared_ptr<void> ticket, std::uint64_t seen_version) noexcept
+            : state_(std::move(state)), ticket_(std::move(ticket)), seen_version_(seen_version) {
+        }
+
+    public:
+        /**
+         * @brief Check if the value has changed since it was last marked as seen.
+         *
+         * @note This is a snapshot in time, it may not be accurate when used later.
+         */
+        [[nodiscard]] bool has_changed() const noexcept {
+            return state_->value_.version() != seen_version_;
+        }
+
+        /**
+         * @brief Asynchronously wait for the value to change.
+         * @param exec The Executor to resume on
+         * @return An `AWAITABLE<Expected<void, ReceiveError>>`.
+         *
+         * Completes immediately if the value has changed since it was last seen, otherwise waits for the next send.
+         * The current value is marked as seen when the awaitable completes. `ReceiveError::Closed` is returned
+         * if all senders are destroyed and there is no unseen value.
+         *
+         * The receiver must outlive the returned awaitable.
+         */
+        [[nodiscard]] auto changed(colite::executor::Executor auto exec) {
+            struct awaitable {
+                std::shared_ptr<state_t> state_;
+                std::shared_ptr<waiting_receiver_t> waiting_receiver_;
+                std::uint64_t *seen_version_;
+
+                static constexpr bool await_ready() noexcept {
+                    return false;
+                }
+
+                bool await_suspend(std::coroutine_handle<> to_suspend) {
+                    std::unique_lock lock{state_->mutex_};
+                    waiting_receiver_->seen_version_ = *seen_version_;
+                    if (state_->poll(lock, *waiting_receiver_)) {
+                        return false;
+                    }
+                    waiting_receiver_->waiting_coro_ = to_suspend;
+                    state_->waiting_receivers_.push_back(waiting_receiver_);
+                    trace::emit(trace::Phase::Suspend, "watch", state_.get(), to_suspend);
+                    return true;
+                }
+
+                colite::Expected<void, ReceiveError> await_resume() const noexcept {
+                    *seen_version_ = waiting_receiver_->seen_version_;
+                    if (waiting_receiver_->closed_) {
+                        return colite::Unexpected(ReceiveError::Closed);
+                    }
+                    return {};
+                }
+            };
+            auto waiting_receiver = std::make_shared<waiting_receiver_t>();
+            waiting_receiver->exec_ = std::move(exec);
+            return awaitable{state_, std::move(waiting_receiver), &seen_version_};
+        }
+
+        /**
+         * @brief Borrow the current value without marking it as seen.
+         */
+        [[nodiscard]] Ref<T> borrow() const {
+            if constexpr (detail::use_seqlock<T>) {
+                return Ref<T>(state_->value_.load());
+            } else {
+                std::shared_lock lock{state_->value_.mutex_};
+                return Ref<T>(std::move(lock), &state_->value_.value_);
+            }
+        }
+
+        /**
+         * @brief Borrow the current value and mark it as seen.
+         */
+        [[nodiscard]] Ref<T> borrow_and_update() {
+            if constexpr (detail::use_seqlock<T>) {
+                auto &value = state_->value_;
+                for (;;) {
+                    auto version = value.version();
+                    auto retval = value.load();
+                    if (value.version() == version) {
+                        seen_version_ = version;
+                        return Ref<T>(retval);
+                    }
+                }
+            } else {
+                std::shared_lock lock{state_->value_.mutex_};
+                seen_version_ = state_->value_.version();
+                return Ref<T>(std::move(lock), &state_->value_.value_);
+            }
+        }
+    };
+
+    /**
+     * @brief Return-type for `channel<T>(initial)`.
+     * @tparam T The type transported inside the channel.
+     */
+    template<class T>
+    struct Channel {
+        Sender<T> sender;
+        Receiver<T> receiver;
+    };
+
+    /**
+     * @brief Create a new watch channel
+     * @tparam T The type transported with the channel
+     * @param initial The initial value of the channel, it is considered as already seen by the first receiver.
+     * @return The sender and receiver of the new channel.
+     */
+    template<class T>
+    Channel<T> channel(T initial) {
+        auto state = std::make_shared<detail::state_t<T>>(std::move(initial));
+        auto sender_ticket = std::make_shared<char>(0);
+        auto receiver_ticket = std::make_shared<char>(0);
+        state->sender_ticket_ = sender_ticket;
+        state->receiver_ticket_ = receiver_ticket;
+        Sender<T> sender(state, std::move(sender_ticket));
+        Receiver<T> receiver(std::move(state), std::move(receiver_ticket), 0);
+        return Channel<T>{std::move(sender), std::move(receiver)};
+    }
+}// namespace colite::watch
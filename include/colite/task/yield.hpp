@@ -8,6 +8,7 @@
 #include <coroutine>
 
 #include <colite/executor/executor.hpp>
+#include <colite/trace/trace.hpp>
 
 namespace colite::task
 {
@@ -30,8 +31,11 @@ namespace colite::task
 
             void await_suspend(std::coroutine_handle<> to_suspend) {
                 std::weak_ptr<void> weak_alive_check_ = alive_check_;
+                trace::emit(trace::Phase::Suspend, "yield", nullptr, to_suspend);
+                trace::emit(trace::Phase::Schedule, "yield", nullptr, to_suspend);
                 colite::executor::execute(exec_, [to_suspend, weak_alive_check_] {
                     if(auto alive = weak_alive_check_.lock()) {
+                        trace::emit(trace::Phase::Resume, "yield", nullptr, to_suspend);
                         to_suspend.resume();
                     }
                 });
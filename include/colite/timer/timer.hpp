@@ -0,0 +1,449 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Timer service and sleep awaitables.
+ *
+ * `TimerService` keeps pending timers in a hierarchical timing wheel. Scheduling and cancelling a timer
+ * are both O(1), and advancing time only touches the timers that expire or move down a level.
+ *
+ * A `TimerService` is either driven manually, by calling `advance(now)` or `poll()` from an existing run-loop,
+ * or by a dedicated thread started with `start()`.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * task my_task(colite::timer::TimerService& timers) {
+ *     co_await colite::timer::sleep_for(timers, my_exec, std::chrono::milliseconds(100));
+ *     // Resumed on my_exec roughly 100 ms later.
+ *
+ *     // Uses the process-wide service running on its own thread.
+ *     co_await colite::timer::sleep_for(my_exec, std::chrono::seconds(1));
+ * }
+ * ```
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <colite/executor/executor.hpp>
+#include <colite/trace/trace.hpp>
+
+namespace colite::timer {
+    using clock = std::chrono::steady_clock;
+
+    class TimerService;
+
+    namespace detail {
+        struct timer_list;
+
+        /**
+         * Base for anything that can be scheduled on a `TimerService`. The node is linked into
+         * the wheel intrusively, so scheduling and cancelling never allocate.
+         */
+        struct timer_node : std::enable_shared_from_this<timer_node> {
+            timer_node *prev_ = nullptr;
+            timer_node *next_ = nullptr;
+            timer_list *list_ = nullptr;
+            std::uint64_t expiry_tick_ = 0;
+
+            virtual ~timer_node() = default;
+
+            // Called without the service lock held once the timer has expired.
+            virtual void fire() = 0;
+        };
+
+        struct timer_list {
+            timer_node *head_ = nullptr;
+            timer_node *tail_ = nullptr;
+
+            void push_back(timer_node *node) noexcept {
+                node->prev_ = tail_;
+                node->next_ = nullptr;
+                if (tail_) {
+                    tail_->next_ = node;
+                } else {
+                    head_ = node;
+                }
+                tail_ = node;
+                node->list_ = this;
+            }
+
+            void erase(timer_node *node) noexcept {
+                if (node->prev_) {
+                    node->prev_->next_ = node->next_;
+                } else {
+                    head_ = node->next_;
+                }
+                if (node->next_) {
+                    node->next_->prev_ = node->prev_;
+                } else {
+                    tail_ = node->prev_;
+                }
+                node->prev_ = node->next_ = nullptr;
+                node->list_ = nullptr;
+            }
+
+            timer_list take() noexcept {
+                return {std::exchange(head_, nullptr), std::exchange(tail_, nullptr)};
+            }
+        };
+    }// namespace detail
+
+    /**
+     * @brief A hierarchical timing wheel.
+     *
+     * Time is divided into ticks of `resolution` length. The wheel has `levels` levels of `slots` slots, where a
+     * slot on level `n` covers `slots^n` ticks. Timers are placed on the lowest level that can hold them and move
+     * down a level when the wheel gets close to their expiry. Timers never fire early, but may fire up to one tick late.
+     *
+     * All member functions are thread-safe. The service must outlive all timers scheduled on it.
+     */
+    class TimerService {
+        static constexpr std::size_t slot_bits = 6;
+        static constexpr std::size_t slots = std::size_t{1} << slot_bits;
+        static constexpr std::size_t slot_mask = slots - 1;
+        static constexpr std::size_t levels = 6;
+
+        mutable std::mutex mutex_;
+        std::condition_variable_any wakeup_;
+        clock::duration resolution_;
+        clock::time_point start_;
+        std::uint64_t current_tick_ = 0;
+        std::size_t pending_ = 0;
+        // The tick the dedicated thread sleeps until, schedule only wakes it for an earlier timer.
+        std::uint64_t wakeup_tick_ = no_tick;
+        std::array<std::array<detail::timer_list, slots>, levels> wheel_;
+        std::jthread thread_;
+
+        static constexpr std::uint64_t no_tick = ~std::uint64_t{0};
+
+        static constexpr std::uint64_t max_delta() noexcept {
+            return (std::uint64_t{1} << (slot_bits * levels)) - 1;
+        }
+
+        void insert(detail::timer_node *node) noexcept {
+            auto expiry = node->expiry_tick_;
+            if (expiry <= current_tick_) {
+                // Only happens when cascading, the slot for the current tick is processed right after.
+                wheel_[0][current_tick_ & slot_mask].push_back(node);
+                return;
+            }
+            auto delta = expiry - current_tick_;
+            if (delta > max_delta()) {
+                // Park it as far out as the wheel reaches, it is re-inserted from there.
+                delta = max_delta();
+                expiry = current_tick_ + delta;
+            }
+            std::size_t level = 0;
+            while (level + 1 < levels && delta >= (std::uint64_t{1} << (slot_bits * (level + 1)))) {
+                level++;
+            }
+            wheel_[level][(expiry >> (slot_bits * level)) & slot_mask].push_back(node);
+        }
+
+        void cascade(std::size_t level) noexcept {
+            auto list = wheel_[level][(current_tick_ >> (slot_bits * level)) & slot_mask].take();
+            for (auto *node = list.head_; node;) {
+                auto *next = node->next_;
+                insert(node);
+                node = next;
+            }
+        }
+
+        void expire_current(std::vector<std::shared_ptr<detail::timer_node>> &expired) {
+            auto list = wheel_[0][current_tick_ & slot_mask].take();
+            for (auto *node = list.head_; node;) {
+                auto *next = node->next_;
+                node->prev_ = node->next_ = nullptr;
+                node->list_ = nullptr;
+                pending_--;
+                // The owner may be destroying the timer right now, in that case it is simply dropped.
+                if (auto alive = node->weak_from_this().lock()) {
+                    expired.push_back(std::move(alive));
+                }
+                node = next;
+            }
+        }
+
+        // The first tick after the current one that expires or cascades a non-empty slot, `no_tick` if there is none.
+        // Ticks before it have nothing to do. Scans at most `slots` slots per level.
+        std::uint64_t next_tick() const noexcept {
+            auto next = no_tick;
+            for (std::size_t level = 0; level < levels; level++) {
+                auto shift = slot_bits * level;
+                auto position = current_tick_ >> shift;
+                for (std::uint64_t i = 1; i <= slots; i++) {
+                    if (wheel_[level][(position + i) & slot_mask].head_) {
+                        next = std::min(next, (position + i) << shift);
+                        break;
+                    }
+                }
+            }
+            return next;
+        }
+
+        std::uint64_t tick_at(clock::time_point time) const noexcept {
+            if (time <= start_) {
+                return 0;
+            }
+            return static_cast<std::uint64_t>((time - start_) / resolution_);
+        }
+
+        void run(std::stop_token stop) {
+            std::unique_lock lock{mutex_};
+            while (!stop.stop_requested()) {
+                // Sleep until the next timer is due instead of waking up on every tick, schedule wakes the thread
+                // early if it adds an earlier timer.
+                auto target = pending_ == 0 ? no_tick : next_tick();
+                wakeup_tick_ = target;
+                auto earlier = [this, target] { return wakeup_tick_ != target; };
+                if (target == no_tick) {
+                    wakeup_.wait(lock, stop, earlier);
+                } else {
+                    wakeup_.wait_until(lock, stop, start_ + resolution_ * static_cast<clock::rep>(target), earlier);
+                }
+                wakeup_tick_ = no_tick;
+                lock.unlock();
+                advance(clock::now());
+                lock.lock();
+            }
+        }
+
+    public:
+        /**
+         * @brief Create a timer service.
+         * @param resolution The length of one tick.
+         * @param start The point in time that tick 0 refers to.
+         */
+        explicit TimerService(clock::duration resolution = std::chrono::milliseconds(1), clock::time_point start = clock::now())
+            : resolution_(resolution), start_(start) {
+        }
+
+        TimerService(const TimerService &) = delete;
+        TimerService &operator=(const TimerService &) = delete;
+
+        ~TimerService() {
+            stop();
+        }
+
+        /**
+         * @brief Start a dedicated thread that advances the service.
+         *
+         * The thread sleeps until the next pending timer is due, or until a timer is scheduled while none are
+         * pending, so an idle service or one with only distant timers doesn't wake up on every tick.
+         */
+        void start() {
+            std::scoped_lock lock{mutex_};
+            if (!thread_.joinable()) {
+                thread_ = std::jthread([this](std::stop_token stop) {
+                    run(std::move(stop));
+                });
+            }
+        }
+
+        /**
+         * @brief Stop the dedicated thread, if started. Pending timers are kept.
+         */
+        void stop() {
+            if (thread_.joinable()) {
+                thread_.request_stop();
+                thread_.join();
+            }
+        }
+
+        /**
+         * @brief Schedule a timer to fire at, or shortly after, `deadline`.
+         *
+         * A timer whose deadline has already passed fires immediately on the calling thread.
+         */
+        void schedule(std::shared_ptr<detail::timer_node> node, clock::time_point deadline) {
+            auto delta = deadline - start_;
+            auto ticks = delta <= clock::duration::zero() ? 0 : (delta + resolution_ - clock::duration(1)) / resolution_;
+            std::unique_lock lock{mutex_};
+            node->expiry_tick_ = static_cast<std::uint64_t>(ticks);
+            if (node->expiry_tick_ <= current_tick_) {
+                lock.unlock();
+                node->fire();
+                return;
+            }
+            insert(node.get());
+            pending_++;
+            if (node->expiry_tick_ < wakeup_tick_) {
+                // Only wake the thread if it would otherwise sleep past this timer.
+                wakeup_tick_ = node->expiry_tick_;
+                lock.unlock();
+                wakeup_.notify_one();
+            }
+        }
+
+        /**
+         * @brief Cancel a scheduled timer.
+         * @return true if the timer was pending, false if it already fired or was never scheduled.
+         */
+        bool cancel(detail::timer_node &node) noexcept {
+            std::scoped_lock lock{mutex_};
+            if (!node.list_) {
+                return false;
+            }
+            node.list_->erase(&node);
+            pending_--;
+            return true;
+        }
+
+        /**
+         * @brief Advance the service to `now` and fire all timers that have expired.
+         * @return The number of timers fired.
+         */
+        std::size_t advance(clock::time_point now) {
+            std::vector<std::shared_ptr<detail::timer_node>> expired;
+            {
+                std::scoped_lock lock{mutex_};
+                auto target = tick_at(now);
+                while (current_tick_ < target) {
+                    // Skip the ticks that have nothing to expire or cascade.
+                    auto next = pending_ == 0 ? no_tick : next_tick();
+                    if (next > target) {
+                        current_tick_ = target;
+                        break;
+                    }
+                    current_tick_ = next;
+                    for (std::size_t level = levels - 1; level > 0; level--) {
+                        if ((current_tick_ & ((std::uint64_t{1} << (slot_bits * level)) - 1)) == 0) {
+                            cascade(level);
+                        }
+                    }
+                    expire_current(expired);
+                }
+            }
+            for (auto &node : expired) {
+                node->fire();
+            }
+            return expired.size();
+        }
+
+        /**
+         * @brief Advance the service to the current time.
+         */
+        std::size_t poll() {
+            return advance(clock::now());
+        }
+
+        /**
+         * @brief The number of timers that are scheduled but have not fired yet.
+         *
+         * @note This is a snapshot in time, it may not be accurate when used later.
+         */
+        [[nodiscard]] std::size_t pending() const noexcept {
+            std::scoped_lock lock{mutex_};
+            return pending_;
+        }
+
+        /**
+         * @brief A process-wide timer service running on its own thread.
+         */
+        static TimerService &default_service() {
+            static TimerService service;
+            static const bool started = (service.start(), true);
+            (void)started;
+            return service;
+        }
+    };
+
+    namespace detail {
+        template<colite::executor::Executor Exec>
+        struct sleep_node final : timer_node {
+            std::coroutine_handle<> waiting_coro_;
+            Exec exec_;
+
+            explicit sleep_node(Exec exec) : exec_(std::move(exec)) {}
+
+            void fire() override {
+                std::weak_ptr<timer_node> alive_check = weak_from_this();
+                trace::emit(trace::Phase::Schedule, "timer::sleep", this, waiting_coro_);
+                colite::executor::execute(exec_, [alive_check, coro = waiting_coro_, node = this] {
+                    if (auto alive = alive_check.lock()) {
+                        trace::emit(trace::Phase::Resume, "timer::sleep", node, coro);
+                        coro.resume();
+                    }
+                });
+            }
+        };
+    }// namespace detail
+
+    /**
+     * @brief Provide an awaitable that resumes on `exec` once `deadline` has passed.
+     * @param service The timer service to schedule the wakeup on.
+     * @param exec The Executor to resume the coroutine on.
+     * @param deadline The point in time to sleep until.
+     *
+     * Destroying the awaiting coroutine cancels the timer.
+     */
+    template<colite::executor::Executor Exec>
+    [[nodiscard]] auto sleep_until(TimerService &service, Exec exec, clock::time_point deadline) {
+        using node_t = detail::sleep_node<Exec>;
+
+        struct awaitable {
+            TimerService *service_;
+            clock::time_point deadline_;
+            std::shared_ptr<node_t> node_;
+
+            awaitable(TimerService *service, clock::time_point deadline, std::shared_ptr<node_t> node)
+                : service_(service), deadline_(deadline), node_(std::move(node)) {}
+            awaitable(awaitable &&) noexcept = default;
+            ~awaitable() {
+                if (node_) {
+                    service_->cancel(*node_);
+                }
+            }
+
+            static constexpr bool await_ready() noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> to_suspend) {
+                node_->waiting_coro_ = to_suspend;
+                trace::emit(trace::Phase::Suspend, "timer::sleep", node_.get(), to_suspend);
+                service_->schedule(node_, deadline_);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        return awaitable{&service, deadline, std::make_shared<node_t>(std::move(exec))};
+    }
+
+    /**
+     * @brief Provide an awaitable that resumes on `exec` once `duration` has passed.
+     */
+    template<colite::executor::Executor Exec>
+    [[nodiscard]] auto sleep_for(TimerService &service, Exec exec, clock::duration duration) {
+        return sleep_until(service, std::move(exec), clock::now() + duration);
+    }
+
+    /**
+     * @brief Sleep until `deadline` using `TimerService::default_service()`.
+     */
+    template<colite::executor::Executor Exec>
+    [[nodiscard]] auto sleep_until(Exec exec, clock::time_point deadline) {
+        return sleep_until(TimerService::default_service(), std::move(exec), deadline);
+    }
+
+    /**
+     * @brief Sleep for `duration` using `TimerService::default_service()`.
+     */
+    template<colite::executor::Executor Exec>
+    [[nodiscard]] auto sleep_for(Exec exec, clock::duration duration) {
+        return sleep_for(TimerService::default_service(), std::move(exec), duration);
+    }
+}// namespace colite::timer
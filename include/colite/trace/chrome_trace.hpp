@@ -0,0 +1,167 @@
+#pragma once
+
+/**
+ * @file
+ * @brief A tracer that exports Chrome trace-event JSON.
+ *
+ * The output can be opened in `chrome://tracing` or https://ui.perfetto.dev. Every coroutine gets its own async track
+ * with two kinds of spans:
+ *
+ *   * `<primitive> wait`, from `Suspend` until the primitive schedules the coroutine again,
+ *   * `<primitive> queued`, from `Schedule` until the coroutine is resumed, i.e. the time spent in the executor queue.
+ *
+ * ## Example
+ *
+ * ```cpp
+ * colite::trace::ChromeTraceRecorder recorder;
+ * colite::trace::set_tracer(&recorder);
+ * run_workload();
+ * colite::trace::set_tracer(nullptr);
+ *
+ * std::ofstream file("colite.json");
+ * recorder.write_json(file);
+ * ```
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <colite/trace/trace.hpp>
+
+namespace colite::trace
+{
+    /**
+     * @brief Records all trace events in memory and writes them as Chrome trace-event JSON.
+     */
+    class ChromeTraceRecorder final: public Tracer
+    {
+        mutable std::mutex mutex_;
+        std::vector<Event> events_;
+
+        class writer
+        {
+            std::ostream &out_;
+            // The formatting of the caller's stream, restored once the events are written.
+            std::ios_base::fmtflags flags_;
+            std::streamsize precision_;
+            std::chrono::steady_clock::time_point origin_;
+            std::map<std::thread::id, int> tids_;
+            bool first_ = true;
+
+            int tid(std::thread::id thread) {
+                return tids_.try_emplace(thread, static_cast<int>(tids_.size()) + 1).first->second;
+            }
+
+            void pointer(const void *ptr) {
+                out_ << "\"0x" << std::hex << reinterpret_cast<std::uintptr_t>(ptr) << std::dec << "\"";
+            }
+
+            void event(char phase, const Event &at, const char *suffix, const Event &source) {
+                auto ts = std::chrono::duration<double, std::micro>(at.time - origin_).count();
+                out_ << (first_ ? "\n" : ",\n");
+                first_ = false;
+                out_ << "{\"name\":\"" << source.primitive << suffix << "\",\"cat\":\"colite\",\"ph\":\"" << phase
+                     << "\",\"ts\":" << ts << ",\"pid\":1,\"tid\":" << tid(at.thread)
+                     << ",\"id\":";
+                pointer(source.coroutine);
+                out_ << ",\"args\":{\"instance\":";
+                pointer(source.instance);
+                out_ << "}}";
+            }
+
+        public:
+            writer(std::ostream &out, std::chrono::steady_clock::time_point origin)
+                : out_(out), flags_(out.flags()), precision_(out.precision()), origin_(origin) {
+                out_ << std::dec << std::fixed << std::setprecision(3);
+            }
+            writer(const writer &) = delete;
+            writer &operator=(const writer &) = delete;
+            ~writer() {
+                out_.flags(flags_);
+                out_.precision(precision_);
+            }
+
+            void span(const Event &begin, const Event &end, const char *suffix) {
+                event('b', begin, suffix, begin);
+                event('e', end, suffix, begin);
+            }
+        };
+
+    public:
+        void record(const Event &event) noexcept override {
+            try {
+                std::scoped_lock lock{mutex_};
+                events_.push_back(event);
+            } catch (...) {
+                // Dropping an event is preferable to failing the traced operation.
+            }
+        }
+
+        /**
+         * @brief A copy of all recorded events, in the order they were recorded.
+         */
+        [[nodiscard]] std::vector<Event> events() const {
+            std::scoped_lock lock{mutex_};
+            return events_;
+        }
+
+        void clear() {
+            std::scoped_lock lock{mutex_};
+            events_.clear();
+        }
+
+        /**
+         * @brief Write all recorded events as a Chrome trace-event JSON object.
+         */
+        void write_json(std::ostream &out) const {
+            auto events = this->events();
+            std::stable_sort(events.begin(), events.end(), [](const Event &lhs, const Event &rhs) {
+                return lhs.time < rhs.time;
+            });
+
+            out << "{\"traceEvents\":[";
+            if (!events.empty()) {
+                writer w(out, events.front().time);
+                // The last Suspend or Schedule event of every coroutine that has not been resumed yet.
+                std::unordered_map<const void *, Event> pending;
+                for (const auto &event : events) {
+                    auto it = pending.find(event.coroutine);
+                    switch (event.phase) {
+                    case Phase::Suspend:
+                        if (it == pending.end()) {
+                            pending.emplace(event.coroutine, event);
+                        } else if (it->second.phase == Phase::Schedule) {
+                            // Woken up, but had to go back to waiting.
+                            w.span(it->second, event, " queued");
+                            it->second = event;
+                        }
+                        break;
+                    case Phase::Schedule:
+                        if (it != pending.end() && it->second.phase == Phase::Suspend) {
+                            w.span(it->second, event, " wait");
+                            it->second = event;
+                        }
+                        break;
+                    case Phase::Resume:
+                        if (it != pending.end() && it->second.phase == Phase::Schedule) {
+                            w.span(it->second, event, " queued");
+                        }
+                        if (it != pending.end()) {
+                            pending.erase(it);
+                        }
+                        break;
+                    }
+                }
+            }
+            out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+    };
+}// namespace colite::trace
@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Optional tracing hooks for the awaitables in colite.
+ *
+ * When `COLITE_TRACE` is defined every colite awaitable reports three kinds of events to the installed `Tracer`:
+ *
+ *   * `Phase::Suspend` when a coroutine suspends waiting on a primitive,
+ *   * `Phase::Schedule` when the primitive posts the coroutine to its executor,
+ *   * `Phase::Resume` when the posted function starts running and resumes the coroutine.
+ *
+ * The time between `Schedule` and `Resume` is the time the coroutine spent sitting in the executor queue. A woken
+ * coroutine that has to go back to waiting reports a new `Suspend` instead of a `Resume`.
+ *
+ * Without `COLITE_TRACE` the hooks are empty inline functions and compile to nothing.
+ *
+ * See `colite/trace/chrome_trace.hpp` for a tracer that exports Chrome trace-event JSON.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <thread>
+
+namespace colite::trace
+{
+#ifdef COLITE_TRACE
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    enum class Phase
+    {
+        Suspend,
+        Schedule,
+        Resume,
+    };
+
+    /**
+     * @brief A single trace event.
+     */
+    struct Event
+    {
+        Phase phase;
+        // Name of the kind of primitive, for instance "mutex" or "mpmc::channel".
+        const char *primitive;
+        // Identity of the primitive instance, may be null for awaitables that are not tied to an instance.
+        const void *instance;
+        // Identity of the coroutine, the address of its handle.
+        const void *coroutine;
+        std::chrono::steady_clock::time_point time;
+        std::thread::id thread;
+    };
+
+    /**
+     * @brief Interface for receivers of trace events.
+     *
+     * `record` is called from whatever thread the event happens on, possibly with internal locks of the primitive held.
+     * It must be thread-safe and must not call back into colite.
+     */
+    class Tracer
+    {
+    public:
+        virtual ~Tracer() = default;
+        virtual void record(const Event &event) noexcept = 0;
+    };
+
+    namespace detail {
+        inline std::atomic<Tracer *> current_tracer{nullptr};
+    }
+
+    /**
+     * @brief Install a tracer, or remove it by passing `nullptr`.
+     * @return The previously installed tracer.
+     *
+     * The tracer must stay alive until it is removed and no colite awaitable is running anymore.
+     */
+    inline Tracer *set_tracer(Tracer *tracer) noexcept {
+        return detail::current_tracer.exchange(tracer, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Report an event to the installed tracer, if any.
+     */
+    inline void emit([[maybe_unused]] Phase phase, [[maybe_unused]] const char *primitive, [[maybe_unused]] const void *instance,
+                     [[maybe_unused]] std::coroutine_handle<> coroutine) noexcept {
+#ifdef COLITE_TRACE
+        if (auto *tracer = detail::current_tracer.load(std::memory_order_acquire)) {
+            tracer->record(Event{phase, primitive, instance, coroutine.address(), std::chrono::steady_clock::now(),
+                                 std::this_thread::get_id()});
+        }
+#endif
+    }
+}// namespace colite::trace
@@ -0,0 +1,193 @@
+#include <colite/sync/broadcast.hpp>
+
+#include <gtest/gtest.h>
+
+#include "folly_exec.hpp"
+#include "task.hpp"
+
+#include <optional>
+#include <stdexcept>
+
+TEST(broadcast, try_send_receive)
+{
+    auto [sender, receiver] = colite::broadcast::channel<int>(4);
+    auto receiver2 = receiver;
+
+    ASSERT_EQ(sender.send(1).value(), 2);
+    ASSERT_EQ(sender.send(2).value(), 2);
+
+    EXPECT_EQ(*receiver.try_receive().value(), 1);
+    EXPECT_EQ(*receiver.try_receive().value(), 2);
+    EXPECT_EQ(receiver.try_receive().error(), colite::broadcast::TryReceiveError::Empty);
+
+    auto first = receiver2.try_receive().value();
+    EXPECT_EQ(*first, 1);
+    EXPECT_EQ(*receiver2.try_receive().value(), 2);
+    EXPECT_EQ(receiver2.try_receive().error(), colite::broadcast::TryReceiveError::Empty);
+}
+
+TEST(broadcast, values_are_shared)
+{
+    auto [sender, receiver] = colite::broadcast::channel<std::string>(4);
+    auto receiver2 = receiver;
+
+    ASSERT_TRUE(sender.send("Hello world").has_value());
+    auto first = receiver.try_receive().value();
+    auto second = receiver2.try_receive().value();
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(*first, "Hello world");
+}
+
+TEST(broadcast, subscribe_sees_only_new_values)
+{
+    auto [sender, receiver] = colite::broadcast::channel<int>(4);
+
+    ASSERT_TRUE(sender.send(1).has_value());
+    auto late = sender.subscribe();
+    EXPECT_EQ(late.available(), 0);
+    ASSERT_EQ(sender.send(2).value(), 2);
+
+    EXPECT_EQ(*late.try_receive().value(), 2);
+    EXPECT_EQ(receiver.available(), 2);
+}
+
+TEST(broadcast, lagged)
+{
+    auto [sender, receiver] = colite::broadcast::channel<int>(2);
+
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(sender.send(i).has_value());
+    }
+
+    EXPECT_EQ(receiver.try_receive().error(), colite::broadcast::TryReceiveError::Lagged);
+    EXPECT_EQ(*receiver.try_receive().value(), 3);
+    EXPECT_EQ(*receiver.try_receive().value(), 4);
+    EXPECT_EQ(receiver.try_receive().error(), colite::broadcast::TryReceiveError::Empty);
+}
+
+TEST(broadcast, closed_on_deleted_sender)
+{
+    auto [sender, receiver] = colite::broadcast::channel<int>(2);
+    std::optional<colite::broadcast::Sender<int>> wrapped_sender(std::move(sender));
+
+    ASSERT_TRUE(wrapped_sender->send(1).has_value());
+    wrapped_sender.reset();
+
+    EXPECT_EQ(*receiver.try_receive().value(), 1);
+    EXPECT_EQ(receiver.try_receive().error(), colite::broadcast::TryReceiveError::Closed);
+}
+
+TEST(broadcast, closed_on_deleted_receiver)
+{
+    auto [sender, receiver] = colite::broadcast::channel<int>(2);
+    std::optional<colite::broadcast::Receiver<int>> wrapped_receiver(std::move(receiver));
+    wrapped_receiver.reset();
+
+    EXPECT_EQ(sender.send(1).error(), colite::broadcast::SendError::Closed);
+    auto new_receiver = sender.subscribe();
+    EXPECT_TRUE(sender.send(1).has_value());
+}
+
+TEST(broadcast, all_receivers_woken)
+{
+    tests::manual_executor exec;
+    auto [sender, receiver] = colite::broadcast::channel<int>(4);
+
+    int sum = 0;
+    auto make_receiver = [&](colite::broadcast::Receiver<int> recv) -> detail::task {
+        for (int i = 0; i < 3; i++) {
+            auto value = co_await recv.receive(exec);
+            sum += **value;
+        }
+    };
+    auto first = make_receiver(receiver);
+    auto second = make_receiver(receiver);
+
+    first.start_on(exec);
+    second.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(first.is_done());
+    ASSERT_FALSE(second.is_done());
+
+    for (int i = 1; i <= 3; i++) {
+        ASSERT_TRUE(sender.send(i).has_value());
+        exec.run();
+    }
+
+    EXPECT_TRUE(first.is_done());
+    EXPECT_TRUE(second.is_done());
+    EXPECT_EQ(sum, 12);
+}
+
+TEST(broadcast, receive_closed_on_deleted_sender)
+{
+    tests::manual_executor exec;
+    auto [sender, receiver] = colite::broadcast::channel<int>(4);
+    std::optional<colite::broadcast::Sender<int>> wrapped_sender(std::move(sender));
+
+    bool closed = false;
+    auto receive = [&]() -> detail::task {
+        auto value = co_await receiver.receive(exec);
+        closed = !value && value.error() == colite::broadcast::ReceiveError::Closed;
+    };
+    auto task = receive();
+
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    wrapped_sender.reset();
+    exec.run();
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_TRUE(closed);
+}
+
+TEST(broadcast, destroy_task_before_receiver_wakeup)
+{
+    tests::manual_executor exec;
+    auto [sender, receiver] = colite::broadcast::channel<int>(4);
+
+    auto receive_task = std::make_unique<detail::task>([](colite::broadcast::Receiver<int> recv, tests::manual_executor exec) -> detail::task {
+        co_await recv.receive(exec);
+    }(receiver, exec));
+
+    receive_task->start_on(exec);
+    EXPECT_EQ(exec.run(), 1);
+
+    ASSERT_TRUE(sender.send(1).has_value());
+    receive_task.reset();
+    EXPECT_EQ(exec.run(), 1);
+}
+
+TEST(broadcast, receiver_moved_while_receiving)
+{
+    tests::manual_executor exec;
+    auto [sender, receiver] = colite::broadcast::channel<int>(4);
+
+    std::optional<colite::Expected<std::shared_ptr<const int>, colite::broadcast::ReceiveError>> result;
+    auto receive = [&]() -> detail::task {
+        result = co_await receiver.receive(exec);
+    };
+    auto task = receive();
+
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    // The pending receive still advances the cursor of the receiver it was moved to.
+    auto moved = std::move(receiver);
+    ASSERT_TRUE(sender.send(1).has_value());
+    ASSERT_TRUE(sender.send(2).has_value());
+    exec.run();
+
+    ASSERT_TRUE(task.is_done());
+    EXPECT_EQ(*result->value(), 1);
+    EXPECT_EQ(moved.available(), 1);
+    EXPECT_EQ(*moved.try_receive().value(), 2);
+}
+
+TEST(broadcast, zero_capacity_throws)
+{
+    EXPECT_THROW(colite::broadcast::channel<int>(0), std::invalid_argument);
+}
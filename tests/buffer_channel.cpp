@@ -0,0 +1,135 @@
+#include <colite/sync/buffer_channel.hpp>
+
+#include <gtest/gtest.h>
+
+#include "task.hpp"
+
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <vector>
+
+TEST(buffer_channel, new_buffer_spans_its_capacity)
+{
+    colite::mpmc::BufferPool pool(128);
+    auto buffer = pool.acquire();
+    EXPECT_EQ(buffer.size(), 128);
+    EXPECT_EQ(buffer.capacity(), 128);
+    buffer.resize(10);
+    EXPECT_EQ(buffer.data().size(), 10);
+    buffer.resize(1000);
+    EXPECT_EQ(buffer.size(), 128);
+}
+
+TEST(buffer_channel, receiver_sees_the_sent_memory)
+{
+    auto channel = colite::mpmc::buffer_channel(64);
+    auto buffer = channel.pool.acquire();
+    std::memcpy(buffer.data().data(), "record", 6);
+    buffer.resize(6);
+    const auto *sent_data = buffer.data().data();
+
+    ASSERT_TRUE(channel.sender.try_send(std::move(buffer)).has_value());
+    auto view = channel.receiver.try_receive();
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(view->data().data(), sent_data);
+    EXPECT_EQ(view->size(), 6);
+    EXPECT_EQ(std::memcmp(view->data().data(), "record", 6), 0);
+}
+
+TEST(buffer_channel, released_buffers_are_reused)
+{
+    auto channel = colite::mpmc::buffer_channel(1024);
+    std::optional<std::uint8_t> received;
+    for (int i = 0; i < 100; i++) {
+        auto buffer = channel.pool.acquire();
+        buffer.data()[0] = static_cast<std::byte>(i);
+        auto task = [](colite::mpmc::BufferChannel<> &channel, colite::mpmc::Buffer buffer, std::optional<std::uint8_t> &received) -> detail::task {
+            co_await channel.sender.send(colite::executor::ImmediateExecutor{}, std::move(buffer));
+            auto view = co_await channel.receiver.receive(colite::executor::ImmediateExecutor{});
+            received = static_cast<std::uint8_t>(view->data()[0]);
+        }(channel, std::move(buffer), received);
+        task.start_on(colite::executor::ImmediateExecutor{});
+        EXPECT_EQ(received, i);
+    }
+    // Steady state: one buffer, handed back and forth.
+    EXPECT_EQ(channel.pool.allocated(), 1);
+    EXPECT_EQ(channel.pool.pooled(), 1);
+}
+
+TEST(buffer_channel, copies_keep_the_buffer_in_use)
+{
+    colite::mpmc::BufferPool pool(16);
+    std::optional<colite::mpmc::BufferView> first = pool.acquire();
+    std::optional<colite::mpmc::BufferView> second = *first;
+    EXPECT_EQ(first->data().data(), second->data().data());
+
+    first.reset();
+    EXPECT_EQ(pool.pooled(), 0);
+    second.reset();
+    EXPECT_EQ(pool.pooled(), 1);
+    EXPECT_EQ(pool.allocated(), 1);
+}
+
+TEST(buffer_channel, full_pool_frees_released_buffers)
+{
+    colite::mpmc::BufferPool pool(16, 2);
+    {
+        std::vector<colite::mpmc::Buffer> buffers;
+        for (int i = 0; i < 5; i++) {
+            buffers.push_back(pool.acquire());
+        }
+        EXPECT_EQ(pool.allocated(), 5);
+    }
+    EXPECT_EQ(pool.pooled(), 2);
+    EXPECT_EQ(pool.allocated(), 2);
+}
+
+TEST(buffer_channel, buffers_outlive_channel_and_pool)
+{
+    std::optional<colite::mpmc::BufferView> view;
+    {
+        auto channel = colite::mpmc::buffer_channel(32);
+        auto buffer = channel.pool.acquire();
+        buffer.data()[0] = std::byte{42};
+        ASSERT_TRUE(channel.sender.try_send(std::move(buffer)).has_value());
+        view = channel.receiver.try_receive().value();
+    }
+    EXPECT_EQ(view->data()[0], std::byte{42});
+    // Frees the buffer and the pool.
+    view.reset();
+}
+
+TEST(buffer_channel, lock_free_threads)
+{
+    constexpr int messages = 20000;
+    auto channel = colite::mpmc::buffer_channel<colite::mpmc::LockFree>(256, 64, 16);
+
+    std::thread producer([pool = channel.pool, sender = std::move(channel.sender)]() mutable {
+        for (int i = 0; i < messages; i++) {
+            auto buffer = pool.acquire();
+            std::memcpy(buffer.data().data(), &i, sizeof(i));
+            buffer.resize(sizeof(i));
+            colite::mpmc::BufferView view = std::move(buffer);
+            while (!sender.try_send(view).has_value()) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < messages) {
+        auto view = channel.receiver.try_receive();
+        if (!view) {
+            std::this_thread::yield();
+            continue;
+        }
+        int value;
+        std::memcpy(&value, view->data().data(), sizeof(value));
+        EXPECT_EQ(value, expected);
+        expected++;
+    }
+    producer.join();
+    // Bounded by the channel capacity plus the buffers in the hands of the two threads.
+    EXPECT_LE(channel.pool.allocated(), 16 + 2 + 2);
+}
@@ -1,11 +1,19 @@
 #include <colite/sync/channel.hpp>
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/ManualExecutor.h>
 #include <gtest/gtest.h>
 
 #include "folly_exec.hpp"
 #include "task.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 TEST(channel, try_send_receive)
 {
     auto channel = colite::mpmc::channel<int>();
@@ -320,4 +328,583 @@ TEST(channel, destroy_task_pending_sender)
     EXPECT_EQ(exec.run(), 1);
     Senderask.reset();
     EXPECT_EQ(exec.run(), 1);
-}
\ No newline at end of file
+}
+TEST(channel, receive_cancelled)
+{
+    tests::manual_executor exec;
+
+    auto [sender, receiver] = colite::mpmc::channel<int>();
+    std::stop_source stop;
+    std::optional<colite::mpmc::ReceiveError> error;
+    auto waiter = [&]() -> detail::task {
+        auto result = co_await receiver.receive(exec, stop.get_token());
+        if (!result) {
+            error = result.error();
+        }
+    };
+    auto task = waiter();
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    stop.request_stop();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(error, colite::mpmc::ReceiveError::Cancelled);
+
+    // A cancelled receive never consumes data
+    ASSERT_TRUE(sender.try_send(1).has_value());
+    EXPECT_EQ(exec.run(), 0);
+    EXPECT_EQ(receiver.try_receive().value(), 1);
+}
+
+TEST(channel, receive_already_cancelled_takes_available_data)
+{
+    auto [sender, receiver] = colite::mpmc::channel<int>();
+    std::stop_source stop;
+    stop.request_stop();
+
+    ASSERT_TRUE(sender.try_send(1).has_value());
+    std::optional<colite::Expected<int, colite::mpmc::ReceiveError>> first;
+    std::optional<colite::Expected<int, colite::mpmc::ReceiveError>> second;
+    auto waiter = [&]() -> detail::task {
+        first = co_await receiver.receive(colite::executor::ImmediateExecutor{}, stop.get_token());
+        second = co_await receiver.receive(colite::executor::ImmediateExecutor{}, stop.get_token());
+    };
+    auto task = waiter();
+    task.start_on(colite::executor::ImmediateExecutor{});
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(first->value(), 1);
+    EXPECT_EQ(second->error(), colite::mpmc::ReceiveError::Cancelled);
+}
+
+TEST(channel, receive_timeout)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(std::chrono::milliseconds(1), start);
+
+    auto [sender, receiver] = colite::mpmc::channel<int>();
+    std::vector<colite::Expected<int, colite::mpmc::ReceiveError>> results;
+    auto waiter = [&]() -> detail::task {
+        results.push_back(co_await receiver.receive_until(timers, exec, start + std::chrono::milliseconds(5)));
+        results.push_back(co_await receiver.receive_until(timers, exec, start + std::chrono::milliseconds(10)));
+    };
+    auto task = waiter();
+    task.start_on(exec);
+    exec.run();
+
+    ASSERT_TRUE(sender.try_send(1).has_value());
+    exec.run();
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].value(), 1);
+    EXPECT_EQ(timers.pending(), 1);
+
+    timers.advance(start + std::chrono::milliseconds(10));
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[1].error(), colite::mpmc::ReceiveError::TimedOut);
+}
+
+TEST(channel, metrics) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+
+    auto receive = [](colite::mpmc::Receiver<int> receiver, tests::manual_executor exec) -> detail::task {
+        co_await receiver.receive(exec);
+    };
+    auto task = receive(channel.receiver, exec);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 1);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(channel.sender.try_send(i).has_value());
+    }
+    exec.run();
+    ASSERT_TRUE(task.is_done());
+
+    auto metrics = channel.receiver.metrics();
+    EXPECT_EQ(metrics.depth, 2);
+    EXPECT_EQ(channel.receiver.available(), 2);
+    EXPECT_EQ(metrics.high_water_mark, 3);
+    EXPECT_EQ(metrics.sent, 3);
+    EXPECT_EQ(metrics.received, 1);
+    EXPECT_EQ(metrics.parked_receivers, 0);
+    EXPECT_FALSE(metrics.closed);
+
+    std::uint64_t timed = 0;
+    for (auto count : metrics.time_in_queue) {
+        timed += count;
+    }
+    EXPECT_EQ(timed, colite::instrument::enabled ? 1 : 0);
+
+    {
+        auto sender = std::move(channel.sender);
+    }
+    EXPECT_TRUE(channel.receiver.metrics().closed);
+}
+
+TEST(channel, closes_when_last_copies_are_destroyed_concurrently) {
+    for (int round = 0; round < 100; round++) {
+        auto channel = colite::mpmc::channel<int>();
+        std::vector<colite::mpmc::Sender<int>> senders(4, channel.sender);
+        {
+            auto drop = std::move(channel.sender);
+        }
+
+        std::vector<std::thread> threads;
+        for (auto &sender : senders) {
+            threads.emplace_back([sender = std::move(sender)]() mutable {
+                auto copy = sender;
+                ASSERT_TRUE(copy.try_send(1).has_value());
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        for (int i = 0; i < 4; i++) {
+            EXPECT_EQ(channel.receiver.try_receive().value(), 1);
+        }
+        EXPECT_EQ(channel.receiver.try_receive().error(), colite::mpmc::TryReceiveError::Closed);
+    }
+}
+
+TEST(channel, assignment_keeps_channel_open) {
+    auto channel = colite::mpmc::channel<int>();
+    auto other = colite::mpmc::channel<int>();
+
+    auto sender = channel.sender;
+    sender = other.sender;
+    EXPECT_FALSE(channel.receiver.metrics().closed);
+    channel.sender = std::move(sender);
+    EXPECT_TRUE(channel.receiver.metrics().closed);
+    EXPECT_FALSE(other.receiver.metrics().closed);
+}
+
+TEST(channel, close_wakes_parked_receivers) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+
+    std::vector<colite::mpmc::ReceiveError> errors;
+    auto receive = [](colite::mpmc::Receiver<int> receiver, tests::manual_executor exec, std::vector<colite::mpmc::ReceiveError> &errors) -> detail::task {
+        errors.push_back((co_await receiver.receive(exec)).error());
+    };
+    auto first = receive(channel.receiver, exec, errors);
+    auto second = receive(channel.receiver, exec, errors);
+    first.start_on(exec);
+    second.start_on(exec);
+    exec.run();
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 2);
+
+    channel.sender.close();
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 0);
+    exec.run();
+    EXPECT_TRUE(first.is_done());
+    EXPECT_TRUE(second.is_done());
+    EXPECT_EQ(errors, std::vector(2, colite::mpmc::ReceiveError::Closed));
+    EXPECT_EQ(channel.sender.try_send(1).error(), colite::mpmc::SendError::Closed);
+}
+
+TEST(channel, receiver_close_keeps_queued_values) {
+    auto channel = colite::mpmc::channel<int>();
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+
+    channel.receiver.close();
+    channel.receiver.close();
+    EXPECT_TRUE(channel.receiver.metrics().closed);
+    EXPECT_EQ(channel.sender.try_send(3).error(), colite::mpmc::SendError::Closed);
+    EXPECT_EQ(channel.receiver.try_receive().value(), 1);
+    EXPECT_EQ(channel.receiver.try_receive().value(), 2);
+    EXPECT_EQ(channel.receiver.try_receive().error(), colite::mpmc::TryReceiveError::Closed);
+}
+
+TEST(channel, drain_waits_until_empty) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+
+    auto drain = [](colite::mpmc::Sender<int> sender, tests::manual_executor exec) -> detail::task {
+        sender.close();
+        EXPECT_TRUE((co_await sender.drain(exec)).has_value());
+    };
+    auto task = drain(channel.sender, exec);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+
+    EXPECT_EQ(channel.receiver.try_receive().value(), 1);
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+    EXPECT_EQ(channel.receiver.try_receive().value(), 2);
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(channel, drain_of_empty_channel_completes_right_away) {
+    auto channel = colite::mpmc::channel<int>();
+    auto task = [](colite::mpmc::Sender<int> sender) -> detail::task {
+        EXPECT_TRUE((co_await sender.drain(colite::executor::ImmediateExecutor{})).has_value());
+    }(channel.sender);
+    task.start_on(colite::executor::ImmediateExecutor{});
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(channel, drain_fails_when_receivers_are_gone) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+
+    auto drain = [](colite::mpmc::Sender<int> sender, tests::manual_executor exec) -> detail::task {
+        EXPECT_EQ((co_await sender.drain(exec)).error(), colite::mpmc::SendError::Closed);
+    };
+    auto task = drain(channel.sender, exec);
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    channel.receiver.close();
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+    {
+        auto receiver = std::move(channel.receiver);
+    }
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(channel, state_groups_are_on_separate_cache_lines) {
+    using state_t = colite::mpmc::detail::state_t<int>;
+    static_assert(alignof(state_t) == colite::detail::cache_line_size);
+    // Lock and queue, sender metrics, receiver metrics and control data.
+    EXPECT_GE(sizeof(state_t), 4 * colite::detail::cache_line_size);
+}
+
+TEST(channel, lock_free_try_send_receive) {
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(2);
+
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+    EXPECT_EQ(channel.sender.try_send(3).error(), colite::mpmc::SendError::Full);
+    EXPECT_EQ(channel.receiver.available(), 2);
+    EXPECT_EQ(channel.receiver.try_receive().value(), 1);
+    ASSERT_TRUE(channel.sender.try_send(3).has_value());
+
+    {
+        auto sender = std::move(channel.sender);
+    }
+    EXPECT_EQ(channel.receiver.try_receive().value(), 2);
+    EXPECT_EQ(channel.receiver.try_receive().value(), 3);
+    EXPECT_EQ(channel.receiver.try_receive().error(), colite::mpmc::TryReceiveError::Closed);
+}
+
+TEST(channel, lock_free_receiver_parks_until_send) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(4);
+
+    int value_received = 0;
+    auto receive = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, tests::manual_executor exec, int &value) -> detail::task {
+        value = (co_await receiver.receive(exec)).value();
+    };
+    auto task = receive(channel.receiver, exec, value_received);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 1);
+
+    ASSERT_TRUE(channel.sender.try_send(5).has_value());
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(value_received, 5);
+}
+
+TEST(channel, lock_free_send_wakes_one_receiver) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(4);
+
+    int received = 0;
+    auto receive = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, tests::manual_executor exec, int &received) -> detail::task {
+        (void)(co_await receiver.receive(exec)).value();
+        received++;
+    };
+    std::vector<detail::task> tasks;
+    for (int i = 0; i < 3; i++) {
+        tasks.push_back(receive(channel.receiver, exec, received));
+        tasks.back().start_on(exec);
+    }
+    exec.run();
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 3);
+
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 2);
+    exec.run();
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 2);
+
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+    ASSERT_TRUE(channel.sender.try_send(3).has_value());
+    exec.run();
+    EXPECT_EQ(received, 3);
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 0);
+}
+
+TEST(channel, lock_free_wakeup_passes_on_from_destroyed_receiver) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(4);
+
+    int value_received = 0;
+    auto receive = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, tests::manual_executor exec, int &value) -> detail::task {
+        value = (co_await receiver.receive(exec)).value();
+    };
+    auto first = std::make_unique<detail::task>(receive(channel.receiver, exec, value_received));
+    auto second = receive(channel.receiver, exec, value_received);
+    first->start_on(exec);
+    second.start_on(exec);
+    exec.run();
+
+    // The first receiver is woken for the value, but destroyed before it runs.
+    ASSERT_TRUE(channel.sender.try_send(5).has_value());
+    first.reset();
+    for (int i = 0; i < 3; i++) {
+        exec.run();
+    }
+    EXPECT_TRUE(second.is_done());
+    EXPECT_EQ(value_received, 5);
+}
+
+TEST(channel, lock_free_sender_parks_when_full) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(2);
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+
+    auto send = [](colite::mpmc::Sender<int, colite::mpmc::LockFree> sender, tests::manual_executor exec) -> detail::task {
+        EXPECT_TRUE((co_await sender.send(exec, 3)).has_value());
+    };
+    auto task = send(channel.sender, exec);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+    EXPECT_EQ(channel.receiver.metrics().parked_senders, 1);
+
+    EXPECT_EQ(channel.receiver.try_receive().value(), 1);
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(channel.receiver.metrics().parked_senders, 0);
+    EXPECT_EQ(channel.receiver.try_receive().value(), 2);
+    EXPECT_EQ(channel.receiver.try_receive().value(), 3);
+}
+
+TEST(channel, lock_free_parked_sender_sees_closed) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(2);
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+
+    auto send = [](colite::mpmc::Sender<int, colite::mpmc::LockFree> sender, tests::manual_executor exec) -> detail::task {
+        EXPECT_EQ((co_await sender.send(exec, 3)).error(), colite::mpmc::SendError::Closed);
+    };
+    auto task = send(channel.sender, exec);
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    {
+        auto receiver = std::move(channel.receiver);
+    }
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(channel, lock_free_drain_waits_until_empty) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(4);
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+
+    auto drain = [](colite::mpmc::Sender<int, colite::mpmc::LockFree> sender, tests::manual_executor exec) -> detail::task {
+        sender.close();
+        EXPECT_TRUE((co_await sender.drain(exec)).has_value());
+    };
+    auto task = drain(channel.sender, exec);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+
+    auto receive = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, tests::manual_executor exec) -> detail::task {
+        while ((co_await receiver.receive(exec)).has_value()) {
+        }
+    };
+    auto receiver = receive(channel.receiver, exec);
+    receiver.start_on(exec);
+    while (exec.run() > 0) {
+    }
+    EXPECT_TRUE(receiver.is_done());
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(channel, for_each_receives_until_closed) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+
+    std::vector<int> received;
+    auto consume = [](colite::mpmc::Receiver<int> receiver, tests::manual_executor exec, std::vector<int> &received) -> detail::task {
+        co_await colite::mpmc::for_each(exec, std::move(receiver), [&](int value) {
+            received.push_back(value);
+        });
+    };
+    auto task = consume(channel.receiver, exec, received);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_EQ(received, (std::vector{1, 2}));
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 1);
+
+    // Everything sent before the wakeup runs is handled in one go.
+    ASSERT_TRUE(channel.sender.try_send(3).has_value());
+    ASSERT_TRUE(channel.sender.try_send(4).has_value());
+    ASSERT_TRUE(channel.sender.try_send(5).has_value());
+    EXPECT_EQ(exec.run(), 1);
+    EXPECT_EQ(received, (std::vector{1, 2, 3, 4, 5}));
+    EXPECT_FALSE(task.is_done());
+
+    channel.sender.close();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(channel, for_each_rethrows) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+
+    bool caught = false;
+    auto consume = [](colite::mpmc::Receiver<int> receiver, tests::manual_executor exec, bool &caught) -> detail::task {
+        try {
+            co_await colite::mpmc::for_each(exec, std::move(receiver), [](int value) {
+                if (value == 2) {
+                    throw std::runtime_error("two");
+                }
+            });
+        } catch (const std::runtime_error &) {
+            caught = true;
+        }
+    };
+    auto task = consume(channel.receiver, exec, caught);
+    task.start_on(exec);
+    exec.run();
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+    ASSERT_TRUE(channel.sender.try_send(2).has_value());
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(channel.receiver.metrics().parked_receivers, 0);
+}
+
+TEST(channel, lock_free_for_each_makes_room_for_senders) {
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(2);
+
+    auto send = [](colite::mpmc::Sender<int, colite::mpmc::LockFree> sender, tests::manual_executor exec) -> detail::task {
+        for (int i = 1; i <= 5; i++) {
+            EXPECT_TRUE((co_await sender.send(exec, i)).has_value());
+        }
+        sender.close();
+    };
+    auto producer = send(channel.sender, exec);
+    producer.start_on(exec);
+    while (exec.run() > 0) {
+    }
+    EXPECT_EQ(channel.receiver.metrics().parked_senders, 1);
+
+    int sum = 0;
+    auto consume = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, tests::manual_executor exec, int &sum) -> detail::task {
+        co_await colite::mpmc::for_each(exec, std::move(receiver), [&](int value) {
+            sum += value;
+        });
+    };
+    auto consumer = consume(channel.receiver, exec, sum);
+    consumer.start_on(exec);
+    while (exec.run() > 0) {
+    }
+    EXPECT_TRUE(producer.is_done());
+    EXPECT_TRUE(consumer.is_done());
+    EXPECT_EQ(sum, 15);
+}
+
+TEST(channel, lock_free_threads) {
+    constexpr int producers = 4;
+    constexpr int consumers = 4;
+    constexpr int values_per_producer = 20000;
+    // A small capacity keeps both the empty and the full transitions busy.
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(8);
+
+    folly::CPUThreadPoolExecutor pool(4);
+    auto exec = colite::executor::adapt([&pool](auto fn) {
+        pool.add(std::move(fn));
+    });
+    using exec_t = decltype(exec);
+
+    std::atomic<int> finished{0};
+    std::atomic<long long> sum{0};
+    std::atomic<int> received{0};
+
+    // Counts a task as finished once its body is done, after the task has been marked done.
+    struct finish_guard {
+        std::atomic<int> &finished_;
+        ~finish_guard() {
+            finished_++;
+        }
+    };
+
+    auto produce = [](colite::mpmc::Sender<int, colite::mpmc::LockFree> sender, exec_t exec, std::atomic<int> &finished) -> detail::task {
+        finish_guard guard{finished};
+        for (int i = 1; i <= values_per_producer; i++) {
+            EXPECT_TRUE((co_await sender.send(exec, i)).has_value());
+        }
+    };
+    auto consume = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, exec_t exec, std::atomic<int> &finished,
+                      std::atomic<long long> &sum, std::atomic<int> &received) -> detail::task {
+        finish_guard guard{finished};
+        while (true) {
+            auto value = co_await receiver.receive(exec);
+            if (!value.has_value()) {
+                break;
+            }
+            sum += *value;
+            received++;
+        }
+    };
+
+    std::vector<detail::task> tasks;
+    for (int i = 0; i < producers; i++) {
+        tasks.push_back(produce(channel.sender, exec, finished));
+    }
+    for (int i = 0; i < consumers; i++) {
+        tasks.push_back(consume(channel.receiver, exec, finished, sum, received));
+    }
+    // The tasks hold their own copies, dropping the originals lets the channel close once the producers are done.
+    {
+        auto drop = std::move(channel);
+    }
+    for (auto &task : tasks) {
+        task.start_on(exec);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (finished < producers + consumers && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    pool.join();
+
+    ASSERT_EQ(finished, producers + consumers);
+    EXPECT_EQ(received, producers * values_per_producer);
+    EXPECT_EQ(sum, static_cast<long long>(producers) * values_per_producer * (values_per_producer + 1) / 2);
+}
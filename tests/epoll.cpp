@@ -0,0 +1,272 @@
+#include <colite/io/epoll.hpp>
+
+#include <gtest/gtest.h>
+
+#include "task.hpp"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <cerrno>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    struct pipe_fds
+    {
+        int read_ = -1;
+        int write_ = -1;
+
+        pipe_fds() {
+            int fds[2];
+            if (::pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0) {
+                read_ = fds[0];
+                write_ = fds[1];
+            }
+        }
+        ~pipe_fds() {
+            ::close(read_);
+            ::close(write_);
+        }
+    };
+
+    void run_until_done(colite::io::EpollReactor &reactor, const detail::task &task) {
+        while (!task.is_done()) {
+            reactor.run_once();
+        }
+    }
+}
+
+TEST(epoll, executor_runs_posted_functions)
+{
+    colite::io::EpollReactor reactor;
+    auto exec = reactor.executor();
+
+    int local = 0;
+    std::thread::id ran_on;
+    colite::executor::execute(exec, [&] {
+        ran_on = std::this_thread::get_id();
+        // Posted from the loop thread, runs in the next round.
+        colite::executor::execute(exec, [&] { local++; });
+    });
+    std::thread poster([&] {
+        colite::executor::execute(exec, [&] { reactor.stop(); });
+    });
+    reactor.run();
+    poster.join();
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+    while (reactor.poll() > 0) {
+    }
+    EXPECT_EQ(local, 1);
+}
+
+TEST(epoll, readable_waits_for_data)
+{
+    colite::io::EpollReactor reactor;
+    pipe_fds pipe;
+    ASSERT_GE(pipe.read_, 0);
+
+    std::string received;
+    auto task = [](colite::io::EpollReactor &reactor, int fd, std::string &received) -> detail::task {
+        std::array<char, 64> buffer{};
+        for (;;) {
+            auto read = ::read(fd, buffer.data(), buffer.size());
+            if (read > 0) {
+                received.append(buffer.data(), read);
+                continue;
+            }
+            if (read < 0 && errno == EAGAIN) {
+                EXPECT_TRUE((co_await reactor.readable(fd)).has_value());
+                continue;
+            }
+            break;
+        }
+    }(reactor, pipe.read_, received);
+    task.start_on(reactor.executor());
+    reactor.poll();
+    EXPECT_FALSE(task.is_done());
+
+    ASSERT_EQ(::write(pipe.write_, "abc", 3), 3);
+    reactor.run_once();
+    EXPECT_EQ(received, "abc");
+    EXPECT_FALSE(task.is_done());
+
+    ::close(pipe.write_);
+    pipe.write_ = -1;
+    run_until_done(reactor, task);
+    EXPECT_EQ(received, "abc");
+}
+
+TEST(epoll, readiness_is_kept_until_awaited)
+{
+    colite::io::EpollReactor reactor;
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    auto wait_for = [](colite::io::EpollReactor &reactor, int fd, bool read, bool &done) -> detail::task {
+        auto ready = read ? co_await reactor.readable(fd) : co_await reactor.writable(fd);
+        EXPECT_TRUE(ready.has_value());
+        done = true;
+    };
+    // Registers the descriptor.
+    bool writable = false;
+    auto first = wait_for(reactor, fds[0], false, writable);
+    first.start_on(reactor.executor());
+    run_until_done(reactor, first);
+    EXPECT_TRUE(writable);
+
+    // The edge arrives while no one waits for it.
+    ASSERT_EQ(::send(fds[1], "x", 1, 0), 1);
+    reactor.poll();
+
+    bool readable = false;
+    auto second = wait_for(reactor, fds[0], true, readable);
+    second.start_on(reactor.executor());
+    run_until_done(reactor, second);
+    EXPECT_TRUE(readable);
+    reactor.deregister(fds[0]);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(epoll, writable_completes_for_empty_pipe)
+{
+    colite::io::EpollReactor reactor;
+    pipe_fds pipe;
+    ASSERT_GE(pipe.write_, 0);
+
+    std::optional<bool> ok;
+    auto task = [](colite::io::EpollReactor &reactor, int fd, std::optional<bool> &ok) -> detail::task {
+        ok = (co_await reactor.writable(fd)).has_value();
+    }(reactor, pipe.write_, ok);
+    task.start_on(reactor.executor());
+    run_until_done(reactor, task);
+    EXPECT_EQ(ok, true);
+}
+
+TEST(epoll, unsupported_descriptors_are_reported)
+{
+    colite::io::EpollReactor reactor;
+    std::optional<std::error_code> error;
+    auto task = [](colite::io::EpollReactor &reactor, std::optional<std::error_code> &error) -> detail::task {
+        error = (co_await reactor.readable(-1)).error();
+    }(reactor, error);
+    task.start_on(reactor.executor());
+    run_until_done(reactor, task);
+    EXPECT_EQ(error, std::error_code(EBADF, std::system_category()));
+}
+
+TEST(epoll, socket_pair_ping_pong)
+{
+    colite::io::EpollReactor reactor(4);
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    constexpr int rounds = 100;
+    auto side = [](colite::io::EpollReactor &reactor, int fd, bool starts) -> detail::task {
+        char value = 0;
+        for (int i = 0; i < rounds; i++) {
+            if (starts || i > 0) {
+                while (::send(fd, &value, 1, MSG_NOSIGNAL) != 1) {
+                    co_await reactor.writable(fd);
+                }
+            }
+            while (::recv(fd, &value, 1, 0) != 1) {
+                if (!co_await reactor.readable(fd)) {
+                    co_return;
+                }
+            }
+            value++;
+        }
+        reactor.deregister(fd);
+    };
+    auto a = side(reactor, fds[0], true);
+    auto b = side(reactor, fds[1], false);
+    a.start_on(reactor.executor());
+    b.start_on(reactor.executor());
+    run_until_done(reactor, b);
+    // a waits for a reply to its last message.
+    EXPECT_FALSE(a.is_done());
+    reactor.deregister(fds[0]);
+    run_until_done(reactor, a);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(epoll, deregister_cancels_waiters)
+{
+    colite::io::EpollReactor reactor;
+    pipe_fds pipe;
+    ASSERT_GE(pipe.read_, 0);
+
+    std::optional<std::error_code> error;
+    auto task = [](colite::io::EpollReactor &reactor, int fd, std::optional<std::error_code> &error) -> detail::task {
+        error = (co_await reactor.readable(fd)).error();
+    }(reactor, pipe.read_, error);
+    task.start_on(reactor.executor());
+    reactor.poll();
+    EXPECT_FALSE(task.is_done());
+
+    reactor.deregister(pipe.read_);
+    run_until_done(reactor, task);
+    EXPECT_EQ(error, std::make_error_code(std::errc::operation_canceled));
+}
+
+TEST(epoll, destroying_a_waiting_coroutine_unlinks_it)
+{
+    colite::io::EpollReactor reactor;
+    pipe_fds pipe;
+    ASSERT_GE(pipe.read_, 0);
+
+    {
+        auto task = [](colite::io::EpollReactor &reactor, int fd) -> detail::task {
+            co_await reactor.readable(fd);
+        }(reactor, pipe.read_);
+        task.start_on(reactor.executor());
+        reactor.poll();
+        EXPECT_FALSE(task.is_done());
+    }
+    ASSERT_EQ(::write(pipe.write_, "x", 1), 1);
+    reactor.poll();
+}
+
+TEST(epoll, remote_posts_wake_the_loop)
+{
+    colite::io::EpollReactor reactor;
+    auto exec = reactor.executor();
+    constexpr int posts = 1000;
+    int count = 0;
+    std::thread poster([&] {
+        for (int i = 0; i < posts; i++) {
+            colite::executor::execute(exec, [&] { count++; });
+        }
+        colite::executor::execute(exec, [&] { reactor.stop(); });
+    });
+    reactor.run();
+    poster.join();
+    EXPECT_EQ(count, posts);
+}
+
+TEST(epoll, throwing_posted_function_leaves_the_rest_for_later)
+{
+    colite::io::EpollReactor reactor;
+    auto exec = reactor.executor();
+    int thrown = 0;
+    int ran = 0;
+    colite::executor::execute(exec, [&] {
+        thrown++;
+        throw std::runtime_error("posted");
+    });
+    colite::executor::execute(exec, [&] { ran++; });
+
+    EXPECT_THROW(reactor.poll(), std::runtime_error);
+    EXPECT_EQ(ran, 0);
+    // The function after the one that threw runs in the next round, and the one that threw doesn't run again.
+    reactor.poll();
+    EXPECT_EQ(thrown, 1);
+    EXPECT_EQ(ran, 1);
+}
@@ -0,0 +1,68 @@
+#include <colite/expected.hpp>
+#include <colite/sync/broadcast.hpp>
+#include <colite/sync/channel.hpp>
+#include <colite/sync/mutex.hpp>
+#include <colite/sync/watch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace
+{
+    // Results that are returned on every send and receive should be passed in registers, which needs a trivially
+    // copyable type of at most two words.
+    template<class T>
+    constexpr bool fits_in_registers = std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void *);
+
+    static_assert(fits_in_registers<colite::Expected<void, colite::mpmc::SendError>>);
+    static_assert(fits_in_registers<colite::Expected<std::int64_t, colite::mpmc::ReceiveError>>);
+    static_assert(fits_in_registers<colite::Expected<int *, colite::mpmc::TryReceiveError>>);
+    static_assert(fits_in_registers<colite::Expected<void, colite::broadcast::SendError>>);
+    static_assert(fits_in_registers<colite::Expected<std::int64_t, colite::broadcast::ReceiveError>>);
+    static_assert(fits_in_registers<colite::Expected<std::int64_t, colite::watch::ReceiveError>>);
+
+    // The error enums are a byte, so small values pack with their error.
+    static_assert(sizeof(colite::Expected<void, colite::mpmc::SendError>) == 2);
+    static_assert(sizeof(colite::Expected<std::int32_t, colite::mpmc::ReceiveError>) == 8);
+    static_assert(sizeof(colite::Expected<bool, colite::sync::LockError>) == 2);
+
+    static_assert(!std::is_trivially_copyable_v<colite::Expected<std::string, colite::mpmc::ReceiveError>>);
+}
+
+TEST(expected, trivially_copyable_results_keep_their_state)
+{
+    colite::Expected<std::int64_t, colite::mpmc::ReceiveError> value = 42;
+    colite::Expected<std::int64_t, colite::mpmc::ReceiveError> error = colite::Unexpected(colite::mpmc::ReceiveError::TimedOut);
+
+    auto value_copy = value;
+    auto error_copy = error;
+    value_copy = error;
+    error_copy = value;
+    EXPECT_EQ(error_copy.value(), 42);
+    EXPECT_EQ(value_copy.error(), colite::mpmc::ReceiveError::TimedOut);
+
+    colite::Expected<void, colite::mpmc::SendError> sent;
+    EXPECT_TRUE(sent.has_value());
+    sent = colite::Unexpected(colite::mpmc::SendError::Full);
+    EXPECT_EQ(sent.error(), colite::mpmc::SendError::Full);
+}
+
+TEST(expected, monadic_operations)
+{
+    using Result = colite::Expected<std::int64_t, colite::mpmc::ReceiveError>;
+    Result value = 20;
+    Result error = colite::Unexpected(colite::mpmc::ReceiveError::Closed);
+
+    auto doubled = value.and_then([](std::int64_t v) -> Result { return v * 2; }).transform([](std::int64_t v) { return std::to_string(v); });
+    EXPECT_EQ(doubled.value(), "40");
+
+    auto described = error.transform([](std::int64_t v) { return v + 1; }).transform_error([](colite::mpmc::ReceiveError) { return std::string("closed"); });
+    EXPECT_EQ(described.error(), "closed");
+    EXPECT_EQ(error.or_else([](colite::mpmc::ReceiveError) -> Result { return 0; }).value(), 0);
+    EXPECT_EQ(error.value_or(-1), -1);
+    EXPECT_EQ(error, colite::Unexpected(colite::mpmc::ReceiveError::Closed));
+    EXPECT_EQ(value, 20);
+}
@@ -0,0 +1,445 @@
+#include <gtest/gtest.h>
+
+#include "task.hpp"
+#include "folly_exec.hpp"
+
+#include <colite/executor/executor.hpp>
+#include <colite/instrument.hpp>
+#include <colite/sync/channel.hpp>
+#include <colite/sync/mutex.hpp>
+#include <colite/sync/select.hpp>
+#include <colite/task/yield.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef COLITE_INSTRUMENT
+namespace
+{
+    std::atomic<std::uint64_t> heap_allocations{0};
+    // Allocations made by `queue_executor` to queue functions, which no primitive counts.
+    std::atomic<std::uint64_t> executor_allocations{0};
+
+    // Heap allocations made since construction, leaving out the ones of `queue_executor`.
+    class heap_meter
+    {
+        std::uint64_t start_ = heap_allocations - executor_allocations;
+
+    public:
+        [[nodiscard]] std::uint64_t count() const noexcept {
+            return heap_allocations - executor_allocations - start_;
+        }
+    };
+
+    // Queues functions like `tests::manual_executor`, keeping its own allocations apart.
+    class queue_executor
+    {
+        std::shared_ptr<std::vector<std::function<void()>>> queue_ = std::make_shared<std::vector<std::function<void()>>>();
+
+    public:
+        void execute(std::invocable auto fn) const {
+            auto before = heap_allocations.load();
+            queue_->emplace_back(std::move(fn));
+            executor_allocations += heap_allocations - before;
+        }
+
+        void run() {
+            while (!queue_->empty()) {
+                auto batch = std::exchange(*queue_, {});
+                for (auto &fn : batch) {
+                    fn();
+                }
+            }
+        }
+
+        friend bool operator==(const queue_executor &lhs, const queue_executor &rhs) noexcept {
+            return lhs.queue_ == rhs.queue_;
+        }
+    };
+}
+
+void *operator new(std::size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    auto alignment = static_cast<std::size_t>(align);
+    auto rounded = (size + alignment - 1) / alignment * alignment;
+    if (auto *ptr = std::aligned_alloc(alignment, rounded ? rounded : alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return ::operator new(size, align);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+TEST(instrument, disabled_counters_are_empty)
+{
+    if constexpr (colite::instrument::enabled) {
+        GTEST_SKIP() << "COLITE_INSTRUMENT is defined";
+    }
+    else {
+        EXPECT_TRUE(std::is_empty_v<colite::instrument::Counters>);
+
+        colite::sync::Mutex<int> mutex(0);
+        auto snapshot = mutex.instrumentation();
+        EXPECT_EQ(snapshot.allocations, 0);
+        EXPECT_EQ(snapshot.executor_posts, 0);
+        EXPECT_EQ(snapshot.spurious_wakeups, 0);
+        EXPECT_EQ(snapshot.requeues, 0);
+    }
+}
+
+TEST(instrument, mutex_hand_off_has_no_spurious_wakeups)
+{
+    if constexpr (!colite::instrument::enabled) {
+        GTEST_SKIP() << "COLITE_INSTRUMENT is not defined";
+    }
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto lock_and_yield = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        co_await colite::task::yield(exec);
+    };
+    auto task1 = lock_and_yield(mutex, exec);
+    auto task2 = lock_and_yield(mutex, exec);
+    task1.start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+
+    // Each unlock hands the Mutex to the next waiter, nobody is woken just to find it locked.
+    lock->unlock();
+    for(int i = 0; i < 10; i++) {
+        exec.run();
+    }
+    EXPECT_TRUE(task1.is_done());
+    EXPECT_TRUE(task2.is_done());
+
+    auto snapshot = mutex.instrumentation();
+    // 2 waiters with executors and 2 posted wakeups with executor and handler.
+    EXPECT_EQ(snapshot.allocations, 8);
+    EXPECT_EQ(snapshot.executor_posts, 2);
+    EXPECT_EQ(snapshot.spurious_wakeups, 0);
+    EXPECT_EQ(snapshot.requeues, 0);
+}
+
+TEST(instrument, channel_counts_spurious_wakeups)
+{
+    if constexpr (!colite::instrument::enabled) {
+        GTEST_SKIP() << "COLITE_INSTRUMENT is not defined";
+    }
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+
+    auto receive = [](colite::mpmc::Receiver<int> receiver, tests::manual_executor exec) -> detail::task {
+        co_await receiver.receive(exec);
+    };
+    auto task1 = receive(channel.receiver, exec);
+    auto task2 = receive(channel.receiver, exec);
+    task1.start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+
+    // Both receivers are woken for a single value, one of them goes back to waiting.
+    ASSERT_TRUE(channel.sender.try_send(1).has_value());
+    exec.run();
+    EXPECT_NE(task1.is_done(), task2.is_done());
+
+    auto snapshot = channel.receiver.instrumentation();
+    auto queue_allocations = colite::mpmc::channel<int>().receiver.instrumentation().allocations;
+    // Channel state and queue, 2 receivers with executors, a wakeup list and 2 posted wakeups with executor and handler.
+    EXPECT_EQ(snapshot.allocations, queue_allocations + 9);
+    EXPECT_EQ(snapshot.executor_posts, 2);
+    EXPECT_EQ(snapshot.spurious_wakeups, 1);
+    EXPECT_EQ(snapshot.requeues, 1);
+    EXPECT_EQ(channel.sender.instrumentation().allocations, snapshot.allocations);
+}
+
+TEST(instrument, mutex_statistics)
+{
+    if constexpr (!colite::instrument::enabled) {
+        GTEST_SKIP() << "COLITE_INSTRUMENT is not defined";
+    }
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto lock_and_yield = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        co_await colite::task::yield(exec);
+    };
+    auto task1 = lock_and_yield(mutex, exec);
+    auto task2 = lock_and_yield(mutex, exec);
+    task1.start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+
+    lock->unlock();
+    for(int i = 0; i < 10; i++) {
+        exec.run();
+    }
+    ASSERT_TRUE(task1.is_done());
+    ASSERT_TRUE(task2.is_done());
+
+    auto stats = mutex.statistics();
+    EXPECT_EQ(stats.acquisitions, 3);
+    EXPECT_EQ(stats.contended_acquisitions, 2);
+    EXPECT_GE(stats.total_wait_ns, stats.max_wait_ns);
+    EXPECT_GT(stats.max_wait_ns, 0);
+    EXPECT_EQ(stats.max_queue_depth, 2);
+    EXPECT_EQ(stats.spurious_wakeups, 0);
+
+    std::uint64_t releases = 0;
+    for(auto count: stats.hold_time_histogram) {
+        releases += count;
+    }
+    EXPECT_EQ(releases, 3);
+}
+
+TEST(instrument, channel_for_each_allocates_once)
+{
+    if constexpr (!colite::instrument::enabled) {
+        GTEST_SKIP() << "COLITE_INSTRUMENT is not defined";
+    }
+    tests::manual_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+    for(int i = 0; i < 100; i++) {
+        ASSERT_TRUE(channel.sender.try_send(i).has_value());
+    }
+    auto queued = channel.receiver.instrumentation().allocations;
+
+    int received = 0;
+    auto consume = [](colite::mpmc::Receiver<int> receiver, tests::manual_executor exec, int &received) -> detail::task {
+        co_await colite::mpmc::for_each(exec, std::move(receiver), [&](int) {
+            received++;
+        });
+    };
+    auto task = consume(channel.receiver, exec, received);
+    task.start_on(exec);
+    exec.run();
+    channel.sender.close();
+    exec.run();
+    ASSERT_TRUE(task.is_done());
+    EXPECT_EQ(received, 100);
+
+    // The batch the loop takes all queued values into grows like any vector.
+    std::uint64_t batch_allocations = 0;
+    std::vector<int> batch;
+    for(int i = 0; i < 100; i++) {
+        if(batch.size() == batch.capacity()) {
+            batch_allocations++;
+        }
+        batch.push_back(i);
+    }
+    // The one receiver with its executor, its batch, and a wakeup list and posted wakeup when the channel is closed,
+    // nothing per value received.
+    EXPECT_EQ(channel.receiver.instrumentation().allocations - queued, 5 + batch_allocations);
+}
+
+#ifdef COLITE_INSTRUMENT
+TEST(instrument, channel_allocations_match_operator_new)
+{
+    queue_executor exec;
+    colite::executor::AnyExecutor any_exec = exec;
+
+    heap_meter created;
+    auto channel = colite::mpmc::channel<int>();
+    EXPECT_EQ(channel.receiver.instrumentation().allocations, created.count());
+
+    auto receive = [](colite::mpmc::Receiver<int> receiver, queue_executor exec) -> detail::task {
+        co_await receiver.receive(exec);
+    };
+    auto receive_any = [](colite::mpmc::Receiver<int> receiver, colite::executor::AnyExecutor exec) -> detail::task {
+        co_await receiver.receive(std::move(exec));
+    };
+    auto task1 = receive(channel.receiver, exec);
+    auto task2 = receive_any(channel.receiver, any_exec);
+
+    auto before = channel.receiver.instrumentation().allocations;
+    heap_meter meter;
+    task1.start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+    auto sent = channel.sender.try_send(1);
+    exec.run();
+    auto counted = channel.receiver.instrumentation().allocations - before;
+    auto allocated = meter.count();
+
+    ASSERT_TRUE(sent.has_value());
+    EXPECT_NE(task1.is_done(), task2.is_done());
+    EXPECT_EQ(counted, allocated);
+}
+
+TEST(instrument, channel_queue_allocations_match_operator_new)
+{
+    queue_executor exec;
+    auto channel = colite::mpmc::channel<int>();
+
+    int received = 0;
+    auto consume = [](colite::mpmc::Receiver<int> receiver, queue_executor exec, int &received) -> detail::task {
+        co_await colite::mpmc::for_each(exec, std::move(receiver), [&](int) {
+            received++;
+        });
+    };
+    auto task = consume(std::move(channel.receiver), exec, received);
+
+    // Enough values for the deque and the batch of for_each to grow several times.
+    auto before = channel.sender.instrumentation().allocations;
+    heap_meter meter;
+    for (int i = 0; i < 1000; i++) {
+        (void) channel.sender.try_send(i);
+    }
+    task.start_on(exec);
+    exec.run();
+    channel.sender.close();
+    exec.run();
+    auto counted = channel.sender.instrumentation().allocations - before;
+    auto allocated = meter.count();
+
+    ASSERT_TRUE(task.is_done());
+    EXPECT_EQ(received, 1000);
+    EXPECT_EQ(counted, allocated);
+}
+
+TEST(instrument, lock_free_channel_allocations_match_operator_new)
+{
+    queue_executor exec;
+
+    heap_meter created;
+    auto channel = colite::mpmc::channel<int, colite::mpmc::LockFree>(2);
+    EXPECT_EQ(channel.receiver.instrumentation().allocations, created.count());
+
+    auto receive = [](colite::mpmc::Receiver<int, colite::mpmc::LockFree> receiver, queue_executor exec) -> detail::task {
+        co_await receiver.receive(exec);
+    };
+    auto send = [](colite::mpmc::Sender<int, colite::mpmc::LockFree> sender, queue_executor exec) -> detail::task {
+        for (int i = 0; i < 4; i++) {
+            co_await sender.send(exec, i);
+        }
+    };
+    auto receiver_task = receive(channel.receiver, exec);
+    auto sender_task = send(channel.sender, exec);
+
+    auto before = channel.receiver.instrumentation().allocations;
+    heap_meter meter;
+    receiver_task.start_on(exec);
+    exec.run();
+    sender_task.start_on(exec);
+    exec.run();
+    auto counted = channel.receiver.instrumentation().allocations - before;
+    auto allocated = meter.count();
+
+    EXPECT_TRUE(receiver_task.is_done());
+    EXPECT_EQ(counted, allocated);
+}
+
+TEST(instrument, select_allocations_match_operator_new)
+{
+    queue_executor exec;
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+
+    auto select = [](colite::mpmc::Receiver<int> first, colite::mpmc::Receiver<int> second, queue_executor exec) -> detail::task {
+        co_await colite::select(exec, first.receive_op(), second.receive_op());
+    };
+    auto task = select(first.receiver, second.receiver, exec);
+
+    auto before = first.receiver.instrumentation().allocations + second.receiver.instrumentation().allocations;
+    heap_meter meter;
+    task.start_on(exec);
+    exec.run();
+    auto sent = second.sender.try_send(1);
+    exec.run();
+    auto counted = first.receiver.instrumentation().allocations + second.receiver.instrumentation().allocations - before;
+    auto allocated = meter.count();
+
+    ASSERT_TRUE(sent.has_value());
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(counted, allocated);
+}
+
+TEST(instrument, mutex_allocations_match_operator_new)
+{
+    queue_executor exec;
+    colite::executor::AnyExecutor any_exec = exec;
+    colite::sync::Mutex<int> mutex(0);
+    auto guard = mutex.try_lock();
+
+    auto lock = [](colite::sync::Mutex<int> &mutex, queue_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+    };
+    auto lock_any = [](colite::sync::Mutex<int> &mutex, colite::executor::AnyExecutor exec) -> detail::task {
+        auto guard = co_await mutex.lock(std::move(exec));
+    };
+    auto task1 = lock(mutex, exec);
+    auto task2 = lock_any(mutex, any_exec);
+
+    heap_meter meter;
+    task1.start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+    guard->unlock();
+    exec.run();
+    auto counted = mutex.instrumentation().allocations;
+    auto allocated = meter.count();
+
+    EXPECT_TRUE(task1.is_done());
+    EXPECT_TRUE(task2.is_done());
+    EXPECT_EQ(counted, allocated);
+}
+#endif
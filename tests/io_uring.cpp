@@ -0,0 +1,290 @@
+#include <colite/io/uring.hpp>
+
+#include <gtest/gtest.h>
+
+#include "task.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::optional<colite::io::UringContext> make_context(unsigned entries = 64) {
+        try {
+            return std::optional<colite::io::UringContext>(std::in_place, entries);
+        } catch (const std::system_error &) {
+            // io_uring is disabled in some sandboxes and containers.
+            return std::nullopt;
+        }
+    }
+
+    struct temp_file
+    {
+        std::string path_;
+        int fd_;
+
+        temp_file() {
+            // Prefer tmpfs, so the test doesn't depend on the disk.
+            auto dir = std::filesystem::exists("/dev/shm") ? std::filesystem::path("/dev/shm") : std::filesystem::temp_directory_path();
+            path_ = (dir / "colite-io-XXXXXX").string();
+            fd_ = ::mkstemp(path_.data());
+        }
+        ~temp_file() {
+            ::close(fd_);
+            ::unlink(path_.c_str());
+        }
+    };
+
+    struct listener
+    {
+        int fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address_{};
+
+        listener() {
+            address_.sin_family = AF_INET;
+            address_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ::bind(fd_, reinterpret_cast<sockaddr *>(&address_), sizeof(address_));
+            socklen_t length = sizeof(address_);
+            ::getsockname(fd_, reinterpret_cast<sockaddr *>(&address_), &length);
+            ::listen(fd_, 16);
+        }
+        ~listener() {
+            ::close(fd_);
+        }
+    };
+
+    std::span<const std::byte> bytes(const std::string &str) {
+        return std::as_bytes(std::span(str));
+    }
+
+    void run_until_done(colite::io::UringContext &context, const detail::task &task) {
+        while (!task.is_done()) {
+            context.run_once();
+        }
+    }
+}
+
+#define COLITE_MAKE_CONTEXT(name, ...) \
+    auto name = make_context(__VA_ARGS__); \
+    if (!name) { \
+        GTEST_SKIP() << "io_uring is not available"; \
+    }
+
+TEST(io_uring, executor_runs_posted_functions)
+{
+    COLITE_MAKE_CONTEXT(context);
+    auto exec = context->executor();
+    static_assert(colite::executor::Executor<decltype(exec)>);
+
+    int local = 0;
+    std::thread::id ran_on;
+    colite::executor::execute(exec, [&] {
+        ran_on = std::this_thread::get_id();
+        // Posted from the loop thread, runs in the next round.
+        colite::executor::execute(exec, [&] { local++; });
+    });
+    std::thread poster([&] {
+        colite::executor::execute(exec, [&] { context->stop(); });
+    });
+    context->run();
+    poster.join();
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+    while (context->poll() > 0) {
+    }
+    EXPECT_EQ(local, 1);
+}
+
+TEST(io_uring, file_write_read_fsync)
+{
+    COLITE_MAKE_CONTEXT(context);
+    temp_file file;
+    ASSERT_GE(file.fd_, 0);
+
+    std::string read_back;
+    auto task = [](colite::io::UringContext &context, int fd, std::string &read_back) -> detail::task {
+        std::string text = "hello uring";
+        auto written = co_await context.write(fd, bytes(text), 0);
+        EXPECT_EQ(written.value(), text.size());
+        EXPECT_TRUE((co_await context.fsync(fd)).has_value());
+
+        std::array<std::byte, 64> buffer{};
+        auto read = co_await context.read(fd, buffer, 0);
+        read_back.assign(reinterpret_cast<const char *>(buffer.data()), read.value());
+        // Reading past the end of the file gives 0.
+        EXPECT_EQ((co_await context.read(fd, buffer, text.size())).value(), 0);
+    }(*context, file.fd_, read_back);
+    task.start_on(context->executor());
+    run_until_done(*context, task);
+    EXPECT_EQ(read_back, "hello uring");
+}
+
+TEST(io_uring, errors_are_reported)
+{
+    COLITE_MAKE_CONTEXT(context);
+    std::optional<std::error_code> error;
+    auto task = [](colite::io::UringContext &context, std::optional<std::error_code> &error) -> detail::task {
+        std::array<std::byte, 8> buffer{};
+        error = (co_await context.read(-1, buffer)).error();
+    }(*context, error);
+    task.start_on(context->executor());
+    run_until_done(*context, task);
+    EXPECT_EQ(error, std::error_code(EBADF, std::system_category()));
+}
+
+TEST(io_uring, registered_buffers)
+{
+    COLITE_MAKE_CONTEXT(context);
+    temp_file file;
+    ASSERT_GE(file.fd_, 0);
+
+    std::array<std::byte, 4096> storage{};
+    std::array<iovec, 1> registered{iovec{storage.data(), storage.size()}};
+    ASSERT_TRUE(context->register_buffers(registered).has_value());
+
+    bool matches = false;
+    auto task = [](colite::io::UringContext &context, int fd, std::array<std::byte, 4096> &storage, bool &matches) -> detail::task {
+        auto out = std::span(storage).first(16);
+        for (std::size_t i = 0; i < out.size(); i++) {
+            out[i] = static_cast<std::byte>(i);
+        }
+        EXPECT_EQ((co_await context.write_fixed(fd, out, 0, 0)).value(), 16);
+        auto in = std::span(storage).subspan(1024, 16);
+        EXPECT_EQ((co_await context.read_fixed(fd, in, 0, 0)).value(), 16);
+        matches = std::equal(out.begin(), out.end(), in.begin());
+    }(*context, file.fd_, storage, matches);
+    task.start_on(context->executor());
+    run_until_done(*context, task);
+    EXPECT_TRUE(matches);
+    EXPECT_TRUE(context->unregister_buffers().has_value());
+}
+
+TEST(io_uring, loopback_sockets)
+{
+    COLITE_MAKE_CONTEXT(context);
+    listener server;
+    ASSERT_GE(server.fd_, 0);
+
+    std::string received;
+    auto serve = [](colite::io::UringContext &context, int listen_fd, std::string &received) -> detail::task {
+        auto client = co_await context.accept(listen_fd);
+        EXPECT_TRUE(client.has_value());
+        std::array<std::byte, 64> buffer{};
+        for (;;) {
+            auto read = co_await context.recv(*client, buffer);
+            if (!read || *read == 0) {
+                break;
+            }
+            received.append(reinterpret_cast<const char *>(buffer.data()), *read);
+        }
+        ::close(*client);
+    }(*context, server.fd_, received);
+
+    auto connect = [](colite::io::UringContext &context, sockaddr_in address) -> detail::task {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        EXPECT_TRUE((co_await context.connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address))).has_value());
+        std::string text = "ping";
+        EXPECT_EQ((co_await context.send(fd, bytes(text))).value(), text.size());
+        ::close(fd);
+    }(*context, server.address_);
+
+    serve.start_on(context->executor());
+    connect.start_on(context->executor());
+    run_until_done(*context, serve);
+    EXPECT_TRUE(connect.is_done());
+    EXPECT_EQ(received, "ping");
+}
+
+TEST(io_uring, more_operations_than_ring_entries)
+{
+    // A ring with 4 entries, every operation beyond that forces a submission to make room.
+    COLITE_MAKE_CONTEXT(context, 4);
+    temp_file file;
+    ASSERT_GE(file.fd_, 0);
+
+    constexpr int operations = 32;
+    int completed = 0;
+    std::vector<detail::task> tasks;
+    for (int i = 0; i < operations; i++) {
+        tasks.push_back([](colite::io::UringContext &context, int fd, int i, int &completed) -> detail::task {
+            auto value = static_cast<std::byte>(i);
+            auto written = co_await context.write(fd, std::span(&value, 1), static_cast<std::uint64_t>(i));
+            EXPECT_EQ(written.value(), 1);
+            completed++;
+        }(*context, file.fd_, i, completed));
+        tasks.back().start_on(context->executor());
+    }
+    while (completed < operations) {
+        context->run_once();
+    }
+
+    std::array<std::byte, operations> contents{};
+    ASSERT_EQ(::pread(file.fd_, contents.data(), contents.size(), 0), operations);
+    for (int i = 0; i < operations; i++) {
+        EXPECT_EQ(contents[i], static_cast<std::byte>(i));
+    }
+}
+
+TEST(io_uring, resubmitting_from_completions_on_a_full_ring)
+{
+    // Every completion resumes a task that submits its next write right away, while the ring is still full with
+    // the writes of the other tasks.
+    COLITE_MAKE_CONTEXT(context, 4);
+    temp_file file;
+    ASSERT_GE(file.fd_, 0);
+
+    constexpr int tasks_count = 64;
+    constexpr int writes = 4;
+    int completed = 0;
+    std::vector<detail::task> tasks;
+    for (int i = 0; i < tasks_count; i++) {
+        tasks.push_back([](colite::io::UringContext &context, int fd, int i, int &completed) -> detail::task {
+            for (int j = 0; j < writes; j++) {
+                auto value = static_cast<std::byte>(i * writes + j);
+                auto offset = static_cast<std::uint64_t>(i * writes + j);
+                auto written = co_await context.write(fd, std::span(&value, 1), offset);
+                EXPECT_EQ(written.value(), 1);
+            }
+            completed++;
+        }(*context, file.fd_, i, completed));
+        tasks.back().start_on(context->executor());
+    }
+    while (completed < tasks_count) {
+        context->run_once();
+    }
+
+    std::array<std::byte, tasks_count * writes> contents{};
+    ASSERT_EQ(::pread(file.fd_, contents.data(), contents.size(), 0), tasks_count * writes);
+    for (int i = 0; i < tasks_count * writes; i++) {
+        EXPECT_EQ(contents[i], static_cast<std::byte>(i));
+    }
+}
+
+TEST(io_uring, destroying_a_pending_operation_cancels_it)
+{
+    COLITE_MAKE_CONTEXT(context);
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_CLOEXEC), 0);
+
+    {
+        auto task = [](colite::io::UringContext &context, int fd) -> detail::task {
+            std::array<std::byte, 8> buffer{};
+            co_await context.read(fd, buffer);
+        }(*context, fds[0]);
+        task.start_on(context->executor());
+        context->poll();
+        EXPECT_FALSE(task.is_done());
+    }
+    // The cancellation completes without resuming the destroyed coroutine.
+    context->poll();
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include "task.hpp"
+#include "folly_exec.hpp"
+
+#include <colite/sync/keyed_mutex.hpp>
+#include <colite/task/yield.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST(keyed_mutex, same_key_is_exclusive)
+{
+    tests::manual_executor exec;
+
+    colite::sync::KeyedMutex<std::string> mutex;
+    auto lock = mutex.try_lock("alice");
+    ASSERT_TRUE(lock.has_value());
+    EXPECT_FALSE(mutex.try_lock("alice").has_value());
+
+    bool locked = false;
+    auto task = [](colite::sync::KeyedMutex<std::string> &mutex, tests::manual_executor exec, bool &locked) -> detail::task {
+        auto guard = co_await mutex.lock(exec, "alice");
+        locked = true;
+    }(mutex, exec, locked);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_FALSE(locked);
+
+    lock->unlock();
+    for(int i = 0; i < 10; i++) {
+        exec.run();
+    }
+    EXPECT_TRUE(locked);
+    EXPECT_TRUE(task.is_done());
+    EXPECT_TRUE(mutex.try_lock("alice").has_value());
+}
+
+TEST(keyed_mutex, different_stripes_are_independent)
+{
+    colite::sync::StripedMutex<8> mutex;
+    static_assert(alignof(decltype(mutex)) >= colite::detail::cache_line_size);
+    static_assert(sizeof(mutex) >= 8 * colite::detail::cache_line_size);
+
+    std::vector<colite::sync::StripedMutex<8>::Guard> guards;
+    std::size_t hash = 0;
+    // Any 8 hashes on different stripes can be locked at the same time.
+    for(std::size_t stripe = 0; stripe < mutex.size(); stripe++) {
+        while(mutex.stripe(hash) != stripe) {
+            hash++;
+        }
+        auto guard = mutex.try_lock(hash);
+        ASSERT_TRUE(guard.has_value());
+        guards.push_back(std::move(*guard));
+    }
+    EXPECT_FALSE(mutex.try_lock(hash + 1).has_value());
+}
+
+TEST(keyed_mutex, integer_keys_spread_over_stripes)
+{
+    colite::sync::KeyedMutex<std::size_t, 16> mutex;
+    std::vector<int> used(16);
+    // Multiples of the stripe count would all share stripe 0 without mixing the hash.
+    for(std::size_t key = 0; key < 16 * 64; key += 16) {
+        used[mutex.stripe(key)]++;
+    }
+    for(auto count : used) {
+        EXPECT_GT(count, 0);
+    }
+}
+
+TEST(keyed_mutex, lock_many_locks_each_stripe_once)
+{
+    tests::manual_executor exec;
+
+    colite::sync::KeyedMutex<int, 4> mutex;
+    std::size_t held = 0;
+    auto task = [](colite::sync::KeyedMutex<int, 4> &mutex, tests::manual_executor exec, std::size_t &held) -> detail::task {
+        // 10 keys over 4 stripes, keys sharing a stripe must not deadlock on themselves.
+        auto guards = co_await mutex.lock_many(exec, std::array{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        held = guards.size();
+        EXPECT_FALSE(mutex.try_lock(3).has_value());
+    }(mutex, exec, held);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(held, 4);
+    // All stripes are unlocked again.
+    for(int key = 0; key < 10; key++) {
+        EXPECT_TRUE(mutex.try_lock(key).has_value());
+    }
+}
+
+TEST(keyed_mutex, lock_many_in_opposite_orders_does_not_deadlock)
+{
+    tests::manual_executor exec;
+
+    colite::sync::KeyedMutex<int> mutex;
+    ASSERT_NE(mutex.stripe(1), mutex.stripe(2));
+    // Hold one of the keys so both tasks have to wait halfway.
+    auto lock = mutex.try_lock(2);
+
+    auto transfer = [](colite::sync::KeyedMutex<int> &mutex, tests::manual_executor exec, std::vector<int> keys, std::vector<int> &order, int id) -> detail::task {
+        auto guards = co_await mutex.lock_many(exec, keys);
+        order.push_back(id);
+        co_await colite::task::yield(exec);
+    };
+    std::vector<int> order;
+    auto task1 = transfer(mutex, exec, {1, 2}, order, 1);
+    auto task2 = transfer(mutex, exec, {2, 1}, order, 2);
+    task1.start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+
+    lock->unlock();
+    for(int i = 0; i < 20; i++) {
+        exec.run();
+    }
+    EXPECT_TRUE(task1.is_done());
+    EXPECT_TRUE(task2.is_done());
+    EXPECT_EQ(order.size(), 2);
+}
+
+TEST(keyed_mutex, destroyed_lock_many_releases_its_stripes)
+{
+    tests::manual_executor exec;
+
+    colite::sync::KeyedMutex<int> mutex;
+    // Stripes are locked in ascending order, hold the later one so the task waits with the first one locked.
+    int first = 1;
+    int last = 2;
+    if(mutex.stripe(first) > mutex.stripe(last)) {
+        std::swap(first, last);
+    }
+    ASSERT_NE(mutex.stripe(first), mutex.stripe(last));
+    auto lock = mutex.try_lock(last);
+
+    auto task = std::make_unique<detail::task>([](colite::sync::KeyedMutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guards = co_await mutex.lock_many(exec, std::array{1, 2});
+    }(mutex, exec));
+    task->start_on(exec);
+    exec.run();
+    EXPECT_FALSE(task->is_done());
+    EXPECT_FALSE(mutex.try_lock(first).has_value());
+
+    task.reset();
+    EXPECT_TRUE(mutex.try_lock(first).has_value());
+    lock->unlock();
+    EXPECT_TRUE(mutex.try_lock(last).has_value());
+}
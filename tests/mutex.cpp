@@ -5,6 +5,12 @@
 
 #include <colite/sync/mutex.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
 TEST(mutex, lock1)
 {
     tests::manual_executor exec;
@@ -115,4 +121,353 @@ TEST(mutex, destroy_while_awaiting)
     EXPECT_FALSE(task1->is_done());
     task1.reset();
     lock->unlock();
-}
\ No newline at end of file
+}
+TEST(mutex, lock_cancelled)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+    ASSERT_TRUE(lock.has_value());
+
+    std::stop_source stop;
+    std::optional<colite::sync::LockError> error;
+    auto waiter = [&]() -> detail::task {
+        auto result = co_await mutex.lock(exec, stop.get_token());
+        if(!result) {
+            error = result.error();
+        }
+    };
+    auto task = waiter();
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    stop.request_stop();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(error, colite::sync::LockError::Cancelled);
+
+    // The cancelled waiter is gone, unlocking doesn't wake anything.
+    lock->unlock();
+    EXPECT_EQ(exec.run(), 0);
+    EXPECT_TRUE(mutex.try_lock().has_value());
+}
+
+TEST(mutex, lock_with_stop_token_succeeds)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+    ASSERT_TRUE(lock.has_value());
+
+    std::stop_source stop;
+    int value_stored = 0;
+    auto waiter = [&]() -> detail::task {
+        auto result = co_await mutex.lock(exec, stop.get_token());
+        value_stored = **result;
+    };
+    auto task = waiter();
+    task.start_on(exec);
+    exec.run();
+
+    **lock = 5;
+    lock->unlock();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(value_stored, 5);
+
+    // Stopping after the lock was acquired has no effect.
+    stop.request_stop();
+    EXPECT_EQ(exec.run(), 0);
+}
+
+TEST(mutex, lock_timeout)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(std::chrono::milliseconds(1), start);
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+    ASSERT_TRUE(lock.has_value());
+
+    std::optional<colite::sync::LockError> error;
+    auto waiter = [&]() -> detail::task {
+        auto result = co_await mutex.lock_until(timers, exec, start + std::chrono::milliseconds(10));
+        if(!result) {
+            error = result.error();
+        }
+    };
+    auto task = waiter();
+    task.start_on(exec);
+    exec.run();
+    EXPECT_EQ(timers.pending(), 1);
+
+    timers.advance(start + std::chrono::milliseconds(10));
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(error, colite::sync::LockError::TimedOut);
+}
+
+TEST(mutex, destroyed_waiter_is_unlinked)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto task1 = std::make_unique<detail::task>([](colite::sync::Mutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        co_await mutex.lock(exec);
+    }(mutex, exec));
+    task1->start_on(exec);
+    exec.run();
+
+    task1.reset();
+    lock->unlock();
+    // Nothing left to wake up
+    EXPECT_EQ(exec.run(), 0);
+}
+
+TEST(mutex, unlock_hands_off_to_the_first_waiter)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto task = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        *guard = 1;
+    }(mutex, exec);
+    task.start_on(exec);
+    exec.run();
+
+    lock->unlock();
+    // The Mutex already belongs to the woken waiter, so it can't be taken before the waiter runs.
+    EXPECT_FALSE(mutex.try_lock().has_value());
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(**mutex.try_lock(), 1);
+}
+
+TEST(mutex, higher_priority_waiters_go_first)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<std::vector<int>> mutex({});
+    auto lock = mutex.try_lock();
+
+    auto lock_with_priority = [](colite::sync::Mutex<std::vector<int>> &mutex, tests::manual_executor exec, int id, int priority) -> detail::task {
+        auto guard = co_await mutex.lock(exec, priority);
+        guard->push_back(id);
+    };
+    std::vector<detail::task> tasks;
+    tasks.push_back(lock_with_priority(mutex, exec, 1, 0));
+    tasks.push_back(lock_with_priority(mutex, exec, 2, 10));
+    tasks.push_back(lock_with_priority(mutex, exec, 3, 5));
+    tasks.push_back(lock_with_priority(mutex, exec, 4, 10));
+    tasks.push_back(lock_with_priority(mutex, exec, 5, -1));
+    for(auto &task: tasks) {
+        task.start_on(exec);
+    }
+    exec.run();
+
+    lock->unlock();
+    for(int i = 0; i < 10; i++) {
+        exec.run();
+    }
+    EXPECT_EQ(**mutex.try_lock(), (std::vector<int>{2, 4, 3, 1, 5}));
+}
+
+TEST(mutex, cancellable_and_timed_waiters_keep_their_priority)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(std::chrono::milliseconds(1), start);
+
+    colite::sync::Mutex<std::vector<int>> mutex({});
+    auto lock = mutex.try_lock();
+
+    std::stop_source stop;
+    auto plain = [](colite::sync::Mutex<std::vector<int>> &mutex, tests::manual_executor exec, int id) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        guard->push_back(id);
+    };
+    auto cancellable = [](colite::sync::Mutex<std::vector<int>> &mutex, tests::manual_executor exec, std::stop_token token, int id, int priority) -> detail::task {
+        auto guard = co_await mutex.lock(exec, token, priority);
+        (*guard)->push_back(id);
+    };
+    auto timed = [](colite::sync::Mutex<std::vector<int>> &mutex, colite::timer::TimerService &timers, tests::manual_executor exec, colite::timer::clock::time_point deadline, int id, int priority) -> detail::task {
+        auto guard = co_await mutex.lock_until(timers, exec, deadline, {}, priority);
+        (*guard)->push_back(id);
+    };
+    std::vector<detail::task> tasks;
+    tasks.push_back(plain(mutex, exec, 1));
+    tasks.push_back(cancellable(mutex, exec, stop.get_token(), 2, 5));
+    tasks.push_back(timed(mutex, timers, exec, start + std::chrono::hours(1), 3, 10));
+    for(auto &task: tasks) {
+        task.start_on(exec);
+    }
+    exec.run();
+
+    lock->unlock();
+    for(int i = 0; i < 10; i++) {
+        exec.run();
+    }
+    EXPECT_EQ(**mutex.try_lock(), (std::vector<int>{3, 2, 1}));
+}
+
+TEST(mutex, abandoned_hand_off_passes_the_lock_on)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto lock_and_store = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec, int value) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        *guard = value;
+    };
+    auto task1 = std::make_unique<detail::task>(lock_and_store(mutex, exec, 1));
+    auto task2 = lock_and_store(mutex, exec, 2);
+    task1->start_on(exec);
+    task2.start_on(exec);
+    exec.run();
+
+    // The Mutex is handed to the first waiter, which is destroyed before it gets to run.
+    lock->unlock();
+    task1.reset();
+    for(int i = 0; i < 10; i++) {
+        exec.run();
+    }
+    EXPECT_TRUE(task2.is_done());
+    EXPECT_EQ(**mutex.try_lock(), 2);
+}
+
+TEST(mutex, barging_lock_is_taken_before_the_woken_waiter_runs)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int, colite::sync::Barging> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto task = [](colite::sync::Mutex<int, colite::sync::Barging> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        *guard = 1;
+    }(mutex, exec);
+    task.start_on(exec);
+    exec.run();
+
+    lock->unlock();
+    auto barging = mutex.try_lock();
+    ASSERT_TRUE(barging.has_value());
+    // The waiter finds the Mutex taken and goes back to the queue.
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+
+    barging->unlock();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(**mutex.try_lock(), 1);
+}
+
+TEST(mutex, adaptive_hands_off_to_a_starving_waiter)
+{
+    tests::manual_executor exec;
+
+    // Any waiter that loses the lock to a barging task is starving.
+    using Policy = colite::sync::Adaptive<0>;
+    colite::sync::Mutex<int, Policy> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto task = [](colite::sync::Mutex<int, Policy> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        *guard = 1;
+    }(mutex, exec);
+    task.start_on(exec);
+    exec.run();
+
+    // Barging while nobody is starving.
+    lock->unlock();
+    auto barging = mutex.try_lock();
+    ASSERT_TRUE(barging.has_value());
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+
+    // The waiter is starving now, so the next unlock hands off.
+    barging->unlock();
+    EXPECT_FALSE(mutex.try_lock().has_value());
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+
+    // Back to barging once the starving waiter had the lock.
+    EXPECT_EQ(**mutex.try_lock(), 1);
+}
+
+namespace
+{
+    // Locks and unlocks the Mutex a few times so its average hold time is about `hold`.
+    template<class T>
+    void hold_repeatedly(colite::sync::Mutex<T> &mutex, std::chrono::milliseconds hold) {
+        for(int i = 0; i < 16; i++) {
+            auto lock = mutex.try_lock();
+            std::this_thread::sleep_for(hold);
+        }
+    }
+}
+
+TEST(mutex, spinning_lock_takes_a_lock_released_by_another_thread)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0, std::chrono::seconds(1));
+    hold_repeatedly(mutex, std::chrono::milliseconds(5));
+
+    std::atomic<bool> locking = false;
+    auto lock = mutex.try_lock();
+    std::thread unlocker([&locking, lock = std::move(*lock)]() mutable {
+        while(!locking) {
+            std::this_thread::yield();
+        }
+        lock.unlock();
+    });
+
+    auto task = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec, std::atomic<bool> &locking) -> detail::task {
+        locking = true;
+        auto guard = co_await mutex.lock(exec);
+        *guard = 1;
+    }(mutex, exec, locking);
+    task.start_on(exec);
+    // Spinning takes the lock without parking, so nothing is posted to resume the task.
+    exec.run();
+    unlocker.join();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(**mutex.try_lock(), 1);
+    if constexpr (colite::instrument::enabled) {
+        EXPECT_EQ(mutex.statistics().spin_acquisitions, 1);
+    }
+}
+
+TEST(mutex, no_spinning_while_the_lock_is_held_longer_than_max_spin)
+{
+    tests::manual_executor exec;
+
+    colite::sync::Mutex<int> mutex(0, std::chrono::microseconds(100));
+    hold_repeatedly(mutex, std::chrono::milliseconds(5));
+
+    auto lock = mutex.try_lock();
+    auto task = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        auto guard = co_await mutex.lock(exec);
+        *guard = 1;
+    }(mutex, exec);
+    task.start_on(exec);
+    exec.run();
+    EXPECT_FALSE(task.is_done());
+
+    lock->unlock();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(**mutex.try_lock(), 1);
+}
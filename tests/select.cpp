@@ -0,0 +1,225 @@
+#include <colite/sync/select.hpp>
+
+#include <gtest/gtest.h>
+
+#include "folly_exec.hpp"
+#include "task.hpp"
+
+#include <chrono>
+#include <optional>
+#include <stop_token>
+#include <string>
+
+TEST(select, immediately_ready)
+{
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<std::string>();
+
+    ASSERT_TRUE(second.sender.try_send("Hello").has_value());
+
+    std::size_t index = 99;
+    std::string value;
+    auto selector = [&]() -> detail::task {
+        auto result = co_await colite::select(colite::executor::ImmediateExecutor{}, first.receiver.receive_op(), second.receiver.receive_op());
+        index = result.index();
+        value = std::get<1>(result).value();
+    };
+    auto task = selector();
+    task.start_on(colite::executor::ImmediateExecutor{});
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(index, 1);
+    EXPECT_EQ(value, "Hello");
+}
+
+TEST(select, first_ready_wins)
+{
+    tests::manual_executor exec;
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+
+    std::size_t index = 99;
+    int value = 0;
+    auto selector = [&]() -> detail::task {
+        auto result = co_await colite::select(exec, first.receiver.receive_op(), second.receiver.receive_op());
+        index = result.index();
+        value = std::get<0>(result).value();
+    };
+    auto task = selector();
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    ASSERT_TRUE(first.sender.try_send(10).has_value());
+    ASSERT_TRUE(second.sender.try_send(20).has_value());
+    exec.run();
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(index, 0);
+    EXPECT_EQ(value, 10);
+    // The losing channel keeps its value
+    EXPECT_EQ(second.receiver.try_receive().value(), 20);
+    EXPECT_EQ(first.receiver.try_receive().error(), colite::mpmc::TryReceiveError::Empty);
+}
+
+TEST(select, closed_channel)
+{
+    tests::manual_executor exec;
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+    std::optional<colite::mpmc::Sender<int>> wrapped_sender(std::move(second.sender));
+
+    std::size_t index = 99;
+    bool closed = false;
+    auto selector = [&]() -> detail::task {
+        auto result = co_await colite::select(exec, first.receiver.receive_op(), second.receiver.receive_op());
+        index = result.index();
+        closed = !std::get<1>(result).has_value();
+    };
+    auto task = selector();
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    wrapped_sender.reset();
+    exec.run();
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(index, 1);
+    EXPECT_TRUE(closed);
+}
+
+TEST(select, deregisters_from_other_channels)
+{
+    tests::manual_executor exec;
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+
+    int received = 0;
+    auto selector = [&]() -> detail::task {
+        co_await colite::select(exec, first.receiver.receive_op(), second.receiver.receive_op());
+        // A plain receive on the losing channel must get the next value
+        received = (co_await second.receiver.receive(exec)).value();
+    };
+    auto task = selector();
+    task.start_on(exec);
+    exec.run();
+
+    ASSERT_TRUE(first.sender.try_send(1).has_value());
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    ASSERT_TRUE(second.sender.try_send(2).has_value());
+    exec.run();
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(received, 2);
+}
+
+TEST(select, destroy_task_while_waiting)
+{
+    tests::manual_executor exec;
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+
+    auto select_task = std::make_unique<detail::task>([](colite::mpmc::Receiver<int> rx1, colite::mpmc::Receiver<int> rx2, tests::manual_executor exec) -> detail::task {
+        co_await colite::select(exec, rx1.receive_op(), rx2.receive_op());
+    }(first.receiver, second.receiver, exec));
+
+    select_task->start_on(exec);
+    EXPECT_EQ(exec.run(), 1);
+
+    ASSERT_TRUE(first.sender.try_send(1).has_value());
+    select_task.reset();
+    EXPECT_EQ(exec.run(), 1);
+    EXPECT_EQ(first.receiver.try_receive().value(), 1);
+}
+
+TEST(select, timeout_consumes_nothing)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(std::chrono::milliseconds(1), start);
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+
+    std::optional<colite::mpmc::ReceiveError> error;
+    auto selector = [&]() -> detail::task {
+        auto result = co_await colite::select_until(timers, exec, start + std::chrono::milliseconds(5), first.receiver.receive_op(), second.receiver.receive_op());
+        error = result.error();
+    };
+    auto task = selector();
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+    EXPECT_EQ(first.receiver.metrics().parked_receivers, 1);
+
+    timers.advance(start + std::chrono::milliseconds(5));
+    // Sent after the deadline but before the select is resumed, neither value may be taken.
+    ASSERT_TRUE(first.sender.try_send(1).has_value());
+    ASSERT_TRUE(second.sender.try_send(2).has_value());
+    exec.run();
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(error, colite::mpmc::ReceiveError::TimedOut);
+    EXPECT_EQ(first.receiver.metrics().parked_receivers, 0);
+    EXPECT_EQ(second.receiver.metrics().parked_receivers, 0);
+    EXPECT_EQ(first.receiver.try_receive().value(), 1);
+    EXPECT_EQ(second.receiver.try_receive().value(), 2);
+}
+
+TEST(select, ready_before_the_deadline)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(std::chrono::milliseconds(1), start);
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+
+    int value = 0;
+    auto selector = [&]() -> detail::task {
+        auto result = co_await colite::select_until(timers, exec, start + std::chrono::milliseconds(5), first.receiver.receive_op(), second.receiver.receive_op());
+        value = std::get<1>(result.value()).value();
+    };
+    auto task = selector();
+    task.start_on(exec);
+    exec.run();
+
+    ASSERT_TRUE(second.sender.try_send(2).has_value());
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(value, 2);
+    EXPECT_EQ(timers.pending(), 0);
+}
+
+TEST(select, cancelled_with_stop_token)
+{
+    tests::manual_executor exec;
+    auto first = colite::mpmc::channel<int>();
+    auto second = colite::mpmc::channel<int>();
+    std::stop_source stop;
+
+    std::optional<colite::mpmc::ReceiveError> error;
+    auto selector = [&]() -> detail::task {
+        auto result = co_await colite::select(exec, stop.get_token(), first.receiver.receive_op(), second.receiver.receive_op());
+        error = result.error();
+    };
+    auto task = selector();
+    task.start_on(exec);
+    exec.run();
+    ASSERT_FALSE(task.is_done());
+
+    stop.request_stop();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(error, colite::mpmc::ReceiveError::Cancelled);
+    EXPECT_EQ(first.receiver.metrics().parked_receivers, 0);
+
+    // Already stopped, gives up without suspending.
+    error.reset();
+    auto again = selector();
+    again.start_on(exec);
+    exec.run();
+    EXPECT_TRUE(again.is_done());
+    EXPECT_EQ(error, colite::mpmc::ReceiveError::Cancelled);
+}
@@ -0,0 +1,172 @@
+#include <colite/timer/timer.hpp>
+
+#include <gtest/gtest.h>
+
+#include "folly_exec.hpp"
+#include "task.hpp"
+
+#include <atomic>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct counting_node final : colite::timer::detail::timer_node {
+        int *fired_;
+        explicit counting_node(int *fired) : fired_(fired) {}
+        void fire() override {
+            (*fired_)++;
+        }
+    };
+}
+
+TEST(timer, sleep_until)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(1ms, start);
+
+    bool after_sleep = false;
+    auto sleeper = [&]() -> detail::task {
+        co_await colite::timer::sleep_until(timers, exec, start + 10ms);
+        after_sleep = true;
+    };
+    auto task = sleeper();
+    task.start_on(exec);
+    exec.run();
+    EXPECT_EQ(timers.pending(), 1);
+
+    EXPECT_EQ(timers.advance(start + 9ms), 0);
+    exec.run();
+    EXPECT_FALSE(after_sleep);
+
+    EXPECT_EQ(timers.advance(start + 10ms), 1);
+    EXPECT_FALSE(after_sleep);
+    exec.run();
+    EXPECT_TRUE(after_sleep);
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(timers.pending(), 0);
+}
+
+TEST(timer, deadline_in_the_past)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(1ms, start);
+    timers.advance(start + 5ms);
+
+    auto sleeper = [&]() -> detail::task {
+        co_await colite::timer::sleep_until(timers, exec, start + 1ms);
+    };
+    auto task = sleeper();
+    task.start_on(exec);
+    exec.run();
+    exec.run();
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(timer, fires_in_deadline_order_across_levels)
+{
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(1ms, start);
+
+    std::vector<int> fired(5, 0);
+    std::vector<std::shared_ptr<counting_node>> nodes;
+    const std::vector<std::chrono::milliseconds> deadlines{3ms, 64ms, 100ms, 4096ms, 300000ms};
+    for (std::size_t i = 0; i < deadlines.size(); i++) {
+        nodes.push_back(std::make_shared<counting_node>(&fired[i]));
+        timers.schedule(nodes.back(), start + deadlines[i]);
+    }
+    EXPECT_EQ(timers.pending(), 5);
+
+    for (std::size_t i = 0; i < deadlines.size(); i++) {
+        timers.advance(start + deadlines[i] - 1ms);
+        EXPECT_EQ(fired[i], 0) << i;
+        timers.advance(start + deadlines[i]);
+        EXPECT_EQ(fired[i], 1) << i;
+    }
+    EXPECT_EQ(timers.pending(), 0);
+}
+
+TEST(timer, cancel)
+{
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(1ms, start);
+
+    int fired = 0;
+    auto node = std::make_shared<counting_node>(&fired);
+    timers.schedule(node, start + 200ms);
+    EXPECT_TRUE(timers.cancel(*node));
+    EXPECT_FALSE(timers.cancel(*node));
+    EXPECT_EQ(timers.pending(), 0);
+    timers.advance(start + 1s);
+    EXPECT_EQ(fired, 0);
+}
+
+TEST(timer, destroy_task_while_sleeping)
+{
+    tests::manual_executor exec;
+    auto start = colite::timer::clock::now();
+    colite::timer::TimerService timers(1ms, start);
+
+    auto sleep_task = std::make_unique<detail::task>([](colite::timer::TimerService &timers, tests::manual_executor exec, colite::timer::clock::time_point deadline) -> detail::task {
+        co_await colite::timer::sleep_until(timers, exec, deadline);
+    }(timers, exec, start + 10ms));
+    sleep_task->start_on(exec);
+    EXPECT_EQ(exec.run(), 1);
+    EXPECT_EQ(timers.pending(), 1);
+
+    sleep_task.reset();
+    EXPECT_EQ(timers.pending(), 0);
+    EXPECT_EQ(timers.advance(start + 20ms), 0);
+    EXPECT_EQ(exec.run(), 0);
+}
+
+TEST(timer, dedicated_thread)
+{
+    colite::timer::TimerService timers;
+    timers.start();
+
+    std::atomic<bool> done = false;
+    auto sleeper = [&]() -> detail::task {
+        co_await colite::timer::sleep_for(timers, colite::executor::ImmediateExecutor{}, 5ms);
+        done = true;
+    };
+    auto task = sleeper();
+    task.start_on(colite::executor::ImmediateExecutor{});
+
+    for (int i = 0; i < 1000 && !done; i++) {
+        std::this_thread::sleep_for(1ms);
+    }
+    timers.stop();
+    EXPECT_TRUE(done);
+    EXPECT_TRUE(task.is_done());
+}
+
+TEST(timer, earlier_timer_wakes_the_thread)
+{
+    colite::timer::TimerService timers;
+    timers.start();
+
+    // The thread goes to sleep until this one is due.
+    int fired = 0;
+    auto distant = std::make_shared<counting_node>(&fired);
+    timers.schedule(distant, colite::timer::clock::now() + 1h);
+    std::this_thread::sleep_for(5ms);
+
+    std::atomic<bool> done = false;
+    auto sleeper = [&]() -> detail::task {
+        co_await colite::timer::sleep_for(timers, colite::executor::ImmediateExecutor{}, 5ms);
+        done = true;
+    };
+    auto task = sleeper();
+    task.start_on(colite::executor::ImmediateExecutor{});
+
+    for (int i = 0; i < 1000 && !done; i++) {
+        std::this_thread::sleep_for(1ms);
+    }
+    timers.stop();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(timers.pending(), 1);
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "task.hpp"
+#include "folly_exec.hpp"
+
+#include <colite/sync/mutex.hpp>
+#include <colite/task/yield.hpp>
+#include <colite/trace/chrome_trace.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    std::vector<colite::trace::Event> events_of(const colite::trace::ChromeTraceRecorder &recorder, const std::string &primitive) {
+        std::vector<colite::trace::Event> retval;
+        for(const auto &event: recorder.events()) {
+            if(event.primitive == primitive) {
+                retval.push_back(event);
+            }
+        }
+        return retval;
+    }
+}
+
+TEST(trace, mutex_events)
+{
+    if constexpr (!colite::trace::enabled) {
+        GTEST_SKIP() << "COLITE_TRACE is not defined";
+    }
+    colite::trace::ChromeTraceRecorder recorder;
+    colite::trace::set_tracer(&recorder);
+
+    tests::manual_executor exec;
+    colite::sync::Mutex<int> mutex(0);
+    auto lock = mutex.try_lock();
+
+    auto lock_once = [](colite::sync::Mutex<int> &mutex, tests::manual_executor exec) -> detail::task {
+        co_await mutex.lock(exec);
+    };
+    auto task = lock_once(mutex, exec);
+    task.start_on(exec);
+    exec.run();
+    lock->unlock();
+    exec.run();
+    ASSERT_TRUE(task.is_done());
+
+    colite::trace::set_tracer(nullptr);
+
+    auto events = events_of(recorder, "mutex");
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].phase, colite::trace::Phase::Suspend);
+    EXPECT_EQ(events[1].phase, colite::trace::Phase::Schedule);
+    EXPECT_EQ(events[2].phase, colite::trace::Phase::Resume);
+    for(const auto &event: events) {
+        EXPECT_EQ(event.instance, &mutex);
+        EXPECT_EQ(event.coroutine, events[0].coroutine);
+    }
+    EXPECT_LE(events[0].time, events[1].time);
+    EXPECT_LE(events[1].time, events[2].time);
+
+    std::ostringstream json;
+    recorder.write_json(json);
+    EXPECT_EQ(json.str().rfind("{\"traceEvents\":[", 0), 0);
+    EXPECT_NE(json.str().find("\"name\":\"mutex wait\""), std::string::npos);
+    EXPECT_NE(json.str().find("\"name\":\"mutex queued\""), std::string::npos);
+}
+
+TEST(trace, yield_events)
+{
+    if constexpr (!colite::trace::enabled) {
+        GTEST_SKIP() << "COLITE_TRACE is not defined";
+    }
+    colite::trace::ChromeTraceRecorder recorder;
+    colite::trace::set_tracer(&recorder);
+
+    tests::manual_executor exec;
+    auto yield_once = [](tests::manual_executor exec) -> detail::task {
+        co_await colite::task::yield(exec);
+    };
+    auto task = yield_once(exec);
+    task.start_on(exec);
+    exec.run();
+    exec.run();
+    ASSERT_TRUE(task.is_done());
+
+    colite::trace::set_tracer(nullptr);
+
+    auto events = events_of(recorder, "yield");
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].phase, colite::trace::Phase::Suspend);
+    EXPECT_EQ(events[1].phase, colite::trace::Phase::Schedule);
+    EXPECT_EQ(events[2].phase, colite::trace::Phase::Resume);
+}
+
+TEST(trace, no_events_without_tracer)
+{
+    colite::trace::ChromeTraceRecorder recorder;
+    tests::manual_executor exec;
+    auto yield_once = [](tests::manual_executor exec) -> detail::task {
+        co_await colite::task::yield(exec);
+    };
+    auto task = yield_once(exec);
+    task.start_on(exec);
+    exec.run();
+    exec.run();
+    EXPECT_TRUE(recorder.events().empty());
+
+    std::ostringstream json;
+    recorder.write_json(json);
+    EXPECT_EQ(json.str(), "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n");
+}
+
+TEST(trace, write_json_keeps_stream_formatting)
+{
+    colite::trace::ChromeTraceRecorder recorder;
+    int coroutine = 0;
+    auto now = std::chrono::steady_clock::now();
+    recorder.record({colite::trace::Phase::Suspend, "mutex", nullptr, &coroutine, now, std::this_thread::get_id()});
+    recorder.record({colite::trace::Phase::Schedule, "mutex", nullptr, &coroutine, now + std::chrono::microseconds(5), std::this_thread::get_id()});
+
+    std::ostringstream json;
+    json << std::hex << std::scientific << std::setprecision(1);
+    recorder.write_json(json);
+    EXPECT_NE(json.str().find("\"ts\":5.000,\"pid\":1,\"tid\":1,"), std::string::npos);
+
+    // The caller's formatting is back in place.
+    json.str("");
+    json << 255 << ' ' << 1.5;
+    EXPECT_EQ(json.str(), "ff 1.5e+00");
+}
@@ -0,0 +1,118 @@
+#include <colite/sync/watch.hpp>
+
+#include <gtest/gtest.h>
+
+#include "folly_exec.hpp"
+#include "task.hpp"
+
+#include <string>
+
+TEST(watch, borrow_latest_value)
+{
+    auto [sender, receiver] = colite::watch::channel<int>(1);
+
+    EXPECT_EQ(*receiver.borrow(), 1);
+    EXPECT_FALSE(receiver.has_changed());
+
+    ASSERT_TRUE(sender.send(2).has_value());
+    ASSERT_TRUE(sender.send(3).has_value());
+    EXPECT_TRUE(receiver.has_changed());
+    EXPECT_EQ(*receiver.borrow(), 3);
+    EXPECT_TRUE(receiver.has_changed());
+    EXPECT_EQ(*receiver.borrow_and_update(), 3);
+    EXPECT_FALSE(receiver.has_changed());
+}
+
+TEST(watch, borrow_non_trivial_value)
+{
+    auto [sender, receiver] = colite::watch::channel<std::string>("Hello");
+
+    ASSERT_TRUE(sender.send("Hello world").has_value());
+    auto value = receiver.borrow_and_update();
+    EXPECT_EQ(value->size(), 11);
+    EXPECT_EQ(*value, "Hello world");
+}
+
+TEST(watch, changed_wakes_receiver)
+{
+    tests::manual_executor exec;
+    auto [sender, receiver] = colite::watch::channel<int>(0);
+
+    std::vector<int> seen;
+    auto watcher = [&]() -> detail::task {
+        while (co_await receiver.changed(exec)) {
+            seen.push_back(*receiver.borrow());
+        }
+        seen.push_back(-1);
+    };
+    auto task = watcher();
+
+    task.start_on(exec);
+    exec.run();
+    EXPECT_TRUE(seen.empty());
+
+    ASSERT_TRUE(sender.send(1).has_value());
+    exec.run();
+    ASSERT_TRUE(sender.send(2).has_value());
+    ASSERT_TRUE(sender.send(3).has_value());
+    exec.run();
+
+    std::optional<colite::watch::Sender<int>> wrapped_sender(std::move(sender));
+    wrapped_sender.reset();
+    exec.run();
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_EQ(seen, (std::vector<int>{1, 3, -1}));
+}
+
+TEST(watch, unseen_change_before_close)
+{
+    auto [sender, receiver] = colite::watch::channel<int>(0);
+    std::optional<colite::watch::Sender<int>> wrapped_sender(std::move(sender));
+    ASSERT_TRUE(wrapped_sender->send(1).has_value());
+    wrapped_sender.reset();
+
+    bool changed = false;
+    bool closed = false;
+    auto watcher = [&]() -> detail::task {
+        changed = (co_await receiver.changed(colite::executor::ImmediateExecutor{})).has_value();
+        closed = !(co_await receiver.changed(colite::executor::ImmediateExecutor{})).has_value();
+    };
+    auto task = watcher();
+    task.start_on(colite::executor::ImmediateExecutor{});
+
+    EXPECT_TRUE(task.is_done());
+    EXPECT_TRUE(changed);
+    EXPECT_TRUE(closed);
+}
+
+TEST(watch, send_without_receivers)
+{
+    auto [sender, receiver] = colite::watch::channel<int>(0);
+    std::optional<colite::watch::Receiver<int>> wrapped_receiver(std::move(receiver));
+    wrapped_receiver.reset();
+
+    EXPECT_EQ(sender.send(1).error(), colite::watch::SendError::Closed);
+    auto new_receiver = sender.subscribe();
+    EXPECT_FALSE(new_receiver.has_changed());
+    EXPECT_EQ(*new_receiver.borrow(), 1);
+    EXPECT_TRUE(sender.send(2).has_value());
+    EXPECT_TRUE(new_receiver.has_changed());
+}
+
+TEST(watch, destroy_task_before_receiver_wakeup)
+{
+    tests::manual_executor exec;
+    auto [sender, receiver] = colite::watch::channel<int>(0);
+
+    auto watch_task = std::make_unique<detail::task>([](colite::watch::Receiver<int> recv, tests::manual_executor exec) -> detail::task {
+        co_await recv.changed(exec);
+    }(receiver, exec));
+
+    watch_task->start_on(exec);
+    EXPECT_EQ(exec.run(), 1);
+
+    ASSERT_TRUE(sender.send(1).has_value());
+    watch_task.reset();
+    EXPECT_EQ(exec.run(), 1);
+}